@@ -6,6 +6,15 @@
 
 #define CFG_LINE_LEN_MAX 510
 #define INITIAL_CAPACITY 62  // 62 H5VL_provenance methods in total
+#define CLOCK_SYNC_ROUNDS 8  // ping-pongs per rank, the one with the smallest round trip wins
+#define DEP_GRANULARITY 1    // elements per tracked block along each dimension
+#define DEP_MAX_ACCESSES 4096 // dataset access summaries kept per file and rank
+#define STAT_SHM_INTERVAL 1000 // ms between updates of the live statistics segment
+#define STAT_SERIES_INTERVAL 10000 // ms between rows of the statistics time series
+#define SKETCH_TOP_K 100     // objects kept by the heavy-hitter sketch
+#define EMBED_MAX_RECORDS 1048576 // records kept per file and rank for ENABLE_EMBED_PROV
+#define CONFIG_HASH_OFFSET 14695981039346656037UL
+#define CONFIG_HASH_PRIME 1099511628211UL
 
 
 /* Configuration parser */
@@ -18,8 +27,31 @@ void init_config(prov_config* params_out){
     (*params_out).new_graph_path = NULL;
     (*params_out).legacy_graph_path = NULL;
     (*params_out).prov_line_format = NULL;
+    (*params_out).shard_repo_path = NULL;
+    (*params_out).stat_series_path = NULL;
+    (*params_out).stat_record_path = NULL;
     (*params_out).enable_stat_file = 0;
     (*params_out).enable_legacy_graph = 0;
+    (*params_out).enable_shards = 0;
+    (*params_out).enable_clock_sync = 0;
+    (*params_out).clock_sync_rounds = CLOCK_SYNC_ROUNDS;
+    (*params_out).enable_dep_detect = 0;
+    (*params_out).enable_coll_skew = 0;
+    (*params_out).dep_granularity = DEP_GRANULARITY;
+    (*params_out).dep_max_accesses = DEP_MAX_ACCESSES;
+    (*params_out).enable_stat_shm = 0;
+    (*params_out).stat_shm_interval = STAT_SHM_INTERVAL;
+    (*params_out).enable_stat_series = 0;
+    (*params_out).enable_tsc_timer = 1;
+    (*params_out).enable_perf_counters = 0;
+    (*params_out).enable_sketches = 0;
+    (*params_out).sketch_top_k = SKETCH_TOP_K;
+    (*params_out).enable_summaries = 0;
+    (*params_out).enable_embed_prov = 0;
+    (*params_out).embed_max_records = EMBED_MAX_RECORDS;
+    (*params_out).stat_series_interval = STAT_SERIES_INTERVAL;
+    (*params_out).enable_stat_record = 0;
+    (*params_out).stat_record_binary = 0;
     (*params_out).enable_file_prov = 0;
     (*params_out).enable_group_prov = 0;
     (*params_out).enable_dataset_prov = 0;
@@ -33,6 +65,7 @@ void init_config(prov_config* params_out){
     (*params_out).enable_bdb = 0;
     (*params_out).num_of_apis = INITIAL_CAPACITY;
     (*params_out).prov_level = Default;
+    (*params_out).config_hash = CONFIG_HASH_OFFSET;
 }
 
 void free_config(prov_config* params_out) {
@@ -44,6 +77,9 @@ void free_config(prov_config* params_out) {
         free(params_out->new_graph_path);
         free(params_out->legacy_graph_path);
         free(params_out->prov_line_format);
+        free(params_out->shard_repo_path);
+        free(params_out->stat_series_path);
+        free(params_out->stat_record_path);
     }
 }
 
@@ -100,6 +136,27 @@ int _set_params(char *key, char *val_in, prov_config* params_in_out) {
         } else {
             (*params_in_out).legacy_graph_path = strdup(val);
         }
+    } else if(strcmp(key, "SHARD_REPO_PATH") == 0) {
+        if (strcmp(val, "") == 0){
+            printf("Blank shard repository path!\n");
+            return -1;
+        } else {
+            (*params_in_out).shard_repo_path = strdup(val);
+        }
+    } else if(strcmp(key, "STAT_SERIES_PATH") == 0) {
+        if (strcmp(val, "") == 0){
+            printf("Blank stat series path!\n");
+            return -1;
+        } else {
+            (*params_in_out).stat_series_path = strdup(val);
+        }
+    } else if(strcmp(key, "STAT_RECORD_PATH") == 0) {
+        if (strcmp(val, "") == 0){
+            printf("Blank stat record path!\n");
+            return -1;
+        } else {
+            (*params_in_out).stat_record_path = strdup(val);
+        }
     } else if(strcmp(key, "FORMAT") == 0) {
         if (strcmp(val, "") == 0){
             printf("Blank provenace format!\n");
@@ -126,6 +183,92 @@ int _set_params(char *key, char *val_in, prov_config* params_in_out) {
             (*params_in_out).enable_legacy_graph = 1;
         else
             (*params_in_out).enable_legacy_graph = 0;
+    } else if (strcmp(key, "ENABLE_SHARDS") == 0) {
+        if (val[0] == 'T' || val[0] == 't')
+            (*params_in_out).enable_shards = 1;
+        else
+            (*params_in_out).enable_shards = 0;
+    } else if (strcmp(key, "ENABLE_CLOCK_SYNC") == 0) {
+        if (val[0] == 'T' || val[0] == 't')
+            (*params_in_out).enable_clock_sync = 1;
+        else
+            (*params_in_out).enable_clock_sync = 0;
+    } else if (strcmp(key, "CLOCK_SYNC_ROUNDS") == 0) {
+        if (atoi(val) > 0)
+            (*params_in_out).clock_sync_rounds = atoi(val);
+    } else if (strcmp(key, "ENABLE_DEP_DETECT") == 0) {
+        if (val[0] == 'T' || val[0] == 't')
+            (*params_in_out).enable_dep_detect = 1;
+        else
+            (*params_in_out).enable_dep_detect = 0;
+    } else if (strcmp(key, "ENABLE_COLL_SKEW") == 0) {
+        if (val[0] == 'T' || val[0] == 't')
+            (*params_in_out).enable_coll_skew = 1;
+        else
+            (*params_in_out).enable_coll_skew = 0;
+    } else if (strcmp(key, "DEP_GRANULARITY") == 0) {
+        if (atoi(val) > 0)
+            (*params_in_out).dep_granularity = atoi(val);
+    } else if (strcmp(key, "DEP_MAX_ACCESSES") == 0) {
+        if (atoi(val) > 0)
+            (*params_in_out).dep_max_accesses = atoi(val);
+    } else if (strcmp(key, "ENABLE_STAT_SHM") == 0) {
+        if (val[0] == 'T' || val[0] == 't')
+            (*params_in_out).enable_stat_shm = 1;
+        else
+            (*params_in_out).enable_stat_shm = 0;
+    } else if (strcmp(key, "STAT_SHM_INTERVAL") == 0) {
+        if (atoi(val) > 0)
+            (*params_in_out).stat_shm_interval = atoi(val);
+    } else if (strcmp(key, "ENABLE_STAT_SERIES") == 0) {
+        if (val[0] == 'T' || val[0] == 't')
+            (*params_in_out).enable_stat_series = 1;
+        else
+            (*params_in_out).enable_stat_series = 0;
+    } else if (strcmp(key, "ENABLE_TSC_TIMER") == 0) {
+        if (val[0] == 'T' || val[0] == 't')
+            (*params_in_out).enable_tsc_timer = 1;
+        else
+            (*params_in_out).enable_tsc_timer = 0;
+    } else if (strcmp(key, "ENABLE_PERF_COUNTERS") == 0) {
+        if (val[0] == 'T' || val[0] == 't')
+            (*params_in_out).enable_perf_counters = 1;
+        else
+            (*params_in_out).enable_perf_counters = 0;
+    } else if (strcmp(key, "ENABLE_SKETCHES") == 0) {
+        if (val[0] == 'T' || val[0] == 't')
+            (*params_in_out).enable_sketches = 1;
+        else
+            (*params_in_out).enable_sketches = 0;
+    } else if (strcmp(key, "SKETCH_TOP_K") == 0) {
+        if (atoi(val) > 0)
+            (*params_in_out).sketch_top_k = atoi(val);
+    } else if (strcmp(key, "ENABLE_SUMMARIES") == 0) {
+        if (val[0] == 'T' || val[0] == 't')
+            (*params_in_out).enable_summaries = 1;
+        else
+            (*params_in_out).enable_summaries = 0;
+    } else if (strcmp(key, "ENABLE_EMBED_PROV") == 0) {
+        if (val[0] == 'T' || val[0] == 't')
+            (*params_in_out).enable_embed_prov = 1;
+        else
+            (*params_in_out).enable_embed_prov = 0;
+    } else if (strcmp(key, "EMBED_MAX_RECORDS") == 0) {
+        if (atoi(val) > 0)
+            (*params_in_out).embed_max_records = atoi(val);
+    } else if (strcmp(key, "STAT_SERIES_INTERVAL") == 0) {
+        if (atoi(val) > 0)
+            (*params_in_out).stat_series_interval = atoi(val);
+    } else if (strcmp(key, "ENABLE_STAT_RECORD") == 0) {
+        if (val[0] == 'T' || val[0] == 't')
+            (*params_in_out).enable_stat_record = 1;
+        else
+            (*params_in_out).enable_stat_record = 0;
+    } else if (strcmp(key, "STAT_RECORD_FORMAT") == 0) {
+        if (strcmp(val, "binary") == 0 || strcmp(val, "BINARY") == 0)
+            (*params_in_out).stat_record_binary = 1;
+        else
+            (*params_in_out).stat_record_binary = 0;
     }  else if (strcmp(key, "ENABLE_FILE") == 0) {
         if (val[0] == 'T' || val[0] == 't')
             (*params_in_out).enable_file_prov = 1;
@@ -191,6 +334,20 @@ int _set_params(char *key, char *val_in, prov_config* params_in_out) {
     return 1;
 }
 
+/* Runs with the same settings get the same hash, whatever their output files */
+static void config_hash_add(prov_config* params_out, const char* key, const char* val) {
+    unsigned long hash = params_out->config_hash;
+
+    if (strstr(key, "_PATH"))
+        return;
+    for (const char* p = key; *p; p++)
+        hash = (hash ^ (unsigned char)*p) * CONFIG_HASH_PRIME;
+    hash = (hash ^ '=') * CONFIG_HASH_PRIME;
+    for (const char* p = val; *p && *p != '*'; p++)   // same cut as _parse_val
+        hash = (hash ^ (unsigned char)*p) * CONFIG_HASH_PRIME;
+    params_out->config_hash = (hash ^ '\n') * CONFIG_HASH_PRIME;
+}
+
 int read_config(const char *file_path, prov_config *params_out) {
     char cfg_line[CFG_LINE_LEN_MAX] = "";
 
@@ -223,6 +380,7 @@ int read_config(const char *file_path, prov_config *params_out) {
                 return -1;
         } else 
             return -1; 
+        config_hash_add(params_out, tokens[0], tokens[1]);
         parsed = _set_params(tokens[0], tokens[1], params_out);
     }
     if (parsed < 0) 
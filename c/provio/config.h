@@ -27,8 +27,31 @@ typedef struct prov_config {
     char* new_graph_path;
     char* legacy_graph_path;
     char* prov_line_format;
+    char* shard_repo_path;
+    char* stat_series_path;
+    char* stat_record_path;
     int enable_stat_file;
     int enable_legacy_graph;
+    int enable_shards;
+    int enable_clock_sync;
+    int clock_sync_rounds;
+    int enable_dep_detect;
+    int enable_coll_skew;
+    int dep_granularity;
+    int dep_max_accesses;
+    int enable_stat_shm;
+    int stat_shm_interval;
+    int enable_stat_series;
+    int enable_tsc_timer;
+    int enable_perf_counters;
+    int enable_sketches;
+    int sketch_top_k;
+    int enable_summaries;
+    int enable_embed_prov;
+    int embed_max_records;
+    int stat_series_interval;
+    int enable_stat_record;
+    int stat_record_binary;     // STAT_RECORD_FORMAT=binary, JSON Lines otherwise
     int enable_file_prov;
     int enable_group_prov;
     int enable_dataset_prov;
@@ -42,6 +65,7 @@ typedef struct prov_config {
     int enable_bdb;
     int num_of_apis;      
     Prov_level prov_level;      
+    unsigned long config_hash;  // FNV-1a of the parsed settings, paths left out
 } prov_config;
 
 void init_config(prov_config* config);
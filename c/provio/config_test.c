@@ -36,6 +36,12 @@ int main() {
 	else
 		printf("legacy_graph_path is null\n");
 
+	if(config.shard_repo_path) {
+		printf("%s\n", config.shard_repo_path);
+	}
+	else
+		printf("shard_repo_path is null\n");
+
 	if(config.prov_line_format) {
 		printf("%s\n", config.prov_line_format);
 	}
@@ -0,0 +1,156 @@
+/* The packed legacy graph is private to provio.c, include it to reach
+ * legacy_graph_unpack() and legacy_graph_pack() */
+#include "provio.c"
+
+
+/* A version 1 buffer as rank 0 broadcasts it, written out field by field:
+ * header, string table of [u32 len][bytes], then kind/value/lang/datatype
+ * per node, three nodes per triple */
+typedef struct fixture {
+	unsigned char buf[4096];
+	size_t size;
+} fixture;
+
+static const char* fixture_strings[] = {
+	"http://example.org/file.h5/dset",              // 0
+	"http://www.w3.org/ns/prov#wasGeneratedBy",     // 1
+	"b1",                                           // 2
+	"42",                                           // 3
+	"http://www.w3.org/2001/XMLSchema#integer",     // 4
+	"temperature",                                  // 5
+	"en",                                           // 6
+	"http://www.w3.org/2000/01/rdf-schema#label"    // 7
+};
+#define FIXTURE_STRINGS 8
+
+static const uint32_t fixture_triples[][12] = {
+	// <dset> prov:wasGeneratedBy _:b1
+	{0, 0, 0xffffffffu, 0xffffffffu,  0, 1, 0xffffffffu, 0xffffffffu,  2, 2, 0xffffffffu, 0xffffffffu},
+	// <dset> rdfs:label "temperature"@en
+	{0, 0, 0xffffffffu, 0xffffffffu,  0, 7, 0xffffffffu, 0xffffffffu,  1, 5, 6, 0xffffffffu},
+	// _:b1 prov:wasGeneratedBy "42"^^xsd:integer
+	{2, 2, 0xffffffffu, 0xffffffffu,  0, 1, 0xffffffffu, 0xffffffffu,  1, 3, 0xffffffffu, 4}
+};
+#define FIXTURE_TRIPLES 3
+
+static void put_u32(fixture* f, uint32_t v) {
+	memcpy(f->buf + f->size, &v, sizeof(v));
+	f->size += sizeof(v);
+}
+
+static void fixture_build(fixture* f, uint32_t magic, uint32_t version) {
+	uint64_t strings_size = 0;
+
+	for(int i = 0; i < FIXTURE_STRINGS; i++)
+		strings_size += sizeof(uint32_t) + strlen(fixture_strings[i]);
+	f->size = 0;
+	put_u32(f, magic);
+	put_u32(f, version);
+	put_u32(f, FIXTURE_STRINGS);
+	put_u32(f, FIXTURE_TRIPLES);
+	memcpy(f->buf + f->size, &strings_size, sizeof(strings_size));
+	f->size += sizeof(strings_size);
+	for(int i = 0; i < FIXTURE_STRINGS; i++) {
+		put_u32(f, (uint32_t)strlen(fixture_strings[i]));
+		memcpy(f->buf + f->size, fixture_strings[i], strlen(fixture_strings[i]));
+		f->size += strlen(fixture_strings[i]);
+	}
+	for(int t = 0; t < FIXTURE_TRIPLES; t++)
+		for(int i = 0; i < 12; i++)
+			put_u32(f, fixture_triples[t][i]);
+}
+
+static librdf_node* uri(const char* str) {
+	return librdf_new_node_from_uri_string(world, (const unsigned char*)str);
+}
+
+static int contains(librdf_model* model, librdf_node* s, librdf_node* p, librdf_node* o) {
+	librdf_statement* st = librdf_new_statement_from_nodes(world, s, p, o);
+	int found = librdf_model_contains_statement(model, st);
+	librdf_free_statement(st);
+	return found;
+}
+
+static librdf_model* new_model(librdf_storage** storage) {
+	*storage = librdf_new_storage(world, "memory", NULL, NULL);
+	return librdf_new_model(world, *storage, NULL);
+}
+
+static void test_unpack_fields(librdf_model* model) {
+	fixture f;
+	librdf_uri* integer;
+
+	fixture_build(&f, LEGACY_PACK_MAGIC, 1);
+	assert(legacy_graph_unpack(model, f.buf, f.size) == FIXTURE_TRIPLES);
+	assert(librdf_model_size(model) == FIXTURE_TRIPLES);
+
+	// Every node comes back with its kind, language and datatype
+	assert(contains(model, uri(fixture_strings[0]), uri(fixture_strings[1]),
+		librdf_new_node_from_blank_identifier(world, (const unsigned char*)"b1")));
+	assert(contains(model, uri(fixture_strings[0]), uri(fixture_strings[7]),
+		librdf_new_node_from_literal(world, (const unsigned char*)"temperature", "en", 0)));
+	integer = librdf_new_uri(world, (const unsigned char*)fixture_strings[4]);
+	assert(contains(model,
+		librdf_new_node_from_blank_identifier(world, (const unsigned char*)"b1"),
+		uri(fixture_strings[1]),
+		librdf_new_node_from_typed_literal(world, (const unsigned char*)"42", NULL, integer)));
+	librdf_free_uri(integer);
+
+	// Same values without the language or datatype are other nodes
+	assert(!contains(model, uri(fixture_strings[0]), uri(fixture_strings[7]),
+		librdf_new_node_from_literal(world, (const unsigned char*)"temperature", NULL, 0)));
+}
+
+static void test_unpack_rejects() {
+	librdf_storage* storage;
+	librdf_model* model = new_model(&storage);
+	fixture f;
+
+	fixture_build(&f, LEGACY_PACK_MAGIC, 2);
+	assert(legacy_graph_unpack(model, f.buf, f.size) < 0);
+	fixture_build(&f, 0x12345678, 1);
+	assert(legacy_graph_unpack(model, f.buf, f.size) < 0);
+	fixture_build(&f, LEGACY_PACK_MAGIC, 1);
+	assert(legacy_graph_unpack(model, f.buf, f.size - 1) < 0);
+	assert(legacy_graph_unpack(model, f.buf, sizeof(legacy_pack_header) - 1) < 0);
+
+	// A triple naming a string past the table is skipped, not the others
+	fixture_build(&f, LEGACY_PACK_MAGIC, 1);
+	memcpy(f.buf + f.size - 11 * sizeof(uint32_t), &(uint32_t){FIXTURE_STRINGS}, sizeof(uint32_t));
+	assert(legacy_graph_unpack(model, f.buf, f.size) == FIXTURE_TRIPLES - 1);
+	librdf_free_model(model);
+	librdf_free_storage(storage);
+}
+
+/* What the current packer writes unpacks to the same graph */
+static void test_round_trip(librdf_model* model) {
+	librdf_storage* storage;
+	librdf_model* copy = new_model(&storage);
+	size_t size;
+	unsigned char* buf = legacy_graph_pack(model, &size);
+
+	assert(buf);
+	assert(legacy_graph_unpack(copy, buf, size) == librdf_model_size(model));
+	assert(librdf_model_size(copy) == librdf_model_size(model));
+	free(buf);
+	librdf_free_model(copy);
+	librdf_free_storage(storage);
+}
+
+int main() {
+	librdf_storage* storage;
+	librdf_model* model;
+
+	world = librdf_new_world();
+	librdf_world_open(world);
+	model = new_model(&storage);
+
+	test_unpack_fields(model);
+	test_unpack_rejects();
+	test_round_trip(model);
+
+	librdf_free_model(model);
+	librdf_free_storage(storage);
+	librdf_free_world(world);
+	return 0;
+}
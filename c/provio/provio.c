@@ -1,5 +1,7 @@
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
@@ -14,6 +16,7 @@
 
 #define DEFAULT_FUNCTION_PREFIX "H5VL_provenance_"
 #define LEGACY_PREFIX "file"
+#define SHARD_MANIFEST "MANIFEST"
 
 /* Global variables */
 // Process
@@ -29,19 +32,32 @@ int USER_TRACKED = 0;
 
 
 /* Helper functions */
-static void get_time_str(char *str_out);
+static void get_time_str(prov_fields* fields, char *str_out);
 static int get_mpi_rank(prov_fields* fields);
 static void alloc_proc_uuid(prov_fields* fields);
 static void alloc_api_uuid(prov_fields* fields);
 // static char* add_prefix();
 static void get_process_name_by_pid(prov_fields* fields, int pid);
-
-
-static void get_time_str(char *str_out){
+#ifdef LIBRDF_H
+static void load_legacy_graph(prov_config* config, prov_fields* fields);
+#endif
+static long clock_sync(prov_config* config, prov_fields* fields, unsigned long* sync_time);
+static int open_shard(prov_config* config, provio_helper_t* helper, prov_fields* fields);
+static void shard_note_file(provio_helper_t* helper, const char* file_name);
+static int append_shard_manifest(prov_config* config, provio_helper_t* helper,
+    prov_fields* fields, unsigned long end_time, int num_triples);
+static int sketch_init(int top_k);
+static void sketch_record(prov_fields* fields);
+static void sketch_reduce(prov_fields* fields);
+static void sketch_free(void);
+static void add_sketch_records(prov_config* config, provio_helper_t* helper_in, prov_fields* fields);
+
+
+static void get_time_str(prov_fields* fields, char *str_out){
     time_t rawtime;
     struct tm * timeinfo;
 
-    time ( &rawtime );
+    rawtime = (time_t)(provio_global_time(fields, get_time_usec()) / 1000000);
     timeinfo = localtime ( &rawtime );
 
     *str_out = '\0';
@@ -58,9 +74,65 @@ static int get_mpi_rank(prov_fields* fields) {
     MPI_Comm_rank(MPI_COMM_WORLD, &MPI_RANK); 
     MPI_Comm_size(MPI_COMM_WORLD, &NUM_OF_RANK);
     sprintf(fields->mpi_rank,"%d", MPI_RANK); 
+    fields->mpi_size = NUM_OF_RANK;
     return MPI_RANK;
 }
 
+/* Clock synchronization
+ *
+ * Estimate the offset of this rank's clock against rank 0 with a ping-pong:
+ * rank 0 answers each ping with its current time, the round trip is timed
+ * with stat_timer_ns() and the reply of the fastest round is assumed to be taken
+ * halfway through it. Rank 0 serves one rank at a time, so the cost is
+ * rounds * (ranks - 1) small messages.
+ */
+#define CLOCK_SYNC_TAG 7719
+
+static long clock_sync(prov_config* config, prov_fields* fields, unsigned long* sync_time) {
+    int num_of_rank;
+    long best_offset = 0;
+    unsigned long best_rtt = 0;
+
+    MPI_Comm_size(MPI_COMM_WORLD, &num_of_rank);
+    *sync_time = get_time_usec();
+    if (num_of_rank <= 1)
+        return 0;
+
+    if (fields->mpi_rank_int == 0) {
+        for (int peer = 1; peer < num_of_rank; peer++) {
+            for (int i = 0; i < config->clock_sync_rounds; i++) {
+                unsigned long now;
+                MPI_Recv(NULL, 0, MPI_BYTE, peer, CLOCK_SYNC_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                now = get_time_usec();
+                MPI_Send(&now, 1, MPI_UNSIGNED_LONG, peer, CLOCK_SYNC_TAG, MPI_COMM_WORLD);
+            }
+        }
+        return 0;
+    }
+
+    for (int i = 0; i < config->clock_sync_rounds; i++) {
+        unsigned long remote;
+        unsigned long w0 = stat_timer_ns();
+        unsigned long t0 = get_time_usec();
+        MPI_Send(NULL, 0, MPI_BYTE, 0, CLOCK_SYNC_TAG, MPI_COMM_WORLD);
+        MPI_Recv(&remote, 1, MPI_UNSIGNED_LONG, 0, CLOCK_SYNC_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        unsigned long rtt = stat_timer_ns() - w0;
+
+        if (i == 0 || rtt < best_rtt) {
+            best_rtt = rtt;
+            best_offset = (long)remote - (long)(t0 + rtt / 2000);
+            *sync_time = t0;
+        }
+    }
+    return best_offset;
+}
+
+/* Drift is only known at teardown, timestamps are written with the offset
+ * alone and tools correct them with the recorded drift afterwards */
+unsigned long provio_global_time(prov_fields* fields, unsigned long local_time) {
+    return (unsigned long)((long)local_time + fields->clock_offset);
+}
+
 /* Provenance helper methods */
 static void alloc_proc_uuid(prov_fields* fields) {
     uuid_t uuid;
@@ -72,6 +144,22 @@ static void alloc_proc_uuid(prov_fields* fields) {
     strcpy(fields->proc_uuid, uuid_); 
 }
 
+/* Rank 0 picks the run id, PROVIO_RUN_ID names the run instead of a UUID */
+static void alloc_run_id(prov_fields* fields) {
+    if (fields->mpi_rank_int == 0) {
+        const char* name = getenv("PROVIO_RUN_ID");
+        if (name && name[0]) {
+            snprintf(fields->run_id, sizeof(fields->run_id), "%s", name);
+        }
+        else {
+            uuid_t uuid;
+            uuid_generate_time_safe(uuid);
+            uuid_unparse_lower(uuid, fields->run_id);
+        }
+    }
+    MPI_Bcast(fields->run_id, sizeof(fields->run_id), MPI_CHAR, 0, MPI_COMM_WORLD);
+}
+
 static void alloc_api_uuid(prov_fields* fields) {
     uuid_t uuid;
     uuid_generate_time_safe(uuid);
@@ -108,6 +196,412 @@ static void get_process_name_by_pid(prov_fields* fields, int pid)
 }
 
 
+#ifdef LIBRDF_H
+/* Packed legacy graph
+ *
+ * Rank 0 parses the legacy Turtle file and flattens the model into a
+ * dictionary-encoded buffer: a string table holding every distinct URI,
+ * literal, language tag and blank id, followed by one fixed size record
+ * per triple that refers to the table by index. The buffer is broadcast
+ * once and the other ranks rebuild the model straight from it.
+ */
+#define LEGACY_PACK_MAGIC   0x50494f47      // "PIOG"
+#define LEGACY_PACK_VERSION 1
+#define LEGACY_PACK_NONE    0xffffffffu     // no language / datatype
+#define LEGACY_BCAST_CHUNK  (1 << 30)
+
+enum legacy_node_kind {
+    LEGACY_NODE_URI = 0,
+    LEGACY_NODE_LITERAL,
+    LEGACY_NODE_BLANK
+};
+
+typedef struct legacy_pack_node {
+    uint32_t kind;
+    uint32_t value;                 // string table index
+    uint32_t lang;                  // literals only
+    uint32_t datatype;              // literals only
+} legacy_pack_node;
+
+typedef struct legacy_pack_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_strings;
+    uint32_t num_triples;
+    uint64_t strings_size;          // bytes used by the string table
+} legacy_pack_header;
+
+typedef struct legacy_dict {
+    size_t* offsets;                // hash slots, string offset in pool
+    uint32_t* lens;
+    uint32_t* ids;                  // LEGACY_PACK_NONE marks an empty slot
+    size_t capacity;
+    uint32_t count;
+    unsigned char* pool;            // [u32 len][bytes] per distinct string
+    size_t pool_size;
+    size_t pool_capacity;
+} legacy_dict;
+
+static unsigned long legacy_hash(const unsigned char* str, size_t len) {
+    unsigned long hash = 5381;
+    for (size_t i = 0; i < len; i++)
+        hash = ((hash << 5) + hash) + str[i];
+    return hash;
+}
+
+static int legacy_dict_grow(legacy_dict* dict) {
+    size_t new_capacity = dict->capacity ? dict->capacity * 2 : 1024;
+    size_t* offsets = malloc(new_capacity * sizeof(*offsets));
+    uint32_t* lens = malloc(new_capacity * sizeof(*lens));
+    uint32_t* ids = malloc(new_capacity * sizeof(*ids));
+    if (!offsets || !lens || !ids) {
+        free(offsets);
+        free(lens);
+        free(ids);
+        return -1;
+    }
+    memset(ids, 0xff, new_capacity * sizeof(*ids));
+    for (size_t i = 0; i < dict->capacity; i++) {
+        if (dict->ids[i] == LEGACY_PACK_NONE)
+            continue;
+        size_t index = legacy_hash(dict->pool + dict->offsets[i], dict->lens[i]) & (new_capacity - 1);
+        while (ids[index] != LEGACY_PACK_NONE)
+            index = (index + 1) & (new_capacity - 1);
+        offsets[index] = dict->offsets[i];
+        lens[index] = dict->lens[i];
+        ids[index] = dict->ids[i];
+    }
+    free(dict->offsets);
+    free(dict->lens);
+    free(dict->ids);
+    dict->offsets = offsets;
+    dict->lens = lens;
+    dict->ids = ids;
+    dict->capacity = new_capacity;
+    return 0;
+}
+
+/* Return the string table index of str, adding it on first sight */
+static uint32_t legacy_dict_intern(legacy_dict* dict, const unsigned char* str, size_t len) {
+    if (!str)
+        return LEGACY_PACK_NONE;
+    if ((dict->count + 1) * 2 > dict->capacity && legacy_dict_grow(dict) < 0)
+        return LEGACY_PACK_NONE;
+
+    size_t index = legacy_hash(str, len) & (dict->capacity - 1);
+    while (dict->ids[index] != LEGACY_PACK_NONE) {
+        if (dict->lens[index] == len && !memcmp(dict->pool + dict->offsets[index], str, len))
+            return dict->ids[index];
+        index = (index + 1) & (dict->capacity - 1);
+    }
+
+    size_t need = dict->pool_size + sizeof(uint32_t) + len;
+    if (need > dict->pool_capacity) {
+        size_t new_capacity = dict->pool_capacity ? dict->pool_capacity : 4096;
+        while (new_capacity < need)
+            new_capacity *= 2;
+        unsigned char* pool = realloc(dict->pool, new_capacity);
+        if (!pool)
+            return LEGACY_PACK_NONE;
+        dict->pool = pool;
+        dict->pool_capacity = new_capacity;
+    }
+
+    uint32_t len32 = (uint32_t)len;
+    memcpy(dict->pool + dict->pool_size, &len32, sizeof(uint32_t));
+    memcpy(dict->pool + dict->pool_size + sizeof(uint32_t), str, len);
+
+    dict->offsets[index] = dict->pool_size + sizeof(uint32_t);
+    dict->lens[index] = len32;
+    dict->ids[index] = dict->count;
+    dict->pool_size = need;
+    return dict->count++;
+}
+
+static void legacy_dict_free(legacy_dict* dict) {
+    free(dict->offsets);
+    free(dict->lens);
+    free(dict->ids);
+    free(dict->pool);
+}
+
+static int legacy_pack_node_from(legacy_dict* dict, librdf_node* node, legacy_pack_node* out) {
+    size_t len;
+    unsigned char* str;
+
+    out->lang = LEGACY_PACK_NONE;
+    out->datatype = LEGACY_PACK_NONE;
+
+    if (librdf_node_is_resource(node)) {
+        out->kind = LEGACY_NODE_URI;
+        str = librdf_uri_as_counted_string(librdf_node_get_uri(node), &len);
+    }
+    else if (librdf_node_is_blank(node)) {
+        out->kind = LEGACY_NODE_BLANK;
+        str = librdf_node_get_blank_identifier(node);
+        len = str ? strlen((const char*)str) : 0;
+    }
+    else {
+        const char* lang = librdf_node_get_literal_value_language(node);
+        librdf_uri* datatype = librdf_node_get_literal_value_datatype_uri(node);
+
+        out->kind = LEGACY_NODE_LITERAL;
+        str = librdf_node_get_literal_value_as_counted_string(node, &len);
+        if (lang)
+            out->lang = legacy_dict_intern(dict, (const unsigned char*)lang, strlen(lang));
+        if (datatype) {
+            size_t dt_len;
+            unsigned char* dt = librdf_uri_as_counted_string(datatype, &dt_len);
+            out->datatype = legacy_dict_intern(dict, dt, dt_len);
+        }
+    }
+    out->value = legacy_dict_intern(dict, str, len);
+    return out->value == LEGACY_PACK_NONE ? -1 : 0;
+}
+
+/* Flatten model into a newly allocated buffer, caller frees */
+static unsigned char* legacy_graph_pack(librdf_model* model, size_t* size_out) {
+    legacy_dict dict;
+    legacy_pack_node* triples = NULL;
+    size_t num_triples = 0;
+    size_t triples_capacity = 0;
+    unsigned char* buf = NULL;
+    int failed = 0;
+
+    memset(&dict, 0, sizeof(dict));
+    *size_out = 0;
+
+    librdf_stream* stream = librdf_model_as_stream(model);
+    if (!stream)
+        return NULL;
+
+    for (; !librdf_stream_end(stream); librdf_stream_next(stream)) {
+        librdf_statement* st = librdf_stream_get_object(stream);
+        if (num_triples + 1 > triples_capacity) {
+            size_t new_capacity = triples_capacity ? triples_capacity * 2 : 1024;
+            legacy_pack_node* tmp = realloc(triples, new_capacity * 3 * sizeof(legacy_pack_node));
+            if (!tmp) {
+                failed = 1;
+                break;
+            }
+            triples = tmp;
+            triples_capacity = new_capacity;
+        }
+        legacy_pack_node* t = triples + num_triples * 3;
+        if (legacy_pack_node_from(&dict, librdf_statement_get_subject(st), &t[0]) < 0 ||
+            legacy_pack_node_from(&dict, librdf_statement_get_predicate(st), &t[1]) < 0 ||
+            legacy_pack_node_from(&dict, librdf_statement_get_object(st), &t[2]) < 0) {
+            failed = 1;
+            break;
+        }
+        num_triples++;
+    }
+    librdf_free_stream(stream);
+
+    if (!failed) {
+        legacy_pack_header header;
+        size_t triples_size = num_triples * 3 * sizeof(legacy_pack_node);
+
+        header.magic = LEGACY_PACK_MAGIC;
+        header.version = LEGACY_PACK_VERSION;
+        header.num_strings = dict.count;
+        header.num_triples = (uint32_t)num_triples;
+        header.strings_size = dict.pool_size;
+
+        buf = malloc(sizeof(header) + dict.pool_size + triples_size);
+        if (buf) {
+            memcpy(buf, &header, sizeof(header));
+            if (dict.pool_size)
+                memcpy(buf + sizeof(header), dict.pool, dict.pool_size);
+            if (triples_size)
+                memcpy(buf + sizeof(header) + dict.pool_size, triples, triples_size);
+            *size_out = sizeof(header) + dict.pool_size + triples_size;
+        }
+    }
+
+    free(triples);
+    legacy_dict_free(&dict);
+    return buf;
+}
+
+static librdf_node* legacy_unpack_node(const legacy_pack_node* n,
+    const unsigned char** strs, const uint32_t* lens, uint32_t num_strings) {
+    if (n->value >= num_strings)
+        return NULL;
+
+    switch (n->kind) {
+        case LEGACY_NODE_URI:
+            return librdf_new_node_from_uri_string(world, strs[n->value]);
+        case LEGACY_NODE_BLANK:
+            return librdf_new_node_from_blank_identifier(world, strs[n->value]);
+        case LEGACY_NODE_LITERAL: {
+            const char* lang = NULL;
+            size_t lang_len = 0;
+            librdf_uri* datatype = NULL;
+            librdf_node* node;
+
+            if (n->lang < num_strings) {
+                lang = (const char*)strs[n->lang];
+                lang_len = lens[n->lang];
+            }
+            if (n->datatype < num_strings)
+                datatype = librdf_new_uri(world, strs[n->datatype]);
+            node = librdf_new_node_from_typed_counted_literal(world, strs[n->value],
+                lens[n->value], lang, lang_len, datatype);
+            if (datatype)
+                librdf_free_uri(datatype);
+            return node;
+        }
+        default:
+            return NULL;
+    }
+}
+
+/* Rebuild triples from a packed buffer, returns number of triples added */
+static int legacy_graph_unpack(librdf_model* model, unsigned char* buf, size_t size) {
+    legacy_pack_header header;
+    int added = 0;
+
+    if (size < sizeof(header))
+        return -1;
+    memcpy(&header, buf, sizeof(header));
+    if (header.magic != LEGACY_PACK_MAGIC || header.version != LEGACY_PACK_VERSION ||
+        sizeof(header) + header.strings_size +
+        (size_t)header.num_triples * 3 * sizeof(legacy_pack_node) > size)
+        return -1;
+
+    const unsigned char** strs = malloc((header.num_strings + 1) * sizeof(*strs));
+    uint32_t* lens = malloc((header.num_strings + 1) * sizeof(*lens));
+    if (!strs || !lens) {
+        free(strs);
+        free(lens);
+        return -1;
+    }
+
+    /* Index the string table */
+    unsigned char* p = buf + sizeof(header);
+    unsigned char* end = p + header.strings_size;
+    uint32_t i;
+    for (i = 0; i < header.num_strings && p + sizeof(uint32_t) <= end; i++) {
+        memcpy(&lens[i], p, sizeof(uint32_t));
+        if (p + sizeof(uint32_t) + lens[i] > end)
+            break;
+        strs[i] = p + sizeof(uint32_t);
+        p += sizeof(uint32_t) + lens[i];
+    }
+    if (i < header.num_strings) {
+        free(strs);
+        free(lens);
+        return -1;
+    }
+
+    /* NUL terminate in place so strings can be handed to Redland directly:
+     * shift each one byte back over its (already read) length prefix */
+    for (i = 0; i < header.num_strings; i++) {
+        unsigned char* dst = (unsigned char*)strs[i] - 1;
+        memmove(dst, strs[i], lens[i]);
+        dst[lens[i]] = '\0';
+        strs[i] = dst;
+    }
+
+    legacy_pack_node* triples = (legacy_pack_node*)(buf + sizeof(header) + header.strings_size);
+    for (uint32_t t = 0; t < header.num_triples; t++) {
+        legacy_pack_node n[3];
+        memcpy(n, triples + (size_t)t * 3, sizeof(n));
+
+        librdf_node* s = legacy_unpack_node(&n[0], strs, lens, header.num_strings);
+        librdf_node* pr = legacy_unpack_node(&n[1], strs, lens, header.num_strings);
+        librdf_node* o = legacy_unpack_node(&n[2], strs, lens, header.num_strings);
+        if (s && pr && o) {
+            /* Model takes ownership of the nodes */
+            if (!librdf_model_add(model, s, pr, o))
+                added++;
+        }
+        else {
+            if (s) librdf_free_node(s);
+            if (pr) librdf_free_node(pr);
+            if (o) librdf_free_node(o);
+        }
+    }
+
+    free(strs);
+    free(lens);
+    return added;
+}
+
+/* Parse legacy graph on rank 0 and broadcast it to all other ranks */
+static void load_legacy_graph(prov_config* config, prov_fields* fields) {
+    unsigned long long size = 0;
+    unsigned char* buf = NULL;
+    int num_of_rank;
+
+    MPI_Comm_size(MPI_COMM_WORLD, &num_of_rank);
+
+    if (fields->mpi_rank_int == 0) {
+        char legacy_uri_str[1024] = "file:";
+        FILE *legacy_path_handler;
+        legacy_path_handler = fopen(config->legacy_graph_path, "r");
+        if(legacy_path_handler == NULL) {
+            printf("Old provenance file not found\n");
+        }
+        else {
+            fclose(legacy_path_handler);
+            strncat(legacy_uri_str, config->legacy_graph_path,
+                sizeof(legacy_uri_str) - strlen(legacy_uri_str) - 1);
+            printf("Legacy graph: %s\n", config->legacy_graph_path);
+
+            librdf_parser *parser = librdf_new_parser(world, "turtle", NULL, NULL);
+            librdf_uri* legacy_uri=librdf_new_uri(world, (const unsigned char*)legacy_uri_str);
+
+            if(librdf_parser_parse_into_model(parser,legacy_uri,legacy_uri,model_prov)) {
+                fprintf(stderr, "Failed to parse old provenance file into model, check path %s\n",
+                    config->legacy_graph_path);
+            }
+            else if (num_of_rank > 1) {
+                size_t packed_size;
+                buf = legacy_graph_pack(model_prov, &packed_size);
+                if (buf)
+                    size = packed_size;
+                else
+                    fprintf(stderr, "Failed to pack legacy graph, other ranks start with an empty model\n");
+            }
+            librdf_free_uri(legacy_uri);
+            librdf_free_parser(parser);
+        }
+    }
+
+    if (num_of_rank <= 1)
+        return;
+
+    MPI_Bcast(&size, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+    if (size == 0)
+        return;
+
+    if (fields->mpi_rank_int != 0) {
+        buf = malloc(size);
+        if (!buf) {
+            fprintf(stderr, "Failed to allocate %llu bytes for legacy graph\n", size);
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+    }
+
+    /* MPI counts are int, send large graphs in pieces */
+    for (unsigned long long offset = 0; offset < size; offset += LEGACY_BCAST_CHUNK) {
+        unsigned long long count = size - offset;
+        if (count > LEGACY_BCAST_CHUNK)
+            count = LEGACY_BCAST_CHUNK;
+        MPI_Bcast(buf + offset, (int)count, MPI_BYTE, 0, MPI_COMM_WORLD);
+    }
+
+    if (fields->mpi_rank_int != 0) {
+        if (legacy_graph_unpack(model_prov, buf, size) < 0)
+            fprintf(stderr, "Failed to load legacy graph broadcast from rank 0\n");
+    }
+    free(buf);
+}
+#endif
+
+
 // static void free_fields(prov_fields* fields) {
 //     free((char*)fields->proc_name);
 //     free((char*)fields->proc_uuid);
@@ -115,35 +609,395 @@ static void get_process_name_by_pid(prov_fields* fields, int pid)
 
 void prov_fill_data_object(prov_fields* fields, const char* obj_name, 
     const char* type) {
+    STAT_PHASE_BEGIN(STAT_PHASE_FILL);
     strcpy(fields->data_object, obj_name);
     // if (fields->proc_uuid) {
     //     strcat(fields->data_object, "--");
     //     strcat(fields->data_object, fields->proc_uuid);
     // }
     strcpy(fields->type, type);      
+    STAT_PHASE_END();
 }
 
 
 void prov_fill_relation(prov_fields* fields, const char* relation) {
+    STAT_PHASE_BEGIN(STAT_PHASE_FILL);
     strcpy(fields->relation, relation);
+    STAT_PHASE_END();
 }
 
 
 void prov_fill_io_api(prov_fields* fields, const char* io_api, unsigned long duration) {
+    STAT_PHASE_BEGIN(STAT_PHASE_FILL);
     strcpy(fields->io_api, io_api);  
     fields->duration = duration; 
+    fields->timestamp = provio_global_time(fields, get_time_usec() - duration);
+    STAT_PHASE_END();
+}
+
+
+void prov_fill_file(prov_fields* fields, const char* file_name) {
+    STAT_PHASE_BEGIN(STAT_PHASE_FILL);
+    snprintf(fields->file_name, sizeof(fields->file_name), "%s", file_name ? file_name : "");
+    STAT_PHASE_END();
+}
+
+
+void prov_fill_io_bytes(prov_fields* fields, unsigned long bytes) {
+    fields->io_bytes = bytes;
 }
 
 
 void func_stat(const char* func_name, unsigned long elapsed) {
-    accumulate_duration(FUNCTION_FREQUENCY, func_name, elapsed);
+    accumulate_duration(stat_local_counts(), func_name, elapsed);
+    stat_tick();
+}
+
+void func_stat_id(int func_id, unsigned long native, unsigned long overhead) {
+    accumulate_duration_id(func_id, native, overhead);
+    stat_tick();
+}
+
+
+/* Shard repository
+ *
+ * Instead of rewriting one ever growing legacy graph, every rank of every
+ * run writes its own immutable shard into SHARD_REPO_PATH and appends one
+ * line to the repository manifest:
+ *
+ *     <shard>\t<rank>\t<start us>\t<end us>\t<triples>\t<file>,<file>,...
+ *
+ * Tools use the manifest to pick the shards they need and parse only those.
+ */
+static int open_shard(prov_config* config, provio_helper_t* helper, prov_fields* fields) {
+    char path[2048];
+    char name[640];
+
+    if (mkdir(config->shard_repo_path, 0755) < 0 && errno != EEXIST)
+        return -1;
+
+    snprintf(name, sizeof(name), "%lu-%s.RANK-%d.ttl", get_time_usec(),
+        fields->proc_uuid, fields->mpi_rank_int);
+    snprintf(path, sizeof(path), "%s/%s", config->shard_repo_path, name);
+
+    /* Shards are immutable, never overwrite an existing one */
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+        return -1;
+    helper->shard_file_handle = fdopen(fd, "w");
+    if (!helper->shard_file_handle) {
+        close(fd);
+        return -1;
+    }
+    helper->shard_name = strdup(name);
+    helper->shard_start_time = provio_global_time(fields, get_time_usec());
+    return 0;
+}
+
+static void shard_note_file(provio_helper_t* helper, const char* file_name) {
+    for (int i = 0; i < helper->num_files_touched; i++)
+        if (!strcmp(helper->files_touched[i], file_name))
+            return;
+
+    if (helper->num_files_touched == helper->max_files_touched) {
+        int new_max = helper->max_files_touched ? helper->max_files_touched * 2 : 8;
+        char** tmp = realloc(helper->files_touched, new_max * sizeof(char*));
+        if (!tmp)
+            return;
+        helper->files_touched = tmp;
+        helper->max_files_touched = new_max;
+    }
+    helper->files_touched[helper->num_files_touched++] = strdup(file_name);
+}
+
+/* Append one line for this shard, manifest lines from concurrent ranks and
+ * runs are serialized with a write lock on the manifest */
+static int append_shard_manifest(prov_config* config, provio_helper_t* helper,
+    prov_fields* fields, unsigned long end_time, int num_triples) {
+    char path[2048];
+    size_t len = strlen(helper->shard_name) + 128;
+    int ret = 0;
+
+    for (int i = 0; i < helper->num_files_touched; i++)
+        len += strlen(helper->files_touched[i]) + 1;
+
+    char* line = malloc(len);
+    if (!line)
+        return -1;
+
+    int pos = snprintf(line, len, "%s\t%d\t%lu\t%lu\t%d\t", helper->shard_name,
+        fields->mpi_rank_int, helper->shard_start_time, end_time, num_triples);
+    for (int i = 0; i < helper->num_files_touched; i++)
+        pos += snprintf(line + pos, len - pos, "%s%s", i ? "," : "", helper->files_touched[i]);
+    pos += snprintf(line + pos, len - pos, "\n");
+
+    snprintf(path, sizeof(path), "%s/%s", config->shard_repo_path, SHARD_MANIFEST);
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        free(line);
+        return -1;
+    }
+
+    struct flock lock;
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    fcntl(fd, F_SETLKW, &lock);
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size == 0) {
+        const char* header = "# shard\trank\tstart_us\tend_us\ttriples\tfiles\n";
+        if (write(fd, header, strlen(header)) < 0)
+            ret = -1;
+    }
+    if (write(fd, line, pos) != pos)
+        ret = -1;
+
+    lock.l_type = F_UNLCK;
+    fcntl(fd, F_SETLK, &lock);
+    close(fd);
+    free(line);
+    return ret;
+}
+
+
+/* Object sketches
+ *
+ * Every record updates fixed-size sketches (sketch.h) of the objects it
+ * touches: bytes moved per object with the heaviest objects, and distinct
+ * objects of the program and of every file. They are merged over all ranks
+ * at teardown and rank 0 adds the summary to its provenance.
+ */
+typedef struct file_sketch {
+    uint64_t key;
+    char name[SKETCH_NAME_LEN];
+    sketch_hll hll;
+    struct file_sketch* next;
+} file_sketch;
+
+static sketch_cms* SKETCH_BYTES = NULL;
+static sketch_top SKETCH_TOP;
+static sketch_hll* SKETCH_PROGRAM = NULL;
+static file_sketch* SKETCH_FILES = NULL;    // in the order files were first seen
+static file_sketch* SKETCH_FILES_TAIL = NULL;
+
+static int sketch_init(int top_k) {
+    SKETCH_BYTES = calloc(1, sizeof(sketch_cms));
+    SKETCH_PROGRAM = calloc(1, sizeof(sketch_hll));
+    if (!SKETCH_BYTES || !SKETCH_PROGRAM || sketch_top_init(&SKETCH_TOP, top_k) < 0) {
+        sketch_free();
+        return -1;
+    }
+    return 0;
+}
+
+static void sketch_free(void) {
+    while (SKETCH_FILES) {
+        file_sketch* next = SKETCH_FILES->next;
+        free(SKETCH_FILES);
+        SKETCH_FILES = next;
+    }
+    SKETCH_FILES_TAIL = NULL;
+    sketch_top_free(&SKETCH_TOP);
+    free(SKETCH_BYTES);
+    free(SKETCH_PROGRAM);
+    SKETCH_BYTES = NULL;
+    SKETCH_PROGRAM = NULL;
+}
+
+static file_sketch* sketch_file(const char* name, int create) {
+    uint64_t key = sketch_hash(name, NULL);
+    file_sketch* f;
+
+    for (f = SKETCH_FILES; f; f = f->next)
+        if (f->key == key && !strncmp(f->name, name, SKETCH_NAME_LEN - 1))
+            return f;
+    if (!create || !(f = calloc(1, sizeof(file_sketch))))
+        return NULL;
+    f->key = key;
+    snprintf(f->name, sizeof(f->name), "%s", name);
+    if (SKETCH_FILES_TAIL)
+        SKETCH_FILES_TAIL->next = f;
+    else
+        SKETCH_FILES = f;
+    SKETCH_FILES_TAIL = f;
+    return f;
+}
+
+static void sketch_record(prov_fields* fields) {
+    const char* file = fields->file_name;
+    file_sketch* f;
+    uint64_t key;
+
+    // A file record is about the file itself
+    if (!strcmp(fields->type, "provio:File"))
+        file = fields->data_object;
+    key = sketch_hash(file, fields->data_object);
+
+    sketch_hll_add(SKETCH_PROGRAM, key);
+    if (file[0] && (f = sketch_file(file, 1)))
+        sketch_hll_add(&f->hll, key);
+    if (fields->io_bytes) {
+        sketch_cms_add(SKETCH_BYTES, key, fields->io_bytes);
+        sketch_top_offer(&SKETCH_TOP, key, sketch_cms_estimate(SKETCH_BYTES, key),
+            fields->data_object, file);
+    }
+}
+
+/* Concatenation of every rank's buf on rank 0, NULL on the other ranks */
+static char* gather_bytes(const char* buf, int len, int rank, int nprocs, int* total_out) {
+    int* lens = NULL;
+    int* offsets = NULL;
+    char* all = NULL;
+    int total = 0;
+
+    if (rank == 0) {
+        lens = malloc(nprocs * sizeof(int));
+        offsets = malloc(nprocs * sizeof(int));
+        if (!lens || !offsets) {
+            fprintf(stderr, "Failed to allocate sketch merge buffers\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+    }
+    MPI_Gather(&len, 1, MPI_INT, lens, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        for (int i = 0; i < nprocs; i++) {
+            offsets[i] = total;
+            total += lens[i];
+        }
+        all = malloc(total ? total : 1);
+        if (!all) {
+            fprintf(stderr, "Failed to allocate %d bytes to merge sketches\n", total);
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+    }
+    MPI_Gatherv(buf, len, MPI_BYTE, all, lens, offsets, MPI_BYTE, 0, MPI_COMM_WORLD);
+    free(lens);
+    free(offsets);
+    *total_out = total;
+    return all;
+}
+
+/* File names, NUL terminated one after the other */
+static char* sketch_pack_files(int* len_out, int* count_out) {
+    int len = 0, count = 0, pos = 0;
+    char* buf;
+
+    for (file_sketch* f = SKETCH_FILES; f; f = f->next) {
+        len += strlen(f->name) + 1;
+        count++;
+    }
+    buf = malloc(len ? len : 1);
+    if (buf)
+        for (file_sketch* f = SKETCH_FILES; f; f = f->next)
+            pos += sprintf(buf + pos, "%s", f->name) + 1;
+    *len_out = buf ? len : 0;
+    *count_out = buf ? count : 0;
+    return buf;
+}
+
+/* Collective: rank 0 ends up with the sketches of all ranks. Counters and
+ * registers are reduced; file names and heavy-hitter candidates are
+ * gathered, and rank 0 ranks the candidates again with the merged counts. */
+static void sketch_reduce(prov_fields* fields) {
+    int initialized, finalized, nprocs;
+    int rank = fields->mpi_rank_int;
+    int len, count, total;
+    char* buf;
+    char* all;
+    uint8_t* regs;
+
+    MPI_Initialized(&initialized);
+    MPI_Finalized(&finalized);
+    if (!initialized || finalized)
+        return;
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+    if (nprocs <= 1)
+        return;
+
+    MPI_Reduce(rank ? (void*)SKETCH_BYTES : MPI_IN_PLACE, SKETCH_BYTES,
+        sizeof(sketch_cms) / sizeof(uint64_t), MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(rank ? (void*)SKETCH_PROGRAM->reg : MPI_IN_PLACE, SKETCH_PROGRAM->reg,
+        SKETCH_HLL_REGS, MPI_UINT8_T, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    /* Files: rank 0 collects all names, the registers are then reduced in
+     * the order of its list */
+    buf = sketch_pack_files(&len, &count);
+    all = gather_bytes(buf, len, rank, nprocs, &total);
+    free(buf);
+    for (int pos = 0; rank == 0 && pos < total; pos += strlen(all + pos) + 1)
+        sketch_file(all + pos, 1);
+    free(all);
+
+    buf = rank == 0 ? sketch_pack_files(&len, &count) : NULL;
+    MPI_Bcast(&len, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&count, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (rank != 0)
+        buf = malloc(len ? len : 1);
+    regs = calloc(count ? count : 1, SKETCH_HLL_REGS);
+    if (!buf || !regs) {
+        fprintf(stderr, "Failed to allocate sketch merge buffers\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    MPI_Bcast(buf, len, MPI_BYTE, 0, MPI_COMM_WORLD);
+    for (int i = 0, pos = 0; i < count; i++, pos += strlen(buf + pos) + 1) {
+        file_sketch* f = sketch_file(buf + pos, 0);
+        if (f)
+            memcpy(regs + (size_t)i * SKETCH_HLL_REGS, f->hll.reg, SKETCH_HLL_REGS);
+    }
+    MPI_Reduce(rank ? (void*)regs : MPI_IN_PLACE, regs, count * SKETCH_HLL_REGS,
+        MPI_UINT8_T, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        int i = 0;
+        for (file_sketch* f = SKETCH_FILES; f && i < count; f = f->next, i++)
+            memcpy(f->hll.reg, regs + (size_t)i * SKETCH_HLL_REGS, SKETCH_HLL_REGS);
+    }
+    free(regs);
+    free(buf);
+
+    /* Heavy hitters: key, then object and file name */
+    len = 0;
+    for (int i = 0; i < SKETCH_TOP.size; i++)
+        len += sizeof(uint64_t) + strlen(SKETCH_TOP.heap[i].name) + strlen(SKETCH_TOP.heap[i].file) + 2;
+    buf = malloc(len ? len : 1);
+    if (!buf) {
+        fprintf(stderr, "Failed to allocate sketch merge buffers\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    len = 0;
+    for (int i = 0; i < SKETCH_TOP.size; i++) {
+        memcpy(buf + len, &SKETCH_TOP.heap[i].key, sizeof(uint64_t));
+        len += sizeof(uint64_t);
+        len += sprintf(buf + len, "%s", SKETCH_TOP.heap[i].name) + 1;
+        len += sprintf(buf + len, "%s", SKETCH_TOP.heap[i].file) + 1;
+    }
+    all = gather_bytes(buf, len, rank, nprocs, &total);
+    free(buf);
+    if (rank == 0) {
+        int capacity = SKETCH_TOP.capacity;
+
+        sketch_top_free(&SKETCH_TOP);
+        sketch_top_init(&SKETCH_TOP, capacity);
+        for (int pos = 0; pos < total; ) {
+            uint64_t key;
+            const char* name;
+            const char* file;
+
+            memcpy(&key, all + pos, sizeof(uint64_t));
+            name = all + pos + sizeof(uint64_t);
+            file = name + strlen(name) + 1;
+            pos = (file + strlen(file) + 1) - all;
+            sketch_top_offer(&SKETCH_TOP, key, sketch_cms_estimate(SKETCH_BYTES, key), name, file);
+        }
+    }
+    free(all);
 }
 
 
 /* Initialize provenance helper */
 provio_helper_t* provio_helper_init(prov_config* config, prov_fields* fields) {
 
-    get_time_str(fields->proc_start_time);
+    get_time_str(fields, fields->proc_start_time);
 
     /* Load configuration */
     assert(config->prov_level);
@@ -159,13 +1013,24 @@ provio_helper_t* provio_helper_init(prov_config* config, prov_fields* fields) {
     provio_helper_t* new_helper = (provio_helper_t *)calloc(1, sizeof(provio_helper_t));
 
     if(config->prov_level >= 2) {//write to file
-        if(!config->new_graph_path && !config->legacy_graph_path){
+        if(!config->new_graph_path && !config->legacy_graph_path &&
+            !(config->enable_shards && config->shard_repo_path)){
             printf("prov_helper_init() failed, provenance file path is not set.\n");
             return NULL;
         }
     }
     
     FUNCTION_FREQUENCY = stat_create(config->num_of_apis);
+    if (config->enable_sketches && sketch_init(config->sketch_top_k) < 0)
+        printf("Failed to allocate object sketches, ENABLE_SKETCHES ignored\n");
+    if (config->enable_stat_shm)
+        stat_shm_open(fields->mpi_rank_int, (unsigned long)config->stat_shm_interval * 1000);
+    if (config->enable_stat_series && config->stat_series_path) {
+        char path[1024];
+        snprintf(path, sizeof(path), "%s.RANK-%d", config->stat_series_path, fields->mpi_rank_int);
+        stat_series_open(path, fields->mpi_rank_int,
+            (unsigned long)config->stat_series_interval * 1000, fields->clock_offset);
+    }
 
     if (fields->mpi_rank_int == 0) {
     /* Create stat file */
@@ -177,16 +1042,29 @@ provio_helper_t* provio_helper_init(prov_config* config, prov_fields* fields) {
     
         if (!strcmp(config->prov_line_format, "rdf") || !strcmp(config->prov_line_format, "RDF")) {
 
+            /* Write a new shard into the shard repository, history is never reopened */
+            if (config->enable_shards && config->shard_repo_path) {
+                if (open_shard(config, new_helper, fields) == 0)
+                    return new_helper;
+                printf("Failed to create shard in %s, fall back to graph files\n",
+                    config->shard_repo_path);
+            }
+
             /* Open or create provenance file */
             if (config->legacy_graph_path && config->enable_legacy_graph) {
                 new_helper->legacy_prov_file_handle = fopen(config->legacy_graph_path, "w");
             }
             if (config->new_graph_path) {
                 if (!config->enable_legacy_graph) {
-                    char tmp[32]; 
-                    sprintf(tmp, "%d", fields->mpi_rank_int);
-                    strcat(config->new_graph_path, ".RANK-");
-                    strcat(config->new_graph_path, tmp);
+                    char tmp[32];
+                    char* path;
+                    sprintf(tmp, ".RANK-%d", fields->mpi_rank_int);
+                    // new_graph_path is strdup'ed, make room for the suffix
+                    path = realloc(config->new_graph_path, strlen(config->new_graph_path) + strlen(tmp) + 1);
+                    if (path) {
+                        config->new_graph_path = path;
+                        strcat(config->new_graph_path, tmp);
+                    }
                     new_helper->new_prov_file_handle = fopen(config->new_graph_path, "w");
                     printf("Created a new provenance file\n");
                 }
@@ -202,6 +1080,7 @@ provio_helper_t* provio_helper_init(prov_config* config, prov_fields* fields) {
 void provio_init(prov_config* config, prov_fields* fields) {
     //Default settings
     load_config(config);
+    stat_timer_init(config->enable_tsc_timer);
 
     if (!fields)
         fields = (prov_fields*) calloc(1, sizeof(prov_fields));
@@ -211,6 +1090,8 @@ void provio_init(prov_config* config, prov_fields* fields) {
 
     // Get RANK ID 
     fields->mpi_rank_int = get_mpi_rank(fields);
+    if (config->enable_perf_counters && stat_perf_open(1) == 0 && fields->mpi_rank_int == 0)
+        printf("PROV-IO: perf events are not available, ENABLE_PERF_COUNTERS ignored\n");
 
     char tmp_rank[128];
     if (fields->mpi_rank) {
@@ -235,6 +1116,13 @@ void provio_init(prov_config* config, prov_fields* fields) {
 
     getlogin_r(fields->user_name, 32);
 
+    // Estimate clock offset against rank 0
+    if (config->enable_clock_sync)
+        fields->clock_offset = clock_sync(config, fields, &fields->clock_sync_time);
+    fields->start_time = provio_global_time(fields, get_time_usec());
+    if (config->enable_stat_record)
+        alloc_run_id(fields);
+
 
 #ifdef LIBRDF_H
     /* Initialise Redland environment */
@@ -271,37 +1159,25 @@ void provio_init(prov_config* config, prov_fields* fields) {
 
     model_prov = librdf_new_model(world, storage_prov, NULL);
 
-    // Parser and load legacy graph into model. 
-    // We don't parse legacy graph in this version since it will need advance 
-    // MPI thread coordiation mechanism to fully support cross-rank graph insertion.
-
-    librdf_parser *parser = librdf_new_parser(world, "turtle", NULL, NULL);
-    char legacy_uri_str[256] = "file:";
-    if (config->legacy_graph_path && config->enable_legacy_graph) {
-        FILE *legacy_path_handler;
-        legacy_path_handler = fopen(config->legacy_graph_path, "r");
-        if(legacy_path_handler == NULL) {
-            printf("Old provenance file not found\n");
-        }
-        else {
-            strcat(legacy_uri_str, config->legacy_graph_path);
-            printf("Legacy graph: %s\n", config->legacy_graph_path);
-            librdf_uri* legacy_uri=librdf_new_uri(world, (const unsigned char*)legacy_uri_str);
-          
-            if(librdf_parser_parse_into_model(parser,legacy_uri,legacy_uri,model_prov)) {
-                fprintf(stderr, "Failed to parse old provenance file into model, check path %s\n", 
-                    config->legacy_graph_path);
-            }
-            librdf_free_uri(legacy_uri);
-            fclose(legacy_path_handler);
-        }
-        librdf_free_parser(parser);
-    }
+    // Load legacy graph into model. Rank 0 parses the Turtle file once and
+    // broadcasts a packed copy of the triples, other ranks rebuild the model
+    // from it without invoking the parser.
+    // Shards supersede the legacy graph, nothing is parsed at startup then.
+    if (config->legacy_graph_path && config->enable_legacy_graph &&
+        !(config->enable_shards && config->shard_repo_path))
+        load_legacy_graph(config, fields);
 #endif
 
 }
 
 
+/* Insert into the provenance model, timed as the store phase */
+static void model_add_statement(librdf_statement* st) {
+    STAT_PHASE_BEGIN(STAT_PHASE_STORE);
+    librdf_model_add_statement(model_prov, st);
+    STAT_PHASE_END();
+}
+
 int add_user_record_Redland(prov_config* config, prov_fields* fields) {
     // User     
     if (config->enable_user_prov) {
@@ -311,14 +1187,14 @@ int add_user_record_Redland(prov_config* config, prov_fields* fields) {
                librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:type"),
                librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:Agent")
                );
-            librdf_model_add_statement(model_prov, statement);
+            model_add_statement(statement);
 
             statement=librdf_new_statement_from_nodes(world, 
                librdf_new_node_from_uri_string(world, (const unsigned char *)fields->user_name),
                librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:wasMemberOf"),
                librdf_new_node_from_uri_string(world, (const unsigned char*)"provio:User")
                );
-            librdf_model_add_statement(model_prov, statement);
+            model_add_statement(statement);
 
             USER_TRACKED = 1;
         }
@@ -335,14 +1211,14 @@ int add_mpi_rank_record_Redland(prov_config* config, prov_fields* fields) {
                librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:type"),
                librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:Agent")
                );
-            librdf_model_add_statement(model_prov, statement);
+            model_add_statement(statement);
 
             statement=librdf_new_statement_from_nodes(world, 
                librdf_new_node_from_uri_string(world, (const unsigned char *)fields->mpi_rank),
                librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:wasMemberOf"),
                librdf_new_node_from_uri_string(world, (const unsigned char*)"provio:Thread")
                );
-            librdf_model_add_statement(model_prov, statement);
+            model_add_statement(statement);
 
             if (config->enable_user_prov) {
                statement=librdf_new_statement_from_nodes(world, 
@@ -350,7 +1226,7 @@ int add_mpi_rank_record_Redland(prov_config* config, prov_fields* fields) {
                   librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:actedOnBehalfOf"),
                   librdf_new_node_from_uri_string(world, (const unsigned char*)fields->user_name)
                                              );
-               librdf_model_add_statement(model_prov, statement);
+               model_add_statement(statement);
             }
             MPI_RANK_TRACKED = 1;
         }
@@ -367,14 +1243,14 @@ int add_program_record_Redland(prov_config* config, prov_fields* fields) {
                librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:type"),
                librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:Agent")
                );
-            librdf_model_add_statement(model_prov, statement);
+            model_add_statement(statement);
 
             statement=librdf_new_statement_from_nodes(world, 
                librdf_new_node_from_uri_string(world, (const unsigned char *)fields->proc_name),
                librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:wasMemberOf"),
                librdf_new_node_from_uri_string(world, (const unsigned char*)"provio:Program")
                );
-            librdf_model_add_statement(model_prov, statement);
+            model_add_statement(statement);
 
             if (config->enable_thread_prov && fields->mpi_rank) {
                statement=librdf_new_statement_from_nodes(world,
@@ -382,7 +1258,7 @@ int add_program_record_Redland(prov_config* config, prov_fields* fields) {
                   librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:actedOnBehalfOf"),
                   librdf_new_node_from_uri_string(world, (const unsigned char*)fields->mpi_rank)
                   );
-               librdf_model_add_statement(model_prov, statement);
+               model_add_statement(statement);
             }
 
             statement=librdf_new_statement_from_nodes(world, 
@@ -390,7 +1266,7 @@ int add_program_record_Redland(prov_config* config, prov_fields* fields) {
                 librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:startedAtTime"),
                 librdf_new_node_from_literal(world, (const unsigned char*)fields->proc_start_time, NULL, 0)
             );
-            librdf_model_add_statement(model_prov, statement);
+            model_add_statement(statement);
 
             PROC_NAME_TRACKED = 1;
         }
@@ -400,7 +1276,34 @@ int add_program_record_Redland(prov_config* config, prov_fields* fields) {
                 librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:endedAtTime"),
                 librdf_new_node_from_literal(world, (const unsigned char*)fields->proc_end_time, NULL, 0)
             );
-            librdf_model_add_statement(model_prov, statement);
+            model_add_statement(statement);
+
+            if (config->enable_clock_sync) {
+                char clock_[64];
+                sprintf(clock_, "%ld", fields->clock_offset);
+                statement=librdf_new_statement_from_nodes(world,
+                    librdf_new_node_from_uri_string(world, (const unsigned char *)fields->proc_name),
+                    librdf_new_node_from_uri_string(world, (const unsigned char*)"provio:clockOffset"),
+                    librdf_new_node_from_literal(world, (const unsigned char*)clock_, NULL, 0)
+                );
+                model_add_statement(statement);
+
+                sprintf(clock_, "%.12g", fields->clock_drift);
+                statement=librdf_new_statement_from_nodes(world,
+                    librdf_new_node_from_uri_string(world, (const unsigned char *)fields->proc_name),
+                    librdf_new_node_from_uri_string(world, (const unsigned char*)"provio:clockDrift"),
+                    librdf_new_node_from_literal(world, (const unsigned char*)clock_, NULL, 0)
+                );
+                model_add_statement(statement);
+
+                sprintf(clock_, "%lu", fields->clock_sync_time);
+                statement=librdf_new_statement_from_nodes(world,
+                    librdf_new_node_from_uri_string(world, (const unsigned char *)fields->proc_name),
+                    librdf_new_node_from_uri_string(world, (const unsigned char*)"provio:clockSyncTime"),
+                    librdf_new_node_from_literal(world, (const unsigned char*)clock_, NULL, 0)
+                );
+                model_add_statement(statement);
+            }
         }
     }
     return 0;
@@ -410,13 +1313,15 @@ int add_io_api_record_Redland(prov_config* config, prov_fields* fields, char* du
     // I/O API
     if (config->enable_api_prov) {
         /* Allocate UUID to io_api */
+        STAT_PHASE_BEGIN(STAT_PHASE_UUID);
         alloc_api_uuid(fields);
+        STAT_PHASE_END();
         statement=librdf_new_statement_from_nodes(world, 
             librdf_new_node_from_uri_string(world, (const unsigned char *)fields->io_api),
             librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:type"),
             librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:Activity")
             );
-        librdf_model_add_statement(model_prov, statement);
+        model_add_statement(statement);
 
         if (config->enable_program_prov) {
             statement=librdf_new_statement_from_nodes(world,
@@ -424,7 +1329,7 @@ int add_io_api_record_Redland(prov_config* config, prov_fields* fields, char* du
                librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:wasAssociatedWith"),
                librdf_new_node_from_uri_string(world, (const unsigned char*)fields->proc_name)
                );
-            librdf_model_add_statement(model_prov, statement);    
+            model_add_statement(statement);    
         }      
 
         if (config->enable_duration_prov) {
@@ -433,7 +1338,18 @@ int add_io_api_record_Redland(prov_config* config, prov_fields* fields, char* du
                librdf_new_node_from_uri_string(world, (const unsigned char*)"provio:elapsed"),
                librdf_new_node_from_literal(world, (const unsigned char*)duration_, NULL, 0)
                );
-            librdf_model_add_statement(model_prov, statement);
+            model_add_statement(statement);
+        }
+
+        if (config->enable_clock_sync) {
+            char timestamp_[32];
+            sprintf(timestamp_, "%lu", fields->timestamp);
+            statement=librdf_new_statement_from_nodes(world,
+               librdf_new_node_from_uri_string(world, (const unsigned char *)fields->io_api),
+               librdf_new_node_from_uri_string(world, (const unsigned char*)"provio:startedAt"),
+               librdf_new_node_from_literal(world, (const unsigned char*)timestamp_, NULL, 0)
+               );
+            model_add_statement(statement);
         }
     }
     return 0;
@@ -452,14 +1368,14 @@ int add_data_obj_record_Redland(prov_config* config, prov_fields* fields) {
         librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:type"),
         librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:Entity")
         );
-    librdf_model_add_statement(model_prov, statement);
+    model_add_statement(statement);
 
     statement=librdf_new_statement_from_nodes(world, 
         librdf_new_node_from_uri_string(world, (const unsigned char*)fields->data_object),
         librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:wasMemberOf"),
         librdf_new_node_from_uri_string(world, (const unsigned char *)fields->type)
         );
-    librdf_model_add_statement(model_prov, statement);
+    model_add_statement(statement);
 
     if (config->enable_api_prov) {
         statement=librdf_new_statement_from_nodes(world, 
@@ -467,7 +1383,7 @@ int add_data_obj_record_Redland(prov_config* config, prov_fields* fields) {
             librdf_new_node_from_uri_string(world, (const unsigned char *)fields->relation),
             librdf_new_node_from_uri_string(world, (const unsigned char *)fields->io_api)
             );
-        librdf_model_add_statement(model_prov, statement);
+        model_add_statement(statement);
     }
 
       if (config->enable_program_prov) {
@@ -476,7 +1392,7 @@ int add_data_obj_record_Redland(prov_config* config, prov_fields* fields) {
             librdf_new_node_from_uri_string(world, (const unsigned char*)"prov:wasAttributedTo"),
             librdf_new_node_from_uri_string(world, (const unsigned char *)fields->proc_name)
             );
-        librdf_model_add_statement(model_prov, statement);  
+        model_add_statement(statement);  
         }
     }
     return 0;
@@ -490,14 +1406,23 @@ int add_program_record(prov_config* config, prov_fields* fields) {
 /* Add Redland provenance statement */
 int add_prov_record_Redland(prov_config* config, prov_fields* fields, char* duration_) {
     int ret;
+    STAT_PHASE_BEGIN(STAT_PHASE_NODE);
     ret = add_user_record_Redland(config, fields);
     ret = add_mpi_rank_record_Redland(config, fields);
     ret = add_io_api_record_Redland(config, fields, duration_);
     ret = add_data_obj_record_Redland(config, fields);
+    STAT_PHASE_END();
     return ret;
 }
 
 
+static void (*record_hook)(const prov_fields* fields);
+
+void provio_set_record_hook(void (*hook)(const prov_fields* fields)) {
+    record_hook = hook;
+}
+
+
 int add_prov_record(prov_config* config, provio_helper_t* helper_in, prov_fields* fields){
     unsigned long start = get_time_usec();
     const char* base = DEFAULT_FUNCTION_PREFIX; //to be replace by H5
@@ -521,11 +1446,22 @@ int add_prov_record(prov_config* config, provio_helper_t* helper_in, prov_fields
                 break;
     }
 
+    STAT_PHASE_BEGIN(STAT_PHASE_TEXT);
     if(!strcmp(config->prov_line_format, "rdf") || !strcmp(config->prov_line_format, "RDF")) {
         sprintf(duration_, "%lu", fields->duration);
     }
     else
         sprintf(pline, "%s %luus\n", fields->io_api, fields->duration);//assume less than 64 functions
+    STAT_PHASE_END();
+
+    if (helper_in->shard_file_handle && !strcmp(fields->type, "provio:File"))
+        shard_note_file(helper_in, fields->data_object);
+    if (SKETCH_BYTES)
+        sketch_record(fields);
+    if (record_hook)
+        record_hook(fields);
+    fields->file_name[0] = '\0';
+    fields->io_bytes = 0;
     
     switch(config->prov_level){
         case File_only:
@@ -535,9 +1471,11 @@ int add_prov_record(prov_config* config, provio_helper_t* helper_in, prov_fields
 #endif      
             }
             else {
+                STAT_PHASE_BEGIN(STAT_PHASE_TEXT);
                 if (config->enable_legacy_graph)
                     fputs(pline, helper_in->legacy_prov_file_handle);
                 fputs(pline, helper_in->new_prov_file_handle);
+                STAT_PHASE_END();
             }
             break;
 
@@ -548,9 +1486,11 @@ int add_prov_record(prov_config* config, provio_helper_t* helper_in, prov_fields
 #endif                 
             }
             else {
+                STAT_PHASE_BEGIN(STAT_PHASE_TEXT);
                 if (config->enable_legacy_graph)
                     fputs(pline, helper_in->legacy_prov_file_handle);
                 fputs(pline, helper_in->new_prov_file_handle);
+                STAT_PHASE_END();
             }
             printf("%s", pline);
             break;
@@ -575,10 +1515,339 @@ int add_prov_record(prov_config* config, provio_helper_t* helper_in, prov_fields
 }
 
 
+#ifdef LIBRDF_H
+/* Statement about the resource named subject, takes object */
+static void add_statement_Redland(const char* subject, const char* predicate,
+        librdf_node* object) {
+    statement=librdf_new_statement_from_nodes(world,
+        librdf_new_node_from_uri_string(world, (const unsigned char *)subject),
+        librdf_new_node_from_uri_string(world, (const unsigned char*)predicate),
+        object
+        );
+    model_add_statement(statement);
+}
+#endif
+
+/* One activity for a call that moved several data objects at once, such
+ * as H5Dwrite_multi. Text: "<api> <duration>us <object>=<bytes> ...".
+ * In RDF each object gets its relation to the activity and a
+ * provio:Transfer node with its bytes. Sketches and the record hook see
+ * every object as if it had its own record. */
+int add_batch_record(prov_config* config, provio_helper_t* helper_in, prov_fields* fields,
+        const prov_batch_item* items, int count) {
+    unsigned long start = get_time_usec();
+    int rdf = !strcmp(config->prov_line_format, "rdf") || !strcmp(config->prov_line_format, "RDF");
+    char pline[4096];
+    char duration_[256];
+    int len;
+
+    assert(helper_in);
+    assert(fields);
+
+    sprintf(duration_, "%lu", fields->duration);
+    len = snprintf(pline, sizeof(pline), "%s %luus", fields->io_api, fields->duration);
+    for (int i = 0; i < count && len < (int)sizeof(pline); i++)
+        len += snprintf(pline + len, sizeof(pline) - len, " %s=%lu", items[i].data_object, items[i].io_bytes);
+    if (len >= (int)sizeof(pline) - 1)
+        len = sizeof(pline) - 2;
+    pline[len] = '\n';
+    pline[len + 1] = '\0';
+
+    for (int i = 0; i < count; i++) {
+        snprintf(fields->data_object, sizeof(fields->data_object), "%s", items[i].data_object);
+        prov_fill_file(fields, items[i].file_name);
+        fields->io_bytes = items[i].io_bytes;
+        if (SKETCH_BYTES)
+            sketch_record(fields);
+        if (record_hook)
+            record_hook(fields);
+    }
+    fields->file_name[0] = '\0';
+    fields->io_bytes = 0;
+
+    if (config->prov_level == File_only || config->prov_level == File_and_print) {
+        if (rdf) {
+#ifdef LIBRDF_H
+            char transfer[1536];
+            char bytes[32];
+
+            add_user_record_Redland(config, fields);
+            add_mpi_rank_record_Redland(config, fields);
+            add_io_api_record_Redland(config, fields, duration_);
+            for (int i = 0; i < count; i++) {
+                snprintf(fields->data_object, sizeof(fields->data_object), "%s", items[i].data_object);
+                add_data_obj_record_Redland(config, fields);
+                if (!config->enable_api_prov)
+                    continue;
+                snprintf(transfer, sizeof(transfer), "%s--%s", fields->io_api, items[i].data_object);
+                snprintf(bytes, sizeof(bytes), "%lu", items[i].io_bytes);
+                add_statement_Redland(transfer, "prov:type",
+                    librdf_new_node_from_uri_string(world, (const unsigned char*)"provio:Transfer"));
+                add_statement_Redland(transfer, "provio:partOf",
+                    librdf_new_node_from_uri_string(world, (const unsigned char*)fields->io_api));
+                add_statement_Redland(transfer, "provio:onDataObject",
+                    librdf_new_node_from_uri_string(world, (const unsigned char*)items[i].data_object));
+                add_statement_Redland(transfer, "provio:bytes",
+                    librdf_new_node_from_literal(world, (const unsigned char*)bytes, NULL, 0));
+            }
+#endif
+        }
+        else {
+            if (config->enable_legacy_graph)
+                fputs(pline, helper_in->legacy_prov_file_handle);
+            fputs(pline, helper_in->new_prov_file_handle);
+        }
+    }
+    if (config->prov_level == File_and_print || config->prov_level == Print_only)
+        printf("%s", pline);
+
+    prov_stat.PROV_WRITE_TOTAL_TIME += (get_time_usec() - start);
+
+    return 0;
+}
+
+/* Cross-rank dependency on a data object, kind is RAW, WAR or WAW.
+ * from_rank accessed the overlapping region first, to_rank after it. */
+int add_dependency_record(prov_config* config, provio_helper_t* helper_in, prov_fields* fields,
+        const char* data_object, const char* kind, int from_rank, int to_rank, int count) {
+    unsigned long start = get_time_usec();
+    char pline[1024];
+
+    assert(helper_in);
+    assert(fields);
+
+    snprintf(pline, sizeof(pline), "%s %s MPI_rank_%d -> MPI_rank_%d x%d\n",
+        kind, data_object, from_rank, to_rank, count);
+
+    if (config->prov_level == File_only || config->prov_level == File_and_print) {
+        if(!strcmp(config->prov_line_format, "rdf") || !strcmp(config->prov_line_format, "RDF")) {
+#ifdef LIBRDF_H
+            char dep[1024];
+            char rank_[128];
+            char count_[32];
+
+            snprintf(dep, sizeof(dep), "%s--%s--%d-%d", kind, data_object, from_rank, to_rank);
+            add_statement_Redland(dep, "prov:type",
+                librdf_new_node_from_uri_string(world, (const unsigned char*)"provio:Dependency"));
+            add_statement_Redland(dep, "provio:dependencyKind",
+                librdf_new_node_from_literal(world, (const unsigned char*)kind, NULL, 0));
+            add_statement_Redland(dep, "provio:onDataObject",
+                librdf_new_node_from_uri_string(world, (const unsigned char*)data_object));
+            snprintf(rank_, sizeof(rank_), "MPI_rank_%d", from_rank);
+            add_statement_Redland(dep, "provio:fromRank",
+                librdf_new_node_from_uri_string(world, (const unsigned char*)rank_));
+            snprintf(rank_, sizeof(rank_), "MPI_rank_%d", to_rank);
+            add_statement_Redland(dep, "provio:toRank",
+                librdf_new_node_from_uri_string(world, (const unsigned char*)rank_));
+            snprintf(count_, sizeof(count_), "%d", count);
+            add_statement_Redland(dep, "provio:occurrences",
+                librdf_new_node_from_literal(world, (const unsigned char*)count_, NULL, 0));
+#endif
+        }
+        else {
+            if (config->enable_legacy_graph)
+                fputs(pline, helper_in->legacy_prov_file_handle);
+            fputs(pline, helper_in->new_prov_file_handle);
+        }
+    }
+    if (config->prov_level == File_and_print || config->prov_level == Print_only)
+        printf("%s", pline);
+
+    prov_stat.PROV_WRITE_TOTAL_TIME += (get_time_usec() - start);
+
+    return 0;
+}
+
+
+/* One summary activity per closed object and rank, carrying its counters
+ * instead of a record for every call */
+int add_summary_record(prov_config* config, provio_helper_t* helper_in, prov_fields* fields,
+        const char* data_object, const char* type, const char* file_name,
+        const prov_summary_item* items, int count) {
+    unsigned long start = get_time_usec();
+    char pline[2048];
+    int len;
+
+    assert(helper_in);
+    assert(fields);
+
+    len = snprintf(pline, sizeof(pline), "SUMMARY %s %s %s", type, file_name, data_object);
+    for (int i = 0; i < count && len < (int)sizeof(pline); i++)
+        len += snprintf(pline + len, sizeof(pline) - len, " %s=%s", items[i].name, items[i].value);
+    if (len >= (int)sizeof(pline) - 1)
+        len = sizeof(pline) - 2;
+    pline[len] = '\n';
+    pline[len + 1] = '\0';
+
+    if (config->prov_level == File_only || config->prov_level == File_and_print) {
+        if(!strcmp(config->prov_line_format, "rdf") || !strcmp(config->prov_line_format, "RDF")) {
+#ifdef LIBRDF_H
+            char summary[1024];
+            char predicate[128];
+
+            snprintf(summary, sizeof(summary), "summary--%s--%s--%s", file_name, data_object, fields->mpi_rank);
+            add_statement_Redland(summary, "prov:type",
+                librdf_new_node_from_uri_string(world, (const unsigned char*)"provio:Summary"));
+            add_statement_Redland(summary, "provio:onDataObject",
+                librdf_new_node_from_uri_string(world, (const unsigned char*)data_object));
+            add_statement_Redland(summary, "provio:objectType",
+                librdf_new_node_from_uri_string(world, (const unsigned char*)type));
+            add_statement_Redland(summary, "provio:inFile",
+                librdf_new_node_from_uri_string(world, (const unsigned char*)file_name));
+            add_statement_Redland(summary, "prov:wasAssociatedWith",
+                librdf_new_node_from_uri_string(world, (const unsigned char*)fields->mpi_rank));
+            for (int i = 0; i < count; i++) {
+                snprintf(predicate, sizeof(predicate), "provio:%s", items[i].name);
+                add_statement_Redland(summary, predicate,
+                    librdf_new_node_from_literal(world, (const unsigned char*)items[i].value, NULL, 0));
+            }
+#endif
+        }
+        else {
+            if (config->enable_legacy_graph)
+                fputs(pline, helper_in->legacy_prov_file_handle);
+            fputs(pline, helper_in->new_prov_file_handle);
+        }
+    }
+    if (config->prov_level == File_and_print || config->prov_level == Print_only)
+        printf("%s", pline);
+
+    prov_stat.PROV_WRITE_TOTAL_TIME += (get_time_usec() - start);
+
+    return 0;
+}
+
+/* Write pline unless the records go to an RDF graph */
+static void add_summary_line(prov_config* config, provio_helper_t* helper_in, const char* pline, int rdf) {
+    if ((config->prov_level == File_only || config->prov_level == File_and_print) && !rdf) {
+        if (config->enable_legacy_graph)
+            fputs(pline, helper_in->legacy_prov_file_handle);
+        fputs(pline, helper_in->new_prov_file_handle);
+    }
+    if (config->prov_level == File_and_print || config->prov_level == Print_only)
+        printf("%s", pline);
+}
+
+/* Summary of the merged sketches: distinct objects of the program and of
+ * every file, then the objects that moved the most bytes. Byte counts are
+ * upper estimates, provio:bytesErrorBound is the largest overestimate
+ * expected (e/width of all bytes). */
+static void add_sketch_records(prov_config* config, provio_helper_t* helper_in, prov_fields* fields) {
+    unsigned long start = get_time_usec();
+    int rdf = !strcmp(config->prov_line_format, "rdf") || !strcmp(config->prov_line_format, "RDF");
+#ifdef LIBRDF_H
+    int to_graph = rdf && (config->prov_level == File_only || config->prov_level == File_and_print);
+#endif
+    char pline[2048];
+    char value[64];
+    char bound[64];
+
+    snprintf(value, sizeof(value), "%.0f", sketch_hll_count(SKETCH_PROGRAM));
+    snprintf(pline, sizeof(pline), "DISTINCT %s %s\n", fields->proc_name, value);
+    add_summary_line(config, helper_in, pline, rdf);
+#ifdef LIBRDF_H
+    if (to_graph)
+        add_statement_Redland(fields->proc_name, "provio:distinctObjects",
+            librdf_new_node_from_literal(world, (const unsigned char*)value, NULL, 0));
+#endif
+
+    for (file_sketch* f = SKETCH_FILES; f; f = f->next) {
+        snprintf(value, sizeof(value), "%.0f", sketch_hll_count(&f->hll));
+        snprintf(pline, sizeof(pline), "DISTINCT %s %s\n", f->name, value);
+        add_summary_line(config, helper_in, pline, rdf);
+#ifdef LIBRDF_H
+        if (to_graph)
+            add_statement_Redland(f->name, "provio:distinctObjects",
+                librdf_new_node_from_literal(world, (const unsigned char*)value, NULL, 0));
+#endif
+    }
+
+    snprintf(bound, sizeof(bound), "%.0f", 2.718281828 * SKETCH_BYTES->total / SKETCH_CMS_WIDTH);
+    sketch_top_sort(&SKETCH_TOP);
+    for (int i = 0; i < SKETCH_TOP.size; i++) {
+        const sketch_hitter* h = &SKETCH_TOP.heap[i];
+
+        snprintf(value, sizeof(value), "%lu", (unsigned long)h->estimate);
+        snprintf(pline, sizeof(pline), "HOT %d %s %s %s bytes (over by <= %s)\n",
+            i + 1, h->file, h->name, value, bound);
+        add_summary_line(config, helper_in, pline, rdf);
+#ifdef LIBRDF_H
+        if (to_graph) {
+            char hot[1024];
+            char rank_[32];
+
+            snprintf(hot, sizeof(hot), "hot--%s--%s", h->file, h->name);
+            snprintf(rank_, sizeof(rank_), "%d", i + 1);
+            add_statement_Redland(hot, "prov:type",
+                librdf_new_node_from_uri_string(world, (const unsigned char*)"provio:HotObject"));
+            add_statement_Redland(hot, "provio:onDataObject",
+                librdf_new_node_from_uri_string(world, (const unsigned char*)h->name));
+            add_statement_Redland(hot, "provio:inFile",
+                librdf_new_node_from_uri_string(world, (const unsigned char*)h->file));
+            add_statement_Redland(hot, "provio:hotRank",
+                librdf_new_node_from_literal(world, (const unsigned char*)rank_, NULL, 0));
+            add_statement_Redland(hot, "provio:bytes",
+                librdf_new_node_from_literal(world, (const unsigned char*)value, NULL, 0));
+            add_statement_Redland(hot, "provio:bytesErrorBound",
+                librdf_new_node_from_literal(world, (const unsigned char*)bound, NULL, 0));
+        }
+#endif
+    }
+
+    prov_stat.PROV_WRITE_TOTAL_TIME += (get_time_usec() - start);
+}
+
+
 void provio_helper_teardown(prov_config* config, provio_helper_t* helper, prov_fields* fields){
-    get_time_str(fields->proc_end_time);
+    /* Measure the offset again to estimate clock drift over the run. This is
+     * collective, skip it when MPI has already been finalized. */
+    if (config->enable_clock_sync) {
+        int initialized, finalized;
+        MPI_Initialized(&initialized);
+        MPI_Finalized(&finalized);
+        if (initialized && !finalized) {
+            unsigned long sync_time;
+            long offset = clock_sync(config, fields, &sync_time);
+            /* Shorter runs are dominated by measurement noise */
+            if (sync_time > fields->clock_sync_time + 1000000)
+                fields->clock_drift = (double)(offset - fields->clock_offset) /
+                    (double)(sync_time - fields->clock_sync_time);
+        }
+    }
+
+    /* Merging the sketches is collective too */
+    if (SKETCH_BYTES) {
+        sketch_reduce(fields);
+        if (fields->mpi_rank_int == 0)
+            add_sketch_records(config, helper, fields);
+        sketch_free();
+    }
+
+    get_time_str(fields, fields->proc_end_time);
     add_program_record(config, fields);
 
+    if (helper->shard_file_handle) {
+        /* Redland: serialize this run's shard and register it in the manifest */
+        unsigned long start = get_time_usec();
+        int num_triples = 0;
+#ifdef LIBRDF_H
+        librdf_serializer_serialize_model_to_file_handle(serializer,
+            helper->shard_file_handle, NULL, model_prov);
+        num_triples = librdf_model_size(model_prov);
+#endif
+        fclose(helper->shard_file_handle);
+        if (append_shard_manifest(config, helper, fields,
+            provio_global_time(fields, get_time_usec()), num_triples) < 0)
+            fprintf(stderr, "Failed to add shard %s to manifest in %s\n",
+                helper->shard_name, config->shard_repo_path);
+        prov_stat.PROV_SERIALIZE_TIME += (get_time_usec() - start);
+
+        for (int i = 0; i < helper->num_files_touched; i++)
+            free(helper->files_touched[i]);
+        free(helper->files_touched);
+        free(helper->shard_name);
+    }
+
     if (helper->legacy_prov_file_handle || helper->new_prov_file_handle) {
         /* Redland: serialize to file */
         unsigned long start = get_time_usec();
@@ -605,10 +1874,40 @@ void provio_helper_teardown(prov_config* config, provio_helper_t* helper, prov_f
         prov_stat.PROV_SERIALIZE_TIME += (get_time_usec() - start);
     }
 
+    stat_shm_close();
+    stat_series_close();
+    stat_perf_close();
+
+    /* Every rank appends its own record */
+    if (config->enable_stat_record && config->stat_record_path) {
+        char program[1024];
+        char* uuid_;
+        stat_record_info info;
+
+        // proc_name carries the process UUID after "--"
+        snprintf(program, sizeof(program), "%s", fields->proc_name);
+        uuid_ = strstr(program, "--");
+        if (uuid_)
+            *uuid_ = '\0';
+        info.run_id = fields->run_id;
+        info.rank = fields->mpi_rank_int;
+        info.nprocs = fields->mpi_size;
+        info.config_hash = config->config_hash;
+        info.program = program;
+        info.start_time = fields->start_time;
+        info.end_time = provio_global_time(fields, get_time_usec());
+        if (stat_record_write(config->stat_record_path, config->stat_record_binary,
+            &info, FUNCTION_FREQUENCY) < 0)
+            fprintf(stderr, "Failed to write statistics record to %s\n", config->stat_record_path);
+    }
+
     char pline[2048];
     if (fields->mpi_rank_int == 0) {
         if (helper->stat_file_handle != NULL) {
-            stat_print_(0, &prov_stat, FUNCTION_FREQUENCY, helper->stat_file_handle);
+            Stat total;
+
+            stat_blocks_sum(&total, NULL);
+            stat_print_(0, &total, FUNCTION_FREQUENCY, helper->stat_file_handle);
         }
         else {
             printf("%s", pline);
@@ -11,6 +11,7 @@
 
 #include "config.h"
 #include "stat.h"
+#include "sketch.h"
 
 
 
@@ -18,6 +19,13 @@ typedef struct PROVIOHelper {
     FILE* legacy_prov_file_handle;
     FILE* new_prov_file_handle;
     FILE* stat_file_handle;
+    /* Append-only shard repository */
+    FILE* shard_file_handle;
+    char* shard_name;                   // shard file name, relative to the repository
+    char** files_touched;               // distinct files recorded in this shard
+    int num_files_touched;
+    int max_files_touched;
+    unsigned long shard_start_time;     // us since epoch
 } provio_helper_t;
 
 
@@ -40,11 +48,35 @@ typedef struct prov_fields {
     unsigned long duration;             // I/O API duration
     char type[128];                     // Data object type: Group/Dataset/Attr/Datatype
     char relation[128];                 // relation between data object and I/O API
+    unsigned long timestamp;            // I/O API start time on rank 0's clock (us)
+    long clock_offset;                  // add to local clock to get rank 0's clock (us)
+    double clock_drift;                 // local clock drift against rank 0 (us per us)
+    unsigned long clock_sync_time;      // local time the offset was measured at (us)
+    char file_name[512];                // File of the data object, if known
+    unsigned long io_bytes;             // Bytes moved by the I/O API
+    int mpi_size;
+    char run_id[64];                    // Same on all ranks, set with ENABLE_STAT_RECORD
+    unsigned long start_time;           // us since epoch on rank 0's clock
 } prov_fields;
 
 
-/* statistics */
-Stat prov_stat;
+/* One counter of a summary record, see add_summary_record() */
+typedef struct prov_summary_item {
+    const char* name;                   // provio:<name> in RDF
+    char value[64];
+} prov_summary_item;
+
+
+/* One dataset of a multi-dataset call, see add_batch_record() */
+typedef struct prov_batch_item {
+    const char* data_object;
+    const char* file_name;
+    unsigned long io_bytes;
+} prov_batch_item;
+
+
+/* statistics, prov_stat is the calling thread's counters */
+#define prov_stat (stat_local_block()->prov)
 duration_ht* FUNCTION_FREQUENCY;
 
 /* User APIs */
@@ -58,9 +90,23 @@ void provio_helper_teardown(prov_config* config, provio_helper_t* helper, prov_f
 void prov_fill_data_object(prov_fields* fields, const char* obj_name, const char* type);
 void prov_fill_relation(prov_fields* fields, const char* relation);
 void prov_fill_io_api(prov_fields* fields, const char* io_api, unsigned long duration);
+// File and bytes moved of the next record, used by the object sketches
+void prov_fill_file(prov_fields* fields, const char* file_name);
+void prov_fill_io_bytes(prov_fields* fields, unsigned long bytes);
 
 int add_prov_record(prov_config* config, provio_helper_t* helper_in, prov_fields* fields);
+// One record for a call on several data objects, io_api and timing in fields
+int add_batch_record(prov_config* config, provio_helper_t* helper_in, prov_fields* fields,
+        const prov_batch_item* items, int count);
+// Called with the fields of every record added, NULL to stop
+void provio_set_record_hook(void (*hook)(const prov_fields* fields));
 int add_program_record(prov_config* config, prov_fields* fields);
+int add_dependency_record(prov_config* config, provio_helper_t* helper_in, prov_fields* fields,
+        const char* data_object, const char* kind, int from_rank, int to_rank, int count);
+// Aggregated counters of a data object, written when it is closed
+int add_summary_record(prov_config* config, provio_helper_t* helper_in, prov_fields* fields,
+        const char* data_object, const char* type, const char* file_name,
+        const prov_summary_item* items, int count);
 // int add_user_record_Redland(prov_config* config, prov_fields* fields);
 // int add_mpi_rank_record_Redland(prov_config* config, prov_fields* fields);
 // int add_program_record_Redland(prov_config* config, prov_fields* fields);
@@ -68,7 +114,11 @@ int add_program_record(prov_config* config, prov_fields* fields);
 // int add_io_api_record_Redland(prov_config* config, prov_fields* fields, char* time, char* duration_);
 // int add_data_obj_record_Redland(prov_config* config, prov_fields* fields);
 
+// Local time (us) converted to rank 0's clock
+unsigned long provio_global_time(prov_fields* fields, unsigned long local_time);
+
 // function level stat helper
 void func_stat(const char* func_name, unsigned long elapsed);
+void func_stat_id(int func_id, unsigned long native, unsigned long overhead);
 
 #endif 
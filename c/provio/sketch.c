@@ -0,0 +1,264 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sketch.h"
+
+
+#define FNV_OFFSET 14695981039346656037UL
+#define FNV_PRIME 1099511628211UL
+
+static uint64_t fnv_add(uint64_t hash, const char* str) {
+    for (const char* p = str; *p; p++) {
+        hash ^= (uint64_t)(unsigned char)(*p);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/* FNV-1a spreads short names poorly over the high bits, finish with the
+ * splitmix64 mixer before they are used as register indexes */
+uint64_t sketch_hash(const char* file, const char* name) {
+    uint64_t hash = FNV_OFFSET;
+
+    if (file)
+        hash = fnv_add(hash, file);
+    hash ^= 0xff;   // separator, no name byte has this value in UTF-8
+    hash *= FNV_PRIME;
+    if (name)
+        hash = fnv_add(hash, name);
+
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9UL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebUL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+/* Row i uses h1 + i * h2, two halves of one hash are as good as
+ * independent hash functions here (Kirsch and Mitzenmacher) */
+static inline uint32_t cms_index(uint64_t key, int row) {
+    uint32_t h1 = (uint32_t)key;
+    uint32_t h2 = (uint32_t)(key >> 32) | 1;
+    return (h1 + (uint32_t)row * h2) & (SKETCH_CMS_WIDTH - 1);
+}
+
+void sketch_cms_add(sketch_cms* cms, uint64_t key, uint64_t weight) {
+    for (int i = 0; i < SKETCH_CMS_DEPTH; i++)
+        cms->count[i][cms_index(key, i)] += weight;
+    cms->total += weight;
+}
+
+uint64_t sketch_cms_estimate(const sketch_cms* cms, uint64_t key) {
+    uint64_t min = UINT64_MAX;
+
+    for (int i = 0; i < SKETCH_CMS_DEPTH; i++) {
+        uint64_t c = cms->count[i][cms_index(key, i)];
+        if (c < min)
+            min = c;
+    }
+    return min;
+}
+
+void sketch_cms_merge(sketch_cms* dst, const sketch_cms* src) {
+    for (int i = 0; i < SKETCH_CMS_DEPTH; i++)
+        for (int j = 0; j < SKETCH_CMS_WIDTH; j++)
+            dst->count[i][j] += src->count[i][j];
+    dst->total += src->total;
+}
+
+int sketch_top_init(sketch_top* top, int capacity) {
+    uint32_t nslots = 2;
+
+    top->size = 0;
+    top->capacity = capacity > 0 ? capacity : 0;
+    top->heap = NULL;
+    top->slots = NULL;
+    top->slot_mask = 0;
+    if (top->capacity) {
+        // At most half full, probes stay short
+        while (nslots < 2 * (uint32_t)top->capacity)
+            nslots <<= 1;
+        top->heap = calloc(top->capacity, sizeof(sketch_hitter));
+        top->slots = calloc(nslots, sizeof(int));
+        if (top->heap == NULL || top->slots == NULL) {
+            free(top->heap);
+            free(top->slots);
+            top->heap = NULL;
+            top->slots = NULL;
+            top->capacity = 0;
+            return -1;
+        }
+        top->slot_mask = nslots - 1;
+    }
+    return 0;
+}
+
+void sketch_top_free(sketch_top* top) {
+    free(top->heap);
+    free(top->slots);
+    top->heap = NULL;
+    top->slots = NULL;
+    top->size = top->capacity = 0;
+}
+
+/* Slot of key, or the free slot where it would go. Keys come out of
+ * sketch_hash and are already mixed, their low bits are the home slot. */
+static int* top_slot(const sketch_top* top, uint64_t key) {
+    uint32_t i = (uint32_t)key & top->slot_mask;
+
+    while (top->slots[i] && top->heap[top->slots[i] - 1].key != key)
+        i = (i + 1) & top->slot_mask;
+    return &top->slots[i];
+}
+
+// Backward shift deletion, no tombstones
+static void top_slot_remove(sketch_top* top, int* slot) {
+    uint32_t hole = (uint32_t)(slot - top->slots);
+    uint32_t i = hole;
+
+    for (;;) {
+        uint32_t home;
+
+        i = (i + 1) & top->slot_mask;
+        if (!top->slots[i])
+            break;
+        // Moves back unless its home is cyclically in (hole, i]
+        home = (uint32_t)top->heap[top->slots[i] - 1].key & top->slot_mask;
+        if (((i - home) & top->slot_mask) >= ((i - hole) & top->slot_mask)) {
+            top->slots[hole] = top->slots[i];
+            hole = i;
+        }
+    }
+    top->slots[hole] = 0;
+}
+
+static void top_swap(sketch_top* top, int a, int b) {
+    sketch_hitter tmp;
+
+    *top_slot(top, top->heap[a].key) = b + 1;
+    *top_slot(top, top->heap[b].key) = a + 1;
+    tmp = top->heap[a];
+    top->heap[a] = top->heap[b];
+    top->heap[b] = tmp;
+}
+
+static void top_sift_up(sketch_top* top, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (top->heap[parent].estimate <= top->heap[i].estimate)
+            break;
+        top_swap(top, i, parent);
+        i = parent;
+    }
+}
+
+static void top_sift_down(sketch_top* top, int i) {
+    for (;;) {
+        int smallest = i;
+        int l = 2 * i + 1;
+        int r = l + 1;
+
+        if (l < top->size && top->heap[l].estimate < top->heap[smallest].estimate)
+            smallest = l;
+        if (r < top->size && top->heap[r].estimate < top->heap[smallest].estimate)
+            smallest = r;
+        if (smallest == i)
+            return;
+        top_swap(top, i, smallest);
+        i = smallest;
+    }
+}
+
+static void hitter_set(sketch_hitter* h, uint64_t key, uint64_t estimate,
+        const char* name, const char* file) {
+    h->key = key;
+    h->estimate = estimate;
+    snprintf(h->name, sizeof(h->name), "%s", name ? name : "");
+    snprintf(h->file, sizeof(h->file), "%s", file ? file : "");
+}
+
+void sketch_top_offer(sketch_top* top, uint64_t key, uint64_t estimate,
+        const char* name, const char* file) {
+    int* slot;
+
+    if (!top->capacity)
+        return;
+
+    // Estimates only grow, an object already kept moves down towards the leaves
+    slot = top_slot(top, key);
+    if (*slot) {
+        int i = *slot - 1;
+        if (estimate > top->heap[i].estimate) {
+            top->heap[i].estimate = estimate;
+            top_sift_down(top, i);
+        }
+        return;
+    }
+
+    if (top->size < top->capacity) {
+        *slot = top->size + 1;
+        hitter_set(&top->heap[top->size], key, estimate, name, file);
+        top_sift_up(top, top->size++);
+    }
+    else if (estimate > top->heap[0].estimate) {
+        // The removal may shift the free slot found above
+        top_slot_remove(top, top_slot(top, top->heap[0].key));
+        *top_slot(top, key) = 1;
+        hitter_set(&top->heap[0], key, estimate, name, file);
+        top_sift_down(top, 0);
+    }
+}
+
+static int hitter_cmp(const void* a, const void* b) {
+    const sketch_hitter* x = a;
+    const sketch_hitter* y = b;
+
+    if (x->estimate != y->estimate)
+        return x->estimate < y->estimate ? 1 : -1;
+    return strcmp(x->name, y->name);
+}
+
+void sketch_top_sort(sketch_top* top) {
+    qsort(top->heap, top->size, sizeof(sketch_hitter), hitter_cmp);
+    if (!top->capacity)
+        return;
+    memset(top->slots, 0, (top->slot_mask + 1) * sizeof(int));
+    for (int i = 0; i < top->size; i++)
+        *top_slot(top, top->heap[i].key) = i + 1;
+}
+
+/* The first SKETCH_HLL_BITS bits pick the register, which keeps the
+ * position of the first set bit in the rest */
+void sketch_hll_add(sketch_hll* hll, uint64_t key) {
+    uint32_t index = (uint32_t)(key >> (64 - SKETCH_HLL_BITS));
+    uint64_t rest = key << SKETCH_HLL_BITS;
+    uint8_t rank = rest ? (uint8_t)(__builtin_clzll(rest) + 1) : (uint8_t)(64 - SKETCH_HLL_BITS + 1);
+
+    if (rank > hll->reg[index])
+        hll->reg[index] = rank;
+}
+
+void sketch_hll_merge(sketch_hll* dst, const sketch_hll* src) {
+    for (int i = 0; i < SKETCH_HLL_REGS; i++)
+        if (src->reg[i] > dst->reg[i])
+            dst->reg[i] = src->reg[i];
+}
+
+double sketch_hll_count(const sketch_hll* hll) {
+    const double m = SKETCH_HLL_REGS;
+    double sum = 0, estimate;
+    int zeros = 0;
+
+    for (int i = 0; i < SKETCH_HLL_REGS; i++) {
+        sum += ldexp(1.0, -hll->reg[i]);
+        zeros += hll->reg[i] == 0;
+    }
+    estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    // Small cardinalities: linear counting of the empty registers
+    if (estimate <= 2.5 * m && zeros)
+        estimate = m * log(m / zeros);
+    return estimate;
+}
@@ -0,0 +1,64 @@
+#ifndef _PROVIO_INCLUDE_SKETCH_H_
+#define _PROVIO_INCLUDE_SKETCH_H_
+
+#include <stdint.h>
+
+
+/* Fixed-size summaries of the recorded data objects, whatever their number:
+ * - a count-min sketch of the bytes moved per object. It never underestimates
+ *   and overestimates by at most e/SKETCH_CMS_WIDTH of all bytes with
+ *   probability 1 - e^-SKETCH_CMS_DEPTH,
+ * - the objects with the largest estimates (heavy hitters) in a min-heap,
+ * - HyperLogLog counts of distinct objects, standard error
+ *   1.04/sqrt(SKETCH_HLL_REGS).
+ * Sketches of different ranks merge by adding counters and keeping the
+ * larger register. Objects are keyed by sketch_hash(file, name). */
+#define SKETCH_CMS_DEPTH 4
+#define SKETCH_CMS_WIDTH 4096       // power of two
+#define SKETCH_HLL_BITS 12
+#define SKETCH_HLL_REGS (1 << SKETCH_HLL_BITS)
+#define SKETCH_NAME_LEN 256
+
+typedef struct sketch_cms {
+    uint64_t total;                 // all bytes added
+    uint64_t count[SKETCH_CMS_DEPTH][SKETCH_CMS_WIDTH];
+} sketch_cms;
+
+typedef struct sketch_hitter {
+    uint64_t key;
+    uint64_t estimate;              // bytes, count-min estimate when offered
+    char name[SKETCH_NAME_LEN];
+    char file[SKETCH_NAME_LEN];
+} sketch_hitter;
+
+typedef struct sketch_top {
+    int size;
+    int capacity;
+    sketch_hitter* heap;            // min-heap on estimate
+    int* slots;                     // key -> heap index + 1, 0 if free, linear probing
+    uint32_t slot_mask;
+} sketch_top;
+
+typedef struct sketch_hll {
+    uint8_t reg[SKETCH_HLL_REGS];
+} sketch_hll;
+
+uint64_t sketch_hash(const char* file, const char* name);
+
+void sketch_cms_add(sketch_cms* cms, uint64_t key, uint64_t weight);
+uint64_t sketch_cms_estimate(const sketch_cms* cms, uint64_t key);
+void sketch_cms_merge(sketch_cms* dst, const sketch_cms* src);
+
+int sketch_top_init(sketch_top* top, int capacity);
+void sketch_top_free(sketch_top* top);
+// Keeps key if it is among the capacity largest estimates seen so far
+void sketch_top_offer(sketch_top* top, uint64_t key, uint64_t estimate,
+        const char* name, const char* file);
+// Orders heap by decreasing estimate, the heap property is lost
+void sketch_top_sort(sketch_top* top);
+
+void sketch_hll_add(sketch_hll* hll, uint64_t key);
+void sketch_hll_merge(sketch_hll* dst, const sketch_hll* src);
+double sketch_hll_count(const sketch_hll* hll);
+
+#endif
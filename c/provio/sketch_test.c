@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "sketch.h"
+
+
+#define OBJECTS 2000
+#define PASSES 10
+#define TOP 20
+
+// Zipf-like stream: object i moves 1e6/(i+1) bytes, spread over PASSES records
+uint64_t object_bytes(int i) {
+	return 1000000 / (i + 1);
+}
+
+void object_name(int i, char* name, size_t len) {
+	snprintf(name, len, "/group/obj_%d", i);
+}
+
+void test_skewed_stream() {
+	static sketch_cms cms, half[2];
+	sketch_top top;
+	char name[64];
+	uint64_t key, est, total = 0;
+	int over = 0;
+
+	memset(&cms, 0, sizeof(cms));
+	memset(half, 0, sizeof(half));
+	assert(sketch_top_init(&top, TOP) == 0);
+
+	for(int pass = 0; pass < PASSES; pass++) {
+		for(int i = 0; i < OBJECTS; i++) {
+			object_name(i, name, sizeof(name));
+			key = sketch_hash("skewed.h5", name);
+			sketch_cms_add(&cms, key, object_bytes(i) / PASSES);
+			sketch_cms_add(&half[i % 2], key, object_bytes(i) / PASSES);
+			sketch_top_offer(&top, key, sketch_cms_estimate(&cms, key), name, "skewed.h5");
+		}
+	}
+	for(int i = 0; i < OBJECTS; i++)
+		total += object_bytes(i) / PASSES * PASSES;
+	assert(cms.total == total);
+
+	// Never below the truth, above it by more than e/SKETCH_CMS_WIDTH of all
+	// bytes for about e^-SKETCH_CMS_DEPTH (2%) of the objects
+	sketch_cms_merge(&half[0], &half[1]);
+	for(int i = 0; i < OBJECTS; i++) {
+		object_name(i, name, sizeof(name));
+		key = sketch_hash("skewed.h5", name);
+		est = sketch_cms_estimate(&cms, key);
+		assert(est >= object_bytes(i) / PASSES * PASSES);
+		if(est - object_bytes(i) / PASSES * PASSES > M_E / SKETCH_CMS_WIDTH * total)
+			over++;
+		assert(sketch_cms_estimate(&half[0], key) == est);
+	}
+	assert(over <= OBJECTS / 20);
+
+	// The heaviest objects are kept, the largest first once sorted. Their
+	// sizes differ by more than the error bound, so the order is exact.
+	assert(top.size == TOP);
+	sketch_top_sort(&top);
+	for(int i = 0; i < 10; i++) {
+		object_name(i, name, sizeof(name));
+		assert(strcmp(top.heap[i].name, name) == 0);
+		assert(strcmp(top.heap[i].file, "skewed.h5") == 0);
+		assert(top.heap[i].estimate >= object_bytes(i) / PASSES * PASSES);
+	}
+	sketch_top_free(&top);
+}
+
+void test_top_eviction() {
+	sketch_top top;
+
+	assert(sketch_top_init(&top, 3) == 0);
+	sketch_top_offer(&top, 1, 10, "a", "f");
+	sketch_top_offer(&top, 2, 20, "b", "f");
+	sketch_top_offer(&top, 3, 30, "c", "f");
+	assert(top.size == 3 && top.heap[0].key == 1);
+
+	// Not above the smallest, dropped
+	sketch_top_offer(&top, 4, 5, "d", "f");
+	assert(top.size == 3 && top.heap[0].key == 1);
+
+	// Evicts the smallest
+	sketch_top_offer(&top, 5, 40, "e", "f");
+	assert(top.heap[0].key == 2);
+
+	// A kept object grows in place, a smaller estimate is ignored
+	sketch_top_offer(&top, 2, 50, "b", "f");
+	sketch_top_offer(&top, 5, 1, "e", "f");
+	assert(top.size == 3 && top.heap[0].key == 3);
+
+	sketch_top_sort(&top);
+	assert(top.heap[0].key == 2 && top.heap[0].estimate == 50);
+	assert(top.heap[1].key == 5 && top.heap[1].estimate == 40);
+	assert(top.heap[2].key == 3 && top.heap[2].estimate == 30);
+	sketch_top_free(&top);
+
+	// Nothing is kept without room
+	assert(sketch_top_init(&top, 0) == 0);
+	sketch_top_offer(&top, 1, 10, "a", "f");
+	assert(top.size == 0);
+	sketch_top_free(&top);
+}
+
+/* Many objects growing in turns: the heap always holds the capacity
+ * largest current estimates */
+void test_top_many() {
+	enum { KEYS = 20000, CAP = 100 };
+	static uint64_t last[KEYS];
+	sketch_top top;
+	uint64_t key, est, min;
+	int kept = 0;
+
+	assert(sketch_top_init(&top, CAP) == 0);
+	for(int round = 1; round <= 3; round++) {
+		for(int i = 0; i < KEYS; i++) {
+			key = sketch_hash("many.h5", NULL) + (uint64_t)i * 0x9e3779b97f4a7c15UL;
+			// Distinct estimates that grow with the round
+			est = (uint64_t)round * KEYS * KEYS + (key % KEYS) * KEYS + i;
+			if(i % round == 0) {
+				sketch_top_offer(&top, key, est, "", "many.h5");
+				last[i] = est;
+			}
+		}
+	}
+	assert(top.size == CAP);
+
+	min = top.heap[0].estimate;
+	for(int i = 1; i < top.size; i++) {
+		assert(top.heap[i].estimate >= top.heap[(i - 1) / 2].estimate);
+		for(int j = 0; j < i; j++)
+			assert(top.heap[i].key != top.heap[j].key);
+	}
+	for(int i = 0; i < KEYS; i++)
+		kept += last[i] >= min;
+	assert(kept == CAP);
+	sketch_top_free(&top);
+}
+
+void test_hll() {
+	static sketch_hll all, half[2];
+	double count;
+
+	memset(&all, 0, sizeof(all));
+	memset(half, 0, sizeof(half));
+	assert(sketch_hll_count(&all) == 0);
+
+	// Small counts use linear counting, large ones the harmonic mean;
+	// three standard errors is 1.04 * 3 / sqrt(SKETCH_HLL_REGS), 4.9%
+	for(int i = 0; i < 100000; i++) {
+		char name[64];
+		object_name(i, name, sizeof(name));
+		// Every object twice, duplicates do not count
+		for(int j = 0; j < 2; j++) {
+			sketch_hll_add(&all, sketch_hash("hll.h5", name));
+			sketch_hll_add(&half[i % 2], sketch_hash("hll.h5", name));
+		}
+		if(i + 1 == 1000) {
+			count = sketch_hll_count(&all);
+			assert(fabs(count - 1000) < 0.049 * 1000);
+		}
+	}
+	count = sketch_hll_count(&all);
+	assert(fabs(count - 100000) < 0.049 * 100000);
+
+	sketch_hll_merge(&half[0], &half[1]);
+	assert(memcmp(&half[0], &all, sizeof(all)) == 0);
+}
+
+int main() {
+	test_skewed_stream();
+	test_top_eviction();
+	test_top_many();
+	test_hll();
+	return 0;
+}
@@ -1,71 +1,567 @@
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
-#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define STAT_HAVE_TSC 1
+#endif
+#ifdef __linux__
+#include <errno.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#define STAT_HAVE_PERF 1
+#endif
 
 #include "stat.h"
 
 
-// To be modified later
-#define STAT_FUNC_MOD 733       //a reasonably big size to avoid expensive collision handling, make sure it works with 62 function names.
+#define STAT_COUNTS_CAPACITY 128    // per-thread name table until stat_create() is called
 
+// Callback names indexed by caller-assigned ids, see stat_func_table_init()
+static const char* const* FUNC_NAMES = NULL;
+static int FUNC_TABLE_SIZE = 0;
+// Connector pool names indexed by pool ids, see stat_pool_table_init()
+static const char* const* POOL_NAMES = NULL;
+static int POOL_TABLE_SIZE = 0;
+static size_t COUNTS_CAPACITY = STAT_COUNTS_CAPACITY;
 
-//shorten function id: use hash value
-static char** FUNC_DIC;
+// Per-thread blocks, pushed once and never unlinked
+__thread stat_block* STAT_LOCAL_BLOCK = NULL;
+static stat_block* STAT_BLOCKS = NULL;
+static stat_block STAT_FALLBACK_BLOCK;  // shared by threads that failed to allocate
+
+// live statistics segment, see stat_shm_open()
+static stat_shm_header* SHM_SEG = NULL;
+static size_t SHM_SIZE = 0;
+static char SHM_PATH[256];
+static int SHM_RANK = 0;
+static int SHM_ENABLED = 0;
+static unsigned long SHM_INTERVAL = 0;
+static unsigned long SHM_LAST = 0;
+
+// time series file, see stat_series_open()
+static FILE* SERIES_FILE = NULL;
+static char* SERIES_BUFFER = NULL;
+static int SERIES_RANK = 0;
+static long SERIES_OFFSET = 0;
+static unsigned long SERIES_INTERVAL = 0;
+static unsigned long SERIES_LAST = 0;
+static Stat SERIES_PREV_PROV;
+static Stat SERIES_PREV_CONNECTOR;
+static stat_hist* SERIES_PREV = NULL;   // native and overhead of every callback at the last row
+static int SERIES_PREV_CNT = 0;
+
+static int TICK_BUSY = 0;               // held by the one thread running stat_tick()
+
+static const struct {
+    const char* name;
+    size_t offset;
+} STAT_FIELDS[] = {
+    {"TOTAL_PROV_OVERHEAD", offsetof(Stat, TOTAL_PROV_OVERHEAD)},
+    {"TOTAL_NATIVE_H5_TIME", offsetof(Stat, TOTAL_NATIVE_H5_TIME)},
+    {"PROV_WRITE_TOTAL_TIME", offsetof(Stat, PROV_WRITE_TOTAL_TIME)},
+    {"FILE_LL_TOTAL_TIME", offsetof(Stat, FILE_LL_TOTAL_TIME)},
+    {"DS_LL_TOTAL_TIME", offsetof(Stat, DS_LL_TOTAL_TIME)},
+    {"GRP_LL_TOTAL_TIME", offsetof(Stat, GRP_LL_TOTAL_TIME)},
+    {"DT_LL_TOTAL_TIME", offsetof(Stat, DT_LL_TOTAL_TIME)},
+    {"ATTR_LL_TOTAL_TIME", offsetof(Stat, ATTR_LL_TOTAL_TIME)},
+    {"PROV_SERIALIZE_TIME", offsetof(Stat, PROV_SERIALIZE_TIME)},
+};
+
+// collective skew per dataset, in the order datasets were closed
+static coll_skew_entry* COLL_SKEW_HEAD = NULL;
+static coll_skew_entry* COLL_SKEW_TAIL = NULL;
+
+// requests of an async VOL below the connector, see stat_set_async()
+static stat_async_counts ASYNC;
+
+/* Timer anchor, get_time_usec() = usec + (ticks - tick) * usec_per_tick.
+ * Readers use ANCHORS[ANCHOR_CUR] while the re-anchoring thread fills the
+ * other slot and then switches ANCHOR_CUR. */
+typedef struct timer_anchor {
+    unsigned long tick;
+    unsigned long usec;
+    double usec_per_tick;
+} timer_anchor;
+
+static timer_anchor ANCHORS[2];
+static int ANCHOR_CUR = 0;
+static int ANCHOR_BUSY = 0;
+static int TIMER_READY = 0;
+static stat_timer_source TIMER_SOURCE = STAT_TIMER_MONOTONIC;
+static double TIMER_NS_PER_TICK = 1.0;  // calibrated rate
+static unsigned long TIMER_REANCHOR_TICKS = 0;
+static unsigned long TIMER_BASE_TICK = 0;   // wall clock at calibration
+static unsigned long TIMER_BASE_USEC = 0;
+static unsigned long TIMER_READ_COST = 0;
+
+// event counters, see stat_perf_open()
+static int PERF_REQUESTED = 0;
+static int PERF_ENABLED = 0;
+static int PERF_AVAILABLE = 0;          // bit per stat_perf_event opened by some thread
+static unsigned long PERF_READ_COST = 0;
+#define STAT_PERF_ROW (1 + 2 * STAT_PERF_COUNT)
+
+static const char* const STAT_PERF_NAMES[STAT_PERF_COUNT] = {
+    "task_clock_ns", "ctx_switches", "page_faults", "cycles", "instructions", "cache_misses"
+};
+
+static unsigned long mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)(1000000000L * ts.tv_sec + ts.tv_nsec);
+}
+
+static unsigned long wall_usec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (unsigned long)(1000000L * ts.tv_sec + ts.tv_nsec / 1000);
+}
+
+#ifdef STAT_HAVE_TSC
+static int tsc_invariant(void) {
+    unsigned int a, b, c, d;
+
+    if (!__get_cpuid(0x80000000, &a, &b, &c, &d) || a < 0x80000007)
+        return 0;
+    // rdtscp
+    if (!__get_cpuid(0x80000001, &a, &b, &c, &d) || !(d & (1U << 27)))
+        return 0;
+    // constant rate, keeps counting in deep C-states
+    if (!__get_cpuid(0x80000007, &a, &b, &c, &d) || !(d & (1U << 8)))
+        return 0;
+    return 1;
+}
+#endif
+
+static inline unsigned long timer_ticks(void) {
+#ifdef STAT_HAVE_TSC
+    if (TIMER_SOURCE == STAT_TIMER_TSC) {
+        unsigned int aux;
+        return (unsigned long)__rdtscp(&aux);
+    }
+#endif
+    return mono_ns();
+}
+
+/* Slew the rate so that the timer meets the wall clock at the next anchor */
+static void timer_reanchor(const timer_anchor* a, unsigned long ticks) {
+    timer_anchor* next = &ANCHORS[!ANCHOR_CUR];
+    unsigned long wall = wall_usec();
+    double rate = (double)(wall - TIMER_BASE_USEC) / (double)(ticks - TIMER_BASE_TICK);
+
+    next->tick = ticks;
+    next->usec = a->usec + (unsigned long)((double)(ticks - a->tick) * a->usec_per_tick);
+    next->usec_per_tick = rate + ((double)wall - (double)next->usec) / (double)TIMER_REANCHOR_TICKS;
+    if (next->usec_per_tick <= 0)
+        next->usec_per_tick = rate;
+    __atomic_store_n(&ANCHOR_CUR, !ANCHOR_CUR, __ATOMIC_RELEASE);
+}
+
+void stat_timer_init(int allow_tsc) {
+    timer_anchor* a;
+    unsigned long t0, start;
+
+    TIMER_SOURCE = STAT_TIMER_MONOTONIC;
+    TIMER_NS_PER_TICK = 1.0;
+#ifdef STAT_HAVE_TSC
+    if (allow_tsc && tsc_invariant()) {
+        unsigned int aux;
+        unsigned long c0, c1, m0, m1;
+
+        m0 = mono_ns();
+        c0 = __rdtscp(&aux);
+        while ((m1 = mono_ns()) - m0 < STAT_TIMER_CALIBRATE * 1000UL)
+            ;
+        c1 = __rdtscp(&aux);
+        if (c1 > c0) {
+            TIMER_NS_PER_TICK = (double)(m1 - m0) / (double)(c1 - c0);
+            TIMER_SOURCE = STAT_TIMER_TSC;
+        }
+    }
+#endif
+    TIMER_REANCHOR_TICKS = (unsigned long)(STAT_TIMER_REANCHOR * 1000.0 / TIMER_NS_PER_TICK);
+
+    a = &ANCHORS[!ANCHOR_CUR];
+    a->tick = TIMER_BASE_TICK = timer_ticks();
+    a->usec = TIMER_BASE_USEC = wall_usec();
+    a->usec_per_tick = TIMER_NS_PER_TICK / 1000.0;
+    __atomic_store_n(&ANCHOR_CUR, !ANCHOR_CUR, __ATOMIC_RELEASE);
+    TIMER_READY = 1;
+
+    // Cost of one read, taken off the measured overheads
+    start = mono_ns();
+    for (int i = 0; i < STAT_TIMER_COST_READS; i++)
+        t0 = get_time_usec();
+    (void)t0;
+    TIMER_READ_COST = (mono_ns() - start) / STAT_TIMER_COST_READS;
+    stat_local_block()->timer_reads_charged = stat_local_block()->timer_reads;
+}
+
+stat_timer_source stat_timer_get_source(void) {
+    return TIMER_SOURCE;
+}
+
+unsigned long stat_timer_read_cost(void) {
+    return TIMER_READ_COST;
+}
 
 unsigned long get_time_usec(void) {
-    struct timeval tp;
-    gettimeofday(&tp, NULL);
-    return (unsigned long)((1000000 * tp.tv_sec) + tp.tv_usec);
+    const timer_anchor* a;
+    unsigned long ticks;
+
+    if (!TIMER_READY)
+        stat_timer_init(1);
+    stat_local_block()->timer_reads++;
+
+    a = &ANCHORS[__atomic_load_n(&ANCHOR_CUR, __ATOMIC_ACQUIRE)];
+    ticks = timer_ticks();
+    // TSCs of different sockets may be slightly apart
+    if ((long)(ticks - a->tick) < 0)
+        return a->usec;
+    if (ticks - a->tick >= TIMER_REANCHOR_TICKS &&
+            !__atomic_exchange_n(&ANCHOR_BUSY, 1, __ATOMIC_ACQUIRE)) {
+        timer_reanchor(a, ticks);
+        __atomic_store_n(&ANCHOR_BUSY, 0, __ATOMIC_RELEASE);
+    }
+    return a->usec + (unsigned long)((double)(ticks - a->tick) * a->usec_per_tick);
 }
 
-void _dic_init_int(void){
-    for(int i = 0; i < STAT_FUNC_MOD; i++){
-        FUNC_DIC[i] = 0;
+unsigned long stat_timer_ns(void) {
+    return (unsigned long)((double)timer_ticks() * TIMER_NS_PER_TICK);
+}
+
+static const char* const STAT_PHASE_NAMES[STAT_PHASE_COUNT] = {
+    "name", "fill", "uuid", "node", "store", "text", "list"
+};
+
+stat_block* stat_block_register(void) {
+    stat_block* block;
+
+    if (posix_memalign((void**)&block, STAT_CACHE_LINE, sizeof(stat_block)) != 0) {
+        STAT_LOCAL_BLOCK = &STAT_FALLBACK_BLOCK;
+        return STAT_LOCAL_BLOCK;
     }
+    memset(block, 0, sizeof(stat_block));
+
+    // Lock-free push, blocks are only ever added
+    block->next = __atomic_load_n(&STAT_BLOCKS, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&STAT_BLOCKS, &block->next, block,
+                0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+    STAT_LOCAL_BLOCK = block;
+    return block;
+}
+
+static stat_block* stat_blocks_head(void) {
+    return __atomic_load_n(&STAT_BLOCKS, __ATOMIC_ACQUIRE);
+}
+
+static void stat_add(Stat* dst, const Stat* src) {
+    dst->TOTAL_PROV_OVERHEAD += src->TOTAL_PROV_OVERHEAD;
+    dst->TOTAL_NATIVE_H5_TIME += src->TOTAL_NATIVE_H5_TIME;
+    dst->PROV_WRITE_TOTAL_TIME += src->PROV_WRITE_TOTAL_TIME;
+    dst->FILE_LL_TOTAL_TIME += src->FILE_LL_TOTAL_TIME;
+    dst->DS_LL_TOTAL_TIME += src->DS_LL_TOTAL_TIME;
+    dst->GRP_LL_TOTAL_TIME += src->GRP_LL_TOTAL_TIME;
+    dst->DT_LL_TOTAL_TIME += src->DT_LL_TOTAL_TIME;
+    dst->ATTR_LL_TOTAL_TIME += src->ATTR_LL_TOTAL_TIME;
+    dst->PROV_SERIALIZE_TIME += src->PROV_SERIALIZE_TIME;
 }
 
-void _dic_init(void){
-    for(int i = 0; i < STAT_FUNC_MOD; i++){
-        FUNC_DIC[i] = NULL;
+void stat_blocks_sum(Stat* prov_out, Stat* connector_out) {
+    if (prov_out)
+        memset(prov_out, 0, sizeof(Stat));
+    if (connector_out)
+        memset(connector_out, 0, sizeof(Stat));
+    for (stat_block* b = stat_blocks_head(); b; b = b->next) {
+        if (prov_out)
+            stat_add(prov_out, &b->prov);
+        if (connector_out)
+            stat_add(connector_out, &b->connector);
     }
+    if (prov_out)
+        stat_add(prov_out, &STAT_FALLBACK_BLOCK.prov);
+    if (connector_out)
+        stat_add(connector_out, &STAT_FALLBACK_BLOCK.connector);
 }
 
-void func_dic_alloc() {
-    FUNC_DIC = malloc(STAT_FUNC_MOD*sizeof(char*));
+void stat_phase_begin(int phase) {
+    stat_block* b = stat_local_block();
+    int d = b->phase_depth++;
+
+    // Deeper phases are folded into the innermost tracked one
+    if (d >= STAT_PHASE_DEPTH)
+        return;
+    b->phase_stack[d] = phase;
+    b->phase_child[d] = 0;
+    b->phase_start[d] = stat_timer_ns();
 }
 
+void stat_phase_end(void) {
+    stat_block* b = stat_local_block();
+    int d = --b->phase_depth;
+    unsigned long elapsed;
 
-unsigned int genHash(const char *msg) {
-    unsigned long hash = 0;
-    unsigned long c;
-    unsigned int func_index;
-    const char* tmp = msg;
+    if (d < 0) {
+        b->phase_depth = 0;
+        return;
+    }
+    if (d >= STAT_PHASE_DEPTH)
+        return;
+    elapsed = stat_timer_ns() - b->phase_start[d];
+    b->phase_pending[b->phase_stack[d]] += elapsed - b->phase_child[d];
+    b->phase_any = 1;
+    if (d > 0)
+        b->phase_child[d - 1] += elapsed;
+}
 
-    while (0 != (c = (unsigned long)(*msg++))) {//SDBM hash
-        hash = c + (hash << 6) + (hash << 16) - hash;
+void stat_phase_add(int phase, unsigned long ns) {
+    stat_block* b = stat_local_block();
+    int d = b->phase_depth;
+
+    b->phase_pending[phase] += ns;
+    b->phase_any = 1;
+    if (d > 0 && d <= STAT_PHASE_DEPTH)
+        b->phase_child[d - 1] += ns;
+}
+
+#ifdef STAT_HAVE_PERF
+static const struct {
+    unsigned int type;
+    unsigned long config;
+    int group;
+} PERF_EVENTS[STAT_PERF_COUNT] = {
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, 0},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, 0},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, 0},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 1},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 1},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, 1},
+};
+
+/* Count event e of the calling thread, user space only if the kernel
+ * does not allow more */
+static int perf_event_open_(int e, int leader) {
+    struct perf_event_attr attr;
+    int fd;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_EVENTS[e].type;
+    attr.config = PERF_EVENTS[e].config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+    if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+    }
+    return fd;
+}
+
+static void perf_thread_open(stat_block* b) {
+    int members[STAT_PERF_GROUPS] = {0};
+
+    for (int g = 0; g < STAT_PERF_GROUPS; g++)
+        b->perf_leader[g] = -1;
+    for (int e = 0; e < STAT_PERF_COUNT; e++) {
+        int g = PERF_EVENTS[e].group;
+
+        b->perf_fd[e] = perf_event_open_(e, b->perf_leader[g]);
+        b->perf_slot[e] = -1;
+        if (b->perf_fd[e] < 0)
+            continue;
+        if (b->perf_leader[g] < 0)
+            b->perf_leader[g] = b->perf_fd[e];
+        b->perf_slot[e] = members[g]++;
+        __atomic_fetch_or(&PERF_AVAILABLE, 1 << e, __ATOMIC_RELAXED);
     }
+    b->perf_state = (members[0] || members[1]) ? 1 : -1;
+}
+#endif
+
+void stat_perf_read(stat_perf_sample* sample) {
+#ifdef STAT_HAVE_PERF
+    stat_block* b;
+    uint64_t values[STAT_PERF_GROUPS][1 + STAT_PERF_COUNT];
+
+    if (!PERF_ENABLED)
+        return;
+    b = stat_local_block();
+    if (b->perf_state == 0)
+        perf_thread_open(b);
+    if (b->perf_state < 0)
+        return;
+    b->perf_reads++;
+
+    // PERF_FORMAT_GROUP: number of events, then their values in opening order
+    for (int g = 0; g < STAT_PERF_GROUPS; g++)
+        if (b->perf_leader[g] < 0 || read(b->perf_leader[g], values[g], sizeof(values[g])) <= 0)
+            values[g][0] = 0;
+    for (int e = 0; e < STAT_PERF_COUNT; e++) {
+        int g = PERF_EVENTS[e].group;
+        int slot = b->perf_slot[e];
+
+        sample->v[e] = (slot >= 0 && (uint64_t)slot < values[g][0]) ? values[g][1 + slot] : 0;
+    }
+#else
+    (void)sample;
+#endif
+}
+
+void stat_perf_record(int func_id, const stat_perf_sample* samples) {
+    stat_block* b;
+    unsigned long* row;
+
+    if (!PERF_ENABLED || func_id < 0 || func_id >= FUNC_TABLE_SIZE)
+        return;
+    b = stat_local_block();
+    if (b->perf_state <= 0)
+        return;
+    if (b->perf == NULL) {
+        b->perf = calloc((size_t)FUNC_TABLE_SIZE * STAT_PERF_ROW, sizeof(unsigned long));
+        if (b->perf == NULL)
+            return;
+    }
+    row = b->perf + (size_t)func_id * STAT_PERF_ROW;
+    row[0]++;
+    for (int e = 0; e < STAT_PERF_COUNT; e++) {
+        unsigned long entry = samples[STAT_PERF_ENTRY].v[e];
+        unsigned long begin = samples[STAT_PERF_NATIVE_BEGIN].v[e];
+        unsigned long end = samples[STAT_PERF_NATIVE_END].v[e];
+        unsigned long done = samples[STAT_PERF_EXIT].v[e];
 
-    msg = tmp;//restore string head address
-    func_index = (unsigned int)(hash % STAT_FUNC_MOD);
-    if(!FUNC_DIC[func_index]) {
-        FUNC_DIC[func_index] = strdup(msg);
-        //printf("received msg = %s, hash index = %d, result msg = %s\n", msg, func_index, FUNC_DIC[func_index]);
+        if (b->perf_slot[e] < 0)
+            continue;
+        row[1 + e] += end - begin;
+        row[1 + STAT_PERF_COUNT + e] += (begin - entry) + (done - end);
     }
+}
+
+int stat_perf_open(int enable) {
+    int opened = 0;
+
+    PERF_REQUESTED = enable;
+    PERF_ENABLED = 0;
+#ifdef STAT_HAVE_PERF
+    if (enable) {
+        stat_block* b = stat_local_block();
+        stat_perf_sample sample;
+        unsigned long start;
+
+        if (b->perf_state == 0)
+            perf_thread_open(b);
+        for (int e = 0; e < STAT_PERF_COUNT; e++)
+            opened += b->perf_state > 0 && b->perf_slot[e] >= 0;
+        if (opened == 0)
+            return 0;
+
+        // Cost of one sample, taken off the measured overheads like timer reads
+        PERF_ENABLED = 1;
+        start = mono_ns();
+        for (int i = 0; i < STAT_PERF_COST_READS; i++)
+            stat_perf_read(&sample);
+        PERF_READ_COST = (mono_ns() - start) / STAT_PERF_COST_READS;
+        b->perf_reads_charged = b->perf_reads;
+    }
+#endif
+    return opened;
+}
 
-    return func_index;
+/* Threads still running see PERF_ENABLED 0 and stop sampling */
+void stat_perf_close(void) {
+    PERF_ENABLED = 0;
+    for (stat_block* b = stat_blocks_head(); b; b = b->next) {
+        if (b->perf_state <= 0)
+            continue;
+        b->perf_state = -1;
+        for (int e = 0; e < STAT_PERF_COUNT; e++)
+            if (b->perf_slot[e] >= 0)
+                close(b->perf_fd[e]);
+    }
+}
+
+/* Move the pending phase times of b to row func_id */
+static void phase_drain(stat_block* b, int func_id) {
+    if (b->phase_ns == NULL) {
+        b->phase_ns = calloc((size_t)(FUNC_TABLE_SIZE + 1) * STAT_PHASE_COUNT, sizeof(unsigned long));
+        if (b->phase_ns == NULL)
+            return;
+    }
+    for (int p = 0; p < STAT_PHASE_COUNT; p++) {
+        b->phase_ns[func_id * STAT_PHASE_COUNT + p] += b->phase_pending[p];
+        b->phase_pending[p] = 0;
+    }
+    b->phase_any = 0;
+}
+
+static void block_func_free(stat_block* b) {
+    if (b->native_hists) {
+        for (int i = 0; i < FUNC_TABLE_SIZE; i++) {
+            free(b->native_hists[i]);
+            free(b->overhead_hists[i]);
+        }
+    }
+    free(b->native_hists);
+    free(b->overhead_hists);
+    free(b->func_durations);
+    free(b->phase_ns);
+    free(b->perf);
+    b->native_hists = b->overhead_hists = NULL;
+    b->func_durations = NULL;
+    b->phase_ns = NULL;
+    b->perf = NULL;
+}
+
+static void func_table_free(void) {
+    for (stat_block* b = stat_blocks_head(); b; b = b->next)
+        block_func_free(b);
+    block_func_free(&STAT_FALLBACK_BLOCK);
+    FUNC_NAMES = NULL;
+    FUNC_TABLE_SIZE = 0;
+}
+
+/* Release a name table together with its values */
+static void counts_free(duration_ht* table) {
+    for (size_t i = 0; i < table->capacity; i++) {
+        if (table->entries[i].key != NULL) {
+            free((void*)table->entries[i].key);
+            free(table->entries[i].value);
+        }
+    }
+    free(table->entries);
+    free(table);
+}
+
+// SDBM hash of user-defined function names
+static uint64_t stat_hash(const char* key) {
+    uint64_t hash = 0;
+    uint64_t c;
+
+    while (0 != (c = (uint64_t)(unsigned char)(*key++)))
+        hash = c + (hash << 6) + (hash << 16) - hash;
+    return hash;
 }
 
 duration_ht* stat_create(int capacity) {
     // Allocate space for hash table struct.
-    func_dic_alloc();
-    _dic_init_int();
     duration_ht* table = malloc(sizeof(duration_ht));
     if (table == NULL) {
         return NULL;
     }
     table->length = 0;
-    table->capacity = capacity;
+    // Slots are picked with hash & (capacity-1), round up to a power of two
+    table->capacity = 1;
+    while (table->capacity < (size_t)capacity)
+        table->capacity <<= 1;
+    COUNTS_CAPACITY = table->capacity;
 
     // Allocate (zero'd) space for entry buckets.
     table->entries = calloc(table->capacity, sizeof(duration_entry));
@@ -87,11 +583,13 @@ void stat_destroy(duration_ht* table) {
     // Then free entries array and table itself.
     free(table->entries);
     free(table);
+
+    func_table_free();
 }
 
 void* stat_get(duration_ht* table, const char* key) {
     // AND hash with capacity-1 to ensure it's within entries array.
-    uint64_t hash = genHash(key);
+    uint64_t hash = stat_hash(key);
     size_t index = (size_t)(hash & (uint64_t)(table->capacity - 1));
 
     // Loop till we find an empty entry.
@@ -113,7 +611,7 @@ void* stat_get(duration_ht* table, const char* key) {
 const char* stat_set_entry(duration_entry* entries, size_t capacity,
         const char* key, void* value, size_t* plength) {
     // AND hash with capacity-1 to ensure it's within entries array.
-    uint64_t hash = genHash(key);
+    uint64_t hash = stat_hash(key);
     size_t index = (size_t)(hash & (uint64_t)(capacity - 1));
 
     // Loop till we find an empty entry.
@@ -185,8 +683,8 @@ void accumulate_duration(duration_ht* counts, const char* func_name,
             (*accumulated_duration_new) += elapsed;
         }
     else {
-         // Word not found, allocate space for new int and set to 1.
-        int* accumulated_duration = malloc(sizeof(unsigned long));
+         // Word not found, allocate space for a new sum and set it to elapsed.
+        unsigned long* accumulated_duration = malloc(sizeof(unsigned long));
         if (accumulated_duration == NULL) {
         //     exit_nomem();
             exit(1);
@@ -199,6 +697,1001 @@ void accumulate_duration(duration_ht* counts, const char* func_name,
     }
 }
 
+static int stat_hist_index(unsigned long value) {
+    int exp, index;
+
+    if (value < (1UL << STAT_HIST_SUB_BITS))
+        return (int)value;
+    exp = 63 - __builtin_clzl(value);
+    index = ((exp - STAT_HIST_SUB_BITS + 1) << STAT_HIST_SUB_BITS)
+        + (int)((value >> (exp - STAT_HIST_SUB_BITS)) & ((1UL << STAT_HIST_SUB_BITS) - 1));
+    return index < STAT_HIST_BUCKETS ? index : STAT_HIST_BUCKETS - 1;
+}
+
+// Largest value counted in bucket index
+static unsigned long stat_hist_upper(int index) {
+    int exp;
+    unsigned long sub;
+
+    if (index < (1 << STAT_HIST_SUB_BITS))
+        return (unsigned long)index;
+    exp = (index >> STAT_HIST_SUB_BITS) + STAT_HIST_SUB_BITS - 1;
+    sub = (unsigned long)(index & ((1 << STAT_HIST_SUB_BITS) - 1));
+    return (((1UL << STAT_HIST_SUB_BITS) + sub + 1) << (exp - STAT_HIST_SUB_BITS)) - 1;
+}
+
+void stat_hist_record(stat_hist* hist, unsigned long value) {
+    hist->buckets[stat_hist_index(value)]++;
+    hist->count++;
+    hist->sum += value;
+    if (value > hist->max)
+        hist->max = value;
+}
+
+void stat_hist_merge(stat_hist* dst, const stat_hist* src) {
+    for (int i = 0; i < STAT_HIST_BUCKETS; i++)
+        dst->buckets[i] += src->buckets[i];
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->max > dst->max)
+        dst->max = src->max;
+}
+
+/* Smallest bucket bound with at least q of the samples at or below it */
+unsigned long stat_hist_percentile(const stat_hist* hist, double q) {
+    unsigned long rank, seen = 0;
+
+    if (hist->count == 0)
+        return 0;
+    rank = (unsigned long)(q * (double)hist->count + 0.5);
+    if (rank < 1)
+        rank = 1;
+    for (int i = 0; i < STAT_HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            unsigned long upper = stat_hist_upper(i);
+            if (i == STAT_HIST_BUCKETS - 1 || upper > hist->max)
+                return hist->max;
+            return upper;
+        }
+    }
+    return hist->max;
+}
+
+/* Called once before the callbacks run, the per-thread arrays are
+ * allocated by each thread on its first callback */
+void stat_func_table_init(const char* const* names, int count) {
+    func_table_free();
+    FUNC_NAMES = names;
+    FUNC_TABLE_SIZE = count;
+}
+
+void stat_pool_table_init(const char* const* names, int count) {
+    POOL_NAMES = names;
+    POOL_TABLE_SIZE = count < STAT_POOL_MAX ? count : STAT_POOL_MAX;
+}
+
+static void pool_add(stat_pool_counts* dst, const stat_pool_counts* src) {
+    dst->allocs += src->allocs;
+    dst->reused += src->reused;
+    dst->frees += src->frees;
+    dst->released += src->released;
+}
+
+// Every thread's counters of one pool, returns nonzero if it was used
+static int pool_sum(int pool_id, stat_pool_counts* out) {
+    memset(out, 0, sizeof(stat_pool_counts));
+    for (stat_block* b = stat_blocks_head(); b; b = b->next)
+        pool_add(out, &b->pools[pool_id]);
+    pool_add(out, &STAT_FALLBACK_BLOCK.pools[pool_id]);
+    return out->allocs || out->frees;
+}
+
+void accumulate_duration_id(int func_id, unsigned long native, unsigned long overhead) {
+    stat_block* b = stat_local_block();
+
+    if (func_id < 0 || func_id >= FUNC_TABLE_SIZE)
+        return;
+
+    // Timer and counter reads made since the last callback are part of its overhead
+    unsigned long cost = ((b->timer_reads - b->timer_reads_charged) * TIMER_READ_COST +
+            (b->perf_reads - b->perf_reads_charged) * PERF_READ_COST) / 1000;
+    b->timer_reads_charged = b->timer_reads;
+    b->perf_reads_charged = b->perf_reads;
+    overhead = overhead > cost ? overhead - cost : 0;
+
+    if (b->func_durations == NULL) {
+        b->func_durations = calloc(FUNC_TABLE_SIZE, sizeof(unsigned long));
+        b->native_hists = calloc(FUNC_TABLE_SIZE, sizeof(stat_hist*));
+        b->overhead_hists = calloc(FUNC_TABLE_SIZE, sizeof(stat_hist*));
+        if (!b->func_durations || !b->native_hists || !b->overhead_hists) {
+            block_func_free(b);
+            return;
+        }
+    }
+    b->func_durations[func_id] += overhead;
+
+    if (b->native_hists[func_id] == NULL) {
+        b->native_hists[func_id] = calloc(1, sizeof(stat_hist));
+        b->overhead_hists[func_id] = calloc(1, sizeof(stat_hist));
+        if (!b->native_hists[func_id] || !b->overhead_hists[func_id]) {
+            free(b->native_hists[func_id]);
+            free(b->overhead_hists[func_id]);
+            b->native_hists[func_id] = b->overhead_hists[func_id] = NULL;
+            return;
+        }
+    }
+    stat_hist_record(b->native_hists[func_id], native);
+    stat_hist_record(b->overhead_hists[func_id], overhead);
+    if (b->phase_any)
+        phase_drain(b, func_id);
+}
+
+duration_ht* stat_local_counts(void) {
+    stat_block* b = stat_local_block();
+
+    if (b->counts == NULL)
+        b->counts = stat_create((int)COUNTS_CAPACITY);
+    return b->counts;
+}
+
+/* Move every thread's name table into counts */
+static void counts_merge_blocks(duration_ht* counts) {
+    if (counts == NULL)
+        return;
+    for (stat_block* b = stat_blocks_head(); b; b = b->next) {
+        duration_ht* table = b->counts;
+
+        if (table == NULL)
+            continue;
+        b->counts = NULL;
+        for (size_t i = 0; i < table->capacity; i++)
+            if (table->entries[i].key != NULL)
+                accumulate_duration(counts, table->entries[i].key,
+                    *(unsigned long*)table->entries[i].value);
+        counts_free(table);
+    }
+}
+
+static void stat_hist_print(FILE* stat_file_handle, const char* name,
+        const char* kind, const stat_hist* hist) {
+    char pline[2048];
+
+    snprintf(pline, sizeof(pline),
+        "%s %s count %lu p50 %lu p99 %lu p999 %lu max %lu us\n",
+        name, kind, hist->count,
+        stat_hist_percentile(hist, 0.5),
+        stat_hist_percentile(hist, 0.99),
+        stat_hist_percentile(hist, 0.999),
+        hist->max);
+    if (stat_file_handle != NULL)
+        fputs(pline, stat_file_handle);
+    else
+        printf("%s", pline);
+}
+
+/* Sum callback func_id over all threads */
+static void callback_hist_sum(int func_id, stat_hist* native, stat_hist* overhead) {
+    memset(native, 0, sizeof(stat_hist));
+    memset(overhead, 0, sizeof(stat_hist));
+    for (stat_block* b = stat_blocks_head(); b; b = b->next) {
+        stat_hist** n = b->native_hists;
+        stat_hist** o = b->overhead_hists;
+        // Other threads may be allocating their arrays right now
+        if (n && o && n[func_id] && o[func_id]) {
+            stat_hist_merge(native, n[func_id]);
+            stat_hist_merge(overhead, o[func_id]);
+        }
+    }
+}
+
+/* Phase times of row func_id summed over all threads, returns their total */
+static unsigned long phase_sum(int func_id, unsigned long* ns) {
+    unsigned long total = 0;
+
+    memset(ns, 0, STAT_PHASE_COUNT * sizeof(unsigned long));
+    for (stat_block* b = stat_blocks_head(); b; b = b->next) {
+        if (b->phase_ns == NULL)
+            continue;
+        for (int p = 0; p < STAT_PHASE_COUNT; p++) {
+            ns[p] += b->phase_ns[func_id * STAT_PHASE_COUNT + p];
+            total += b->phase_ns[func_id * STAT_PHASE_COUNT + p];
+        }
+    }
+    return total;
+}
+
+/* Phase times of row func_id, nothing if all zero */
+static void phase_print(FILE* stat_file_handle, const char* name, int func_id) {
+    unsigned long ns[STAT_PHASE_COUNT];
+    char pline[2048];
+    int len;
+
+    if (phase_sum(func_id, ns) == 0)
+        return;
+
+    len = snprintf(pline, sizeof(pline), "%s phases", name);
+    for (int p = 0; p < STAT_PHASE_COUNT; p++)
+        len += snprintf(pline + len, sizeof(pline) - len, " %s %lu", STAT_PHASE_NAMES[p], ns[p]);
+    snprintf(pline + len, sizeof(pline) - len, " ns\n");
+    if (stat_file_handle != NULL)
+        fputs(pline, stat_file_handle);
+    else
+        printf("%s", pline);
+}
+
+/* Event counts of callback func_id summed over all threads: calls, then the
+ * native call's and the provenance work's counts */
+static void perf_sum(int func_id, unsigned long* row) {
+    memset(row, 0, STAT_PERF_ROW * sizeof(unsigned long));
+    for (stat_block* b = stat_blocks_head(); b; b = b->next) {
+        if (b->perf == NULL)
+            continue;
+        for (int i = 0; i < STAT_PERF_ROW; i++)
+            row[i] += b->perf[(size_t)func_id * STAT_PERF_ROW + i];
+    }
+}
+
+/* One line each for the native call and the provenance work */
+static void perf_print(FILE* stat_file_handle, const char* name, int func_id) {
+    unsigned long row[STAT_PERF_ROW];
+    char pline[2048];
+    int len;
+
+    perf_sum(func_id, row);
+    if (row[0] == 0)
+        return;
+
+    for (int kind = 0; kind < 2; kind++) {
+        len = snprintf(pline, sizeof(pline), "%s perf %s calls %lu", name,
+                kind ? "overhead" : "native", row[0]);
+        for (int e = 0; e < STAT_PERF_COUNT; e++)
+            if (PERF_AVAILABLE & (1 << e))
+                len += snprintf(pline + len, sizeof(pline) - len, " %s %lu",
+                        STAT_PERF_NAMES[e], row[1 + kind * STAT_PERF_COUNT + e]);
+        snprintf(pline + len, sizeof(pline) - len, "\n");
+        if (stat_file_handle != NULL)
+            fputs(pline, stat_file_handle);
+        else
+            printf("%s", pline);
+    }
+}
+
+/* PERF_EVENTS line: the events that could be counted */
+static void perf_events_print(FILE* stat_file_handle) {
+    char pline[256];
+    int len;
+
+    if (!PERF_REQUESTED)
+        return;
+    len = snprintf(pline, sizeof(pline), "PERF_EVENTS");
+    for (int e = 0; e < STAT_PERF_COUNT; e++)
+        if (PERF_AVAILABLE & (1 << e))
+            len += snprintf(pline + len, sizeof(pline) - len, " %s", STAT_PERF_NAMES[e]);
+    if (PERF_AVAILABLE == 0)
+        len += snprintf(pline + len, sizeof(pline) - len, " none");
+    snprintf(pline + len, sizeof(pline) - len, "\nPERF_READ_COST %lu ns\n", PERF_READ_COST);
+    fputs(pline, stat_file_handle);
+}
+
+static void pool_print(FILE* stat_file_handle) {
+    char pline[256];
+    stat_pool_counts sum;
+
+    for (int i = 0; i < POOL_TABLE_SIZE; i++) {
+        if (!pool_sum(i, &sum))
+            continue;
+        snprintf(pline, sizeof(pline), "POOL %s allocs %lu reused %lu frees %lu released %lu\n",
+            POOL_NAMES[i], sum.allocs, sum.reused, sum.frees, sum.released);
+        if (stat_file_handle != NULL)
+            fputs(pline, stat_file_handle);
+        else
+            printf("%s", pline);
+    }
+}
+
+/* Sum every thread's callback counters and print those called at least once */
+static void func_table_print(FILE* stat_file_handle) {
+    char pline[2048];
+    stat_hist* native = malloc(sizeof(stat_hist));
+    stat_hist* overhead = malloc(sizeof(stat_hist));
+
+    if (!native || !overhead) {
+        free(native);
+        free(overhead);
+        return;
+    }
+
+    for (int i = 0; i < FUNC_TABLE_SIZE; i++) {
+        unsigned long duration = 0;
+
+        memset(native, 0, sizeof(stat_hist));
+        memset(overhead, 0, sizeof(stat_hist));
+        for (stat_block* b = stat_blocks_head(); b; b = b->next) {
+            if (b->func_durations == NULL)
+                continue;
+            duration += b->func_durations[i];
+            if (b->native_hists[i]) {
+                stat_hist_merge(native, b->native_hists[i]);
+                stat_hist_merge(overhead, b->overhead_hists[i]);
+            }
+        }
+        if (duration == 0 && native->count == 0)
+            continue;
+
+        snprintf(pline, sizeof(pline), "%s %lu us\n", FUNC_NAMES[i], duration);
+        if (stat_file_handle != NULL)
+            fputs(pline, stat_file_handle);
+        else
+            printf("%s", pline);
+        if (native->count) {
+            stat_hist_print(stat_file_handle, FUNC_NAMES[i], "native", native);
+            stat_hist_print(stat_file_handle, FUNC_NAMES[i], "overhead", overhead);
+        }
+        phase_print(stat_file_handle, FUNC_NAMES[i], i);
+        perf_print(stat_file_handle, FUNC_NAMES[i], i);
+    }
+    // Phases recorded outside of any callback
+    for (stat_block* b = stat_blocks_head(); b; b = b->next)
+        if (b->phase_any)
+            phase_drain(b, FUNC_TABLE_SIZE);
+    phase_print(stat_file_handle, "unattributed", FUNC_TABLE_SIZE);
+    free(native);
+    free(overhead);
+}
+
+void stat_add_coll_skew(const char* name, int ops, unsigned long total_skew,
+        unsigned long max_skew, int slowest_rank, double wasted) {
+    coll_skew_entry* entry = calloc(1, sizeof(coll_skew_entry));
+    if (entry == NULL)
+        return;
+    entry->name = strdup(name ? name : "(anonymous)");
+    entry->ops = ops;
+    entry->total_skew = total_skew;
+    entry->max_skew = max_skew;
+    entry->slowest_rank = slowest_rank;
+    entry->wasted = wasted;
+
+    if (COLL_SKEW_TAIL)
+        COLL_SKEW_TAIL->next = entry;
+    else
+        COLL_SKEW_HEAD = entry;
+    COLL_SKEW_TAIL = entry;
+}
+
+void stat_set_async(const stat_async_counts* counts) {
+    ASYNC = *counts;
+}
+
+static void async_print(FILE* stat_file_handle) {
+    char pline[256];
+
+    if (!ASYNC.ops && !ASYNC.max_in_flight)
+        return;
+    snprintf(pline, sizeof(pline),
+        "ASYNC ops %lu max_in_flight %lu issue %lu us complete %lu us overlap %lu us\n",
+        ASYNC.ops, ASYNC.max_in_flight, ASYNC.issue_us, ASYNC.complete_us, ASYNC.overlap_us);
+    if (stat_file_handle != NULL)
+        fputs(pline, stat_file_handle);
+    else
+        printf("%s", pline);
+}
+
+/* Print and release collective skew entries */
+static void coll_skew_print(FILE* stat_file_handle) {
+    char pline[2048];
+    coll_skew_entry* entry = COLL_SKEW_HEAD;
+
+    while (entry) {
+        coll_skew_entry* next = entry->next;
+        snprintf(pline, sizeof(pline),
+            "COLL_SKEW %s ops %d total_skew %lu us max_skew %lu us slowest_rank %d wasted %.6f rank-s\n",
+            entry->name, entry->ops, entry->total_skew, entry->max_skew,
+            entry->slowest_rank, entry->wasted);
+        if (stat_file_handle != NULL)
+            fputs(pline, stat_file_handle);
+        else
+            printf("%s", pline);
+        free(entry->name);
+        free(entry);
+        entry = next;
+    }
+    COLL_SKEW_HEAD = COLL_SKEW_TAIL = NULL;
+}
+
+void stat_shm_open(int rank, unsigned long interval_usec) {
+    snprintf(SHM_PATH, sizeof(SHM_PATH), "%s/provio.%d", STAT_SHM_DIR, (int)getpid());
+    SHM_RANK = rank;
+    SHM_INTERVAL = interval_usec;
+    SHM_LAST = 0;
+    SHM_ENABLED = 1;
+}
+
+/* Size the segment for the callback table registered so far */
+static int shm_create(void) {
+    size_t size = sizeof(stat_shm_header) + (size_t)FUNC_TABLE_SIZE * sizeof(stat_shm_callback);
+    int fd = open(SHM_PATH, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    void* seg;
+
+    if (fd < 0) {
+        printf("stat_shm: failed to create %s\n", SHM_PATH);
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)size) != 0 ||
+            (seg = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        printf("stat_shm: failed to map %s\n", SHM_PATH);
+        close(fd);
+        unlink(SHM_PATH);
+        return -1;
+    }
+    close(fd);
+
+    SHM_SEG = seg;
+    SHM_SIZE = size;
+    SHM_SEG->version = STAT_SHM_VERSION;
+    SHM_SEG->rank = SHM_RANK;
+    SHM_SEG->pid = (int)getpid();
+    SHM_SEG->header_size = sizeof(stat_shm_header);
+    SHM_SEG->callback_cnt = FUNC_TABLE_SIZE;
+    SHM_SEG->callback_size = sizeof(stat_shm_callback);
+    SHM_SEG->hist_buckets = STAT_HIST_BUCKETS;
+    SHM_SEG->hist_sub_bits = STAT_HIST_SUB_BITS;
+    SHM_SEG->start_time = get_time_usec();
+    stat_shm_callback* cb = (stat_shm_callback*)(SHM_SEG + 1);
+    for (int i = 0; i < FUNC_TABLE_SIZE; i++)
+        strncpy(cb[i].name, FUNC_NAMES[i], STAT_SHM_NAME_LEN - 1);
+    __atomic_store_n(&SHM_SEG->magic, STAT_SHM_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/* Copy the sum of all threads into the segment inside a seqlock write */
+static void shm_publish(unsigned long now) {
+    stat_shm_callback* cb = (stat_shm_callback*)(SHM_SEG + 1);
+    unsigned int seq = SHM_SEG->seq;
+
+    __atomic_store_n(&SHM_SEG->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    stat_blocks_sum(&SHM_SEG->prov, &SHM_SEG->connector);
+    for (int i = 0; i < (int)SHM_SEG->callback_cnt; i++)
+        callback_hist_sum(i, &cb[i].native, &cb[i].overhead);
+    SHM_SEG->update_time = now;
+
+    __atomic_store_n(&SHM_SEG->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+static void tick_lock(void) {
+    while (__atomic_exchange_n(&TICK_BUSY, 1, __ATOMIC_ACQUIRE))
+        ;
+}
+
+static void tick_unlock(void) {
+    __atomic_store_n(&TICK_BUSY, 0, __ATOMIC_RELEASE);
+}
+
+void stat_shm_close(void) {
+    tick_lock();
+    if (SHM_SEG) {
+        munmap(SHM_SEG, SHM_SIZE);
+        unlink(SHM_PATH);
+    }
+    SHM_SEG = NULL;
+    SHM_ENABLED = 0;
+    tick_unlock();
+}
+
+int stat_series_open(const char* path, int rank, unsigned long interval_usec, long clock_offset) {
+    SERIES_FILE = fopen(path, "w");
+    if (SERIES_FILE == NULL) {
+        printf("stat_series: failed to create %s\n", path);
+        return -1;
+    }
+    // Keep rows in memory between intervals instead of writing in the I/O path
+    SERIES_BUFFER = malloc(STAT_SERIES_BUFFER);
+    if (SERIES_BUFFER)
+        setvbuf(SERIES_FILE, SERIES_BUFFER, _IOFBF, STAT_SERIES_BUFFER);
+    SERIES_RANK = rank;
+    SERIES_OFFSET = clock_offset;
+    SERIES_INTERVAL = interval_usec;
+    SERIES_LAST = get_time_usec();
+    stat_blocks_sum(&SERIES_PREV_PROV, &SERIES_PREV_CONNECTOR);
+
+    fprintf(SERIES_FILE, "# provio stat series v%d rank %d interval_us %lu clock_offset_us %ld\n",
+        STAT_SERIES_VERSION, rank, interval_usec, clock_offset);
+    fprintf(SERIES_FILE, "time_us,interval_us,rank,kind,name,count,total_us,p50_us,p99_us,max_us\n");
+    return 0;
+}
+
+/* Change of hist since prev, the max is estimated from the highest bucket */
+static void series_hist_row(unsigned long time, unsigned long interval, const char* kind,
+        const char* name, const stat_hist* hist, const stat_hist* prev, stat_hist* delta) {
+    int top = -1;
+
+    if (hist->count == prev->count)
+        return;
+    delta->count = hist->count - prev->count;
+    delta->sum = hist->sum - prev->sum;
+    for (int i = 0; i < STAT_HIST_BUCKETS; i++) {
+        delta->buckets[i] = hist->buckets[i] - prev->buckets[i];
+        if (delta->buckets[i])
+            top = i;
+    }
+    delta->max = top < 0 ? 0 : stat_hist_upper(top);
+    if (delta->max > hist->max || top == STAT_HIST_BUCKETS - 1)
+        delta->max = hist->max;
+
+    fprintf(SERIES_FILE, "%lu,%lu,%d,%s,%s,%lu,%lu,%lu,%lu,%lu\n",
+        time, interval, SERIES_RANK, kind, name, delta->count, delta->sum,
+        stat_hist_percentile(delta, 0.5), stat_hist_percentile(delta, 0.99), delta->max);
+}
+
+static void series_write(unsigned long now) {
+    unsigned long time = (unsigned long)((long)now + SERIES_OFFSET);
+    unsigned long interval = now - SERIES_LAST;
+    Stat prov, connector;
+    stat_hist* cur;
+
+    stat_blocks_sum(&prov, &connector);
+    for (size_t i = 0; i < sizeof(STAT_FIELDS) / sizeof(STAT_FIELDS[0]); i++) {
+        unsigned long value = *(unsigned long*)((char*)&prov + STAT_FIELDS[i].offset);
+        unsigned long prev = *(unsigned long*)((char*)&SERIES_PREV_PROV + STAT_FIELDS[i].offset);
+        if (value != prev)
+            fprintf(SERIES_FILE, "%lu,%lu,%d,prov,%s,,%lu,,,\n",
+                time, interval, SERIES_RANK, STAT_FIELDS[i].name, value - prev);
+        value = *(unsigned long*)((char*)&connector + STAT_FIELDS[i].offset);
+        prev = *(unsigned long*)((char*)&SERIES_PREV_CONNECTOR + STAT_FIELDS[i].offset);
+        if (value != prev)
+            fprintf(SERIES_FILE, "%lu,%lu,%d,connector,%s,,%lu,,,\n",
+                time, interval, SERIES_RANK, STAT_FIELDS[i].name, value - prev);
+    }
+    SERIES_PREV_PROV = prov;
+    SERIES_PREV_CONNECTOR = connector;
+
+    // Two previous and three scratch histograms per callback
+    if (SERIES_PREV == NULL && FUNC_TABLE_SIZE > 0) {
+        SERIES_PREV = calloc(2 * FUNC_TABLE_SIZE + 3, sizeof(stat_hist));
+        SERIES_PREV_CNT = SERIES_PREV ? FUNC_TABLE_SIZE : 0;
+    }
+    if (SERIES_PREV == NULL)
+        return;
+    cur = SERIES_PREV + 2 * SERIES_PREV_CNT;
+    for (int i = 0; i < SERIES_PREV_CNT && i < FUNC_TABLE_SIZE; i++) {
+        callback_hist_sum(i, &cur[0], &cur[1]);
+        series_hist_row(time, interval, "native", FUNC_NAMES[i], &cur[0], &SERIES_PREV[2 * i], &cur[2]);
+        series_hist_row(time, interval, "overhead", FUNC_NAMES[i], &cur[1], &SERIES_PREV[2 * i + 1], &cur[2]);
+        SERIES_PREV[2 * i] = cur[0];
+        SERIES_PREV[2 * i + 1] = cur[1];
+    }
+}
+
+/* Write the last partial interval */
+void stat_series_close(void) {
+    tick_lock();
+    if (SERIES_FILE) {
+        series_write(get_time_usec());
+        fclose(SERIES_FILE);
+    }
+    free(SERIES_BUFFER);
+    free(SERIES_PREV);
+    SERIES_FILE = NULL;
+    SERIES_BUFFER = NULL;
+    SERIES_PREV = NULL;
+    SERIES_PREV_CNT = 0;
+    tick_unlock();
+}
+
+/* At most one thread runs the due updates, the others return at once */
+void stat_tick(void) {
+    unsigned long now;
+    int shm_due, series_due;
+
+    if (!SHM_ENABLED && SERIES_FILE == NULL)
+        return;
+    now = get_time_usec();
+    shm_due = SHM_ENABLED && now - SHM_LAST >= SHM_INTERVAL;
+    series_due = SERIES_FILE != NULL && now - SERIES_LAST >= SERIES_INTERVAL;
+    if (!shm_due && !series_due)
+        return;
+    if (__atomic_exchange_n(&TICK_BUSY, 1, __ATOMIC_ACQUIRE))
+        return;
+    if (shm_due && SHM_ENABLED) {
+        if (SHM_SEG || shm_create() == 0)
+            shm_publish(now);
+        else
+            SHM_ENABLED = 0;
+        SHM_LAST = now;
+    }
+    if (series_due && SERIES_FILE) {
+        series_write(now);
+        SERIES_LAST = now;
+    }
+    tick_unlock();
+}
+
+/* Structured records
+ *
+ * JSON record, one line:
+ *   {"format": "provio-stat", "version", "run_id", "rank", "nprocs",
+ *    "config_hash" (hex string), "program", "start_us", "end_us",
+ *    "timer": {"source", "read_cost_ns"}, "perf_events", "perf_read_cost_ns",
+ *    "hist_sub_bits", "prov" and "connector": {counter: us},
+ *    "callbacks": {name: {"overhead_us", "native", "overhead", "phases_ns",
+ *        "perf"}}, "unattributed_phases_ns", "counts": {name: us},
+ *    "pools": {name: {"allocs", "reused", "frees", "released"}},
+ *    "async": {"ops", "max_in_flight", "issue_us", "complete_us",
+ *        "overlap_us"}, "coll_skew": [...]}
+ * with histograms as {"count", "sum", "max", "p50", "p99", "p999",
+ * "buckets": [[index, count], ...]} listing the non-empty buckets.
+ *
+ * Binary record, same content: u32 magic, u32 version, u32 record length,
+ * i32 rank, i32 nprocs, u32 hist_sub_bits, u32 timer source (1 tsc),
+ * u32 perf event mask, u64 config_hash, start_us, end_us, timer read cost,
+ * perf read cost, str run_id, str program; u32 phase names and u32 perf event
+ * names (str each); u32 counters, each str name, u64 prov, u64 connector;
+ * u32 callbacks, each str name, u64 overhead_us, hist native, hist overhead,
+ * u64 phases[], u64 perf row (calls, native events, overhead events);
+ * u64 unattributed phases[]; u32 counts, each str name, u64 us; u32 pools,
+ * each str name, u64 allocs, reused, frees, released; u64 async ops,
+ * max in flight, issue_us, complete_us, overlap_us; u32 skews,
+ * each str name, i32 ops, u64 total, u64 max, i32 slowest rank, f64 wasted.
+ * A str is a u16 length and the bytes, a hist is u64 count, sum, max, u32
+ * non-empty buckets and for each u32 index, u32 count.
+ */
+static unsigned long callback_duration_sum(int func_id) {
+    unsigned long duration = 0;
+
+    for (stat_block* b = stat_blocks_head(); b; b = b->next)
+        if (b->func_durations)
+            duration += b->func_durations[func_id];
+    return duration;
+}
+
+static void json_str(FILE* f, const char* str) {
+    fputc('"', f);
+    for (const unsigned char* p = (const unsigned char*)(str ? str : ""); *p; p++) {
+        if (*p == '"' || *p == '\\')
+            fprintf(f, "\\%c", *p);
+        else if (*p < 0x20)
+            fprintf(f, "\\u%04x", *p);
+        else
+            fputc(*p, f);
+    }
+    fputc('"', f);
+}
+
+static void json_hist(FILE* f, const stat_hist* hist) {
+    int first = 1;
+
+    fprintf(f, "{\"count\":%lu,\"sum\":%lu,\"max\":%lu,\"p50\":%lu,\"p99\":%lu,\"p999\":%lu,\"buckets\":[",
+        hist->count, hist->sum, hist->max, stat_hist_percentile(hist, 0.5),
+        stat_hist_percentile(hist, 0.99), stat_hist_percentile(hist, 0.999));
+    for (int i = 0; i < STAT_HIST_BUCKETS; i++) {
+        if (hist->buckets[i] == 0)
+            continue;
+        fprintf(f, "%s[%d,%u]", first ? "" : ",", i, hist->buckets[i]);
+        first = 0;
+    }
+    fputs("]}", f);
+}
+
+static void json_phases(FILE* f, const unsigned long* ns) {
+    fputc('{', f);
+    for (int p = 0; p < STAT_PHASE_COUNT; p++)
+        fprintf(f, "%s\"%s\":%lu", p ? "," : "", STAT_PHASE_NAMES[p], ns[p]);
+    fputc('}', f);
+}
+
+static void json_stat(FILE* f, const Stat* stat) {
+    fputc('{', f);
+    for (size_t i = 0; i < sizeof(STAT_FIELDS) / sizeof(STAT_FIELDS[0]); i++)
+        fprintf(f, "%s\"%s\":%lu", i ? "," : "", STAT_FIELDS[i].name,
+            *(const unsigned long*)((const char*)stat + STAT_FIELDS[i].offset));
+    fputc('}', f);
+}
+
+static void record_json(FILE* f, const stat_record_info* info, duration_ht* counts,
+        stat_hist* native, stat_hist* overhead) {
+    unsigned long ns[STAT_PHASE_COUNT];
+    unsigned long row[STAT_PERF_ROW];
+    Stat prov, connector;
+    int first = 1;
+
+    stat_blocks_sum(&prov, &connector);
+    fprintf(f, "{\"format\":\"provio-stat\",\"version\":%d,\"run_id\":", STAT_RECORD_VERSION);
+    json_str(f, info->run_id);
+    fprintf(f, ",\"rank\":%d,\"nprocs\":%d,\"config_hash\":\"%016lx\",\"program\":",
+        info->rank, info->nprocs, info->config_hash);
+    json_str(f, info->program);
+    fprintf(f, ",\"start_us\":%lu,\"end_us\":%lu,\"timer\":{\"source\":\"%s\",\"read_cost_ns\":%lu}",
+        info->start_time, info->end_time,
+        TIMER_SOURCE == STAT_TIMER_TSC ? "tsc" : "monotonic", TIMER_READ_COST);
+    fputs(",\"perf_events\":[", f);
+    for (int e = 0; e < STAT_PERF_COUNT; e++)
+        if (PERF_AVAILABLE & (1 << e)) {
+            fprintf(f, "%s\"%s\"", first ? "" : ",", STAT_PERF_NAMES[e]);
+            first = 0;
+        }
+    fprintf(f, "],\"perf_read_cost_ns\":%lu,\"hist_sub_bits\":%d,\"prov\":",
+        PERF_READ_COST, STAT_HIST_SUB_BITS);
+    json_stat(f, &prov);
+    fputs(",\"connector\":", f);
+    json_stat(f, &connector);
+
+    fputs(",\"callbacks\":{", f);
+    first = 1;
+    for (int i = 0; i < FUNC_TABLE_SIZE; i++) {
+        unsigned long duration = callback_duration_sum(i);
+
+        callback_hist_sum(i, native, overhead);
+        if (duration == 0 && native->count == 0)
+            continue;
+        if (!first)
+            fputc(',', f);
+        first = 0;
+        json_str(f, FUNC_NAMES[i]);
+        fprintf(f, ":{\"overhead_us\":%lu,\"native\":", duration);
+        json_hist(f, native);
+        fputs(",\"overhead\":", f);
+        json_hist(f, overhead);
+        if (phase_sum(i, ns)) {
+            fputs(",\"phases_ns\":", f);
+            json_phases(f, ns);
+        }
+        perf_sum(i, row);
+        if (row[0]) {
+            fprintf(f, ",\"perf\":{\"calls\":%lu", row[0]);
+            for (int kind = 0; kind < 2; kind++) {
+                int e_first = 1;
+                fprintf(f, ",\"%s\":{", kind ? "overhead" : "native");
+                for (int e = 0; e < STAT_PERF_COUNT; e++)
+                    if (PERF_AVAILABLE & (1 << e)) {
+                        fprintf(f, "%s\"%s\":%lu", e_first ? "" : ",", STAT_PERF_NAMES[e],
+                            row[1 + kind * STAT_PERF_COUNT + e]);
+                        e_first = 0;
+                    }
+                fputc('}', f);
+            }
+            fputc('}', f);
+        }
+        fputc('}', f);
+    }
+    fputs("},\"unattributed_phases_ns\":", f);
+    phase_sum(FUNC_TABLE_SIZE, ns);
+    json_phases(f, ns);
+
+    fputs(",\"counts\":{", f);
+    first = 1;
+    if (counts) {
+        hti it = stat_iterator(counts);
+        while (stat_next(&it)) {
+            if (!first)
+                fputc(',', f);
+            first = 0;
+            json_str(f, it.key);
+            fprintf(f, ":%lu", *(unsigned long*)it.value);
+        }
+    }
+    fputs("},\"pools\":{", f);
+    first = 1;
+    for (int i = 0; i < POOL_TABLE_SIZE; i++) {
+        stat_pool_counts sum;
+
+        if (!pool_sum(i, &sum))
+            continue;
+        if (!first)
+            fputc(',', f);
+        first = 0;
+        json_str(f, POOL_NAMES[i]);
+        fprintf(f, ":{\"allocs\":%lu,\"reused\":%lu,\"frees\":%lu,\"released\":%lu}",
+            sum.allocs, sum.reused, sum.frees, sum.released);
+    }
+    fprintf(f, "},\"async\":{\"ops\":%lu,\"max_in_flight\":%lu,\"issue_us\":%lu,"
+        "\"complete_us\":%lu,\"overlap_us\":%lu}", ASYNC.ops, ASYNC.max_in_flight,
+        ASYNC.issue_us, ASYNC.complete_us, ASYNC.overlap_us);
+    fputs(",\"coll_skew\":[", f);
+    for (coll_skew_entry* entry = COLL_SKEW_HEAD; entry; entry = entry->next) {
+        fprintf(f, "%s{\"name\":", entry == COLL_SKEW_HEAD ? "" : ",");
+        json_str(f, entry->name);
+        fprintf(f, ",\"ops\":%d,\"total_skew_us\":%lu,\"max_skew_us\":%lu,\"slowest_rank\":%d,\"wasted_rank_s\":%.6f}",
+            entry->ops, entry->total_skew, entry->max_skew, entry->slowest_rank, entry->wasted);
+    }
+    fputs("]}\n", f);
+}
+
+static void bin_u32(FILE* f, uint32_t v) {
+    fwrite(&v, sizeof(v), 1, f);
+}
+
+static void bin_u64(FILE* f, uint64_t v) {
+    fwrite(&v, sizeof(v), 1, f);
+}
+
+static void bin_str(FILE* f, const char* str) {
+    size_t len = str ? strlen(str) : 0;
+    uint16_t len16 = len > UINT16_MAX ? UINT16_MAX : (uint16_t)len;
+
+    fwrite(&len16, sizeof(len16), 1, f);
+    if (len16)
+        fwrite(str, 1, len16, f);
+}
+
+static void bin_hist(FILE* f, const stat_hist* hist) {
+    uint32_t nonzero = 0;
+
+    bin_u64(f, hist->count);
+    bin_u64(f, hist->sum);
+    bin_u64(f, hist->max);
+    for (int i = 0; i < STAT_HIST_BUCKETS; i++)
+        nonzero += hist->buckets[i] != 0;
+    bin_u32(f, nonzero);
+    for (int i = 0; i < STAT_HIST_BUCKETS; i++)
+        if (hist->buckets[i]) {
+            bin_u32(f, (uint32_t)i);
+            bin_u32(f, hist->buckets[i]);
+        }
+}
+
+static void record_binary(FILE* f, const stat_record_info* info, duration_ht* counts,
+        stat_hist* native, stat_hist* overhead) {
+    unsigned long ns[STAT_PHASE_COUNT];
+    unsigned long row[STAT_PERF_ROW];
+    Stat prov, connector;
+    uint32_t n = 0;
+
+    stat_blocks_sum(&prov, &connector);
+    bin_u32(f, STAT_RECORD_MAGIC);
+    bin_u32(f, STAT_RECORD_VERSION);
+    bin_u32(f, 0);      // length, filled in by stat_record_write
+    bin_u32(f, (uint32_t)info->rank);
+    bin_u32(f, (uint32_t)info->nprocs);
+    bin_u32(f, STAT_HIST_SUB_BITS);
+    bin_u32(f, TIMER_SOURCE == STAT_TIMER_TSC);
+    bin_u32(f, (uint32_t)PERF_AVAILABLE);
+    bin_u64(f, info->config_hash);
+    bin_u64(f, info->start_time);
+    bin_u64(f, info->end_time);
+    bin_u64(f, TIMER_READ_COST);
+    bin_u64(f, PERF_READ_COST);
+    bin_str(f, info->run_id);
+    bin_str(f, info->program);
+
+    bin_u32(f, STAT_PHASE_COUNT);
+    for (int p = 0; p < STAT_PHASE_COUNT; p++)
+        bin_str(f, STAT_PHASE_NAMES[p]);
+    bin_u32(f, STAT_PERF_COUNT);
+    for (int e = 0; e < STAT_PERF_COUNT; e++)
+        bin_str(f, STAT_PERF_NAMES[e]);
+    bin_u32(f, sizeof(STAT_FIELDS) / sizeof(STAT_FIELDS[0]));
+    for (size_t i = 0; i < sizeof(STAT_FIELDS) / sizeof(STAT_FIELDS[0]); i++) {
+        bin_str(f, STAT_FIELDS[i].name);
+        bin_u64(f, *(unsigned long*)((char*)&prov + STAT_FIELDS[i].offset));
+        bin_u64(f, *(unsigned long*)((char*)&connector + STAT_FIELDS[i].offset));
+    }
+
+    for (int i = 0; i < FUNC_TABLE_SIZE; i++) {
+        callback_hist_sum(i, native, overhead);
+        n += callback_duration_sum(i) || native->count;
+    }
+    bin_u32(f, n);
+    for (int i = 0; i < FUNC_TABLE_SIZE; i++) {
+        unsigned long duration = callback_duration_sum(i);
+
+        callback_hist_sum(i, native, overhead);
+        if (duration == 0 && native->count == 0)
+            continue;
+        bin_str(f, FUNC_NAMES[i]);
+        bin_u64(f, duration);
+        bin_hist(f, native);
+        bin_hist(f, overhead);
+        phase_sum(i, ns);
+        for (int p = 0; p < STAT_PHASE_COUNT; p++)
+            bin_u64(f, ns[p]);
+        perf_sum(i, row);
+        for (int r = 0; r < STAT_PERF_ROW; r++)
+            bin_u64(f, row[r]);
+    }
+    phase_sum(FUNC_TABLE_SIZE, ns);
+    for (int p = 0; p < STAT_PHASE_COUNT; p++)
+        bin_u64(f, ns[p]);
+
+    bin_u32(f, counts ? (uint32_t)stat_length(counts) : 0);
+    if (counts) {
+        hti it = stat_iterator(counts);
+        while (stat_next(&it)) {
+            bin_str(f, it.key);
+            bin_u64(f, *(unsigned long*)it.value);
+        }
+    }
+    n = 0;
+    for (int i = 0; i < POOL_TABLE_SIZE; i++) {
+        stat_pool_counts sum;
+        n += pool_sum(i, &sum);
+    }
+    bin_u32(f, n);
+    for (int i = 0; i < POOL_TABLE_SIZE; i++) {
+        stat_pool_counts sum;
+
+        if (!pool_sum(i, &sum))
+            continue;
+        bin_str(f, POOL_NAMES[i]);
+        bin_u64(f, sum.allocs);
+        bin_u64(f, sum.reused);
+        bin_u64(f, sum.frees);
+        bin_u64(f, sum.released);
+    }
+    bin_u64(f, ASYNC.ops);
+    bin_u64(f, ASYNC.max_in_flight);
+    bin_u64(f, ASYNC.issue_us);
+    bin_u64(f, ASYNC.complete_us);
+    bin_u64(f, ASYNC.overlap_us);
+    n = 0;
+    for (coll_skew_entry* entry = COLL_SKEW_HEAD; entry; entry = entry->next)
+        n++;
+    bin_u32(f, n);
+    for (coll_skew_entry* entry = COLL_SKEW_HEAD; entry; entry = entry->next) {
+        bin_str(f, entry->name);
+        bin_u32(f, (uint32_t)entry->ops);
+        bin_u64(f, entry->total_skew);
+        bin_u64(f, entry->max_skew);
+        bin_u32(f, (uint32_t)entry->slowest_rank);
+        fwrite(&entry->wasted, sizeof(double), 1, f);
+    }
+}
+
+int stat_record_write(const char* path, int binary, const stat_record_info* info,
+        duration_ht* counts) {
+    stat_hist* hists = malloc(2 * sizeof(stat_hist));
+    char* buf = NULL;
+    size_t len = 0;
+    struct flock lock;
+    int fd, ret = 0;
+    FILE* f;
+
+    if (hists == NULL)
+        return -1;
+    f = open_memstream(&buf, &len);
+    if (f == NULL) {
+        free(hists);
+        return -1;
+    }
+    counts_merge_blocks(counts);
+    // Phases recorded outside of any callback
+    for (stat_block* b = stat_blocks_head(); b; b = b->next)
+        if (b->phase_any)
+            phase_drain(b, FUNC_TABLE_SIZE);
+    if (binary)
+        record_binary(f, info, counts, &hists[0], &hists[1]);
+    else
+        record_json(f, info, counts, &hists[0], &hists[1]);
+    fclose(f);
+    free(hists);
+    if (buf == NULL)
+        return -1;
+    if (binary && len >= 3 * sizeof(uint32_t)) {
+        uint32_t len32 = (uint32_t)len;
+        memcpy(buf + 2 * sizeof(uint32_t), &len32, sizeof(len32));
+    }
+
+    fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        printf("stat_record: failed to open %s\n", path);
+        free(buf);
+        return -1;
+    }
+    // Ranks and concurrent runs append to the same file
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    fcntl(fd, F_SETLKW, &lock);
+    if (write(fd, buf, len) != (ssize_t)len)
+        ret = -1;
+    lock.l_type = F_UNLCK;
+    fcntl(fd, F_SETLK, &lock);
+    close(fd);
+    free(buf);
+    return ret;
+}
+
 /* Initialize file handle within this function with given path */
 void stat_print(int MPI_RANK, Stat* prov_stat, duration_ht* counts, 
     const char* path) {
@@ -232,13 +1725,21 @@ void stat_print(int MPI_RANK, Stat* prov_stat, duration_ht* counts,
         prov_stat->ATTR_LL_TOTAL_TIME,
         prov_stat->PROV_SERIALIZE_TIME);
         fputs(pline, stat_file_handle);
+        sprintf(pline, "TIMER_SOURCE %s\nTIMER_READ_COST %lu ns\n",
+            TIMER_SOURCE == STAT_TIMER_TSC ? "tsc" : "monotonic", TIMER_READ_COST);
+        fputs(pline, stat_file_handle);
+        perf_events_print(stat_file_handle);
     }
 
+    func_table_print(stat_file_handle);
+    pool_print(stat_file_handle);
+    async_print(stat_file_handle);
+    counts_merge_blocks(counts);
     hti it = stat_iterator(counts);
     // Iteratively print out accumulated duration hash table, freeing values as we go.
     while (stat_next(&it)) {
         sprintf(pline,
-            "%s %d us\n", it.key, *(int*)it.value);
+            "%s %lu us\n", it.key, *(unsigned long*)it.value);
         if (stat_file_handle != NULL) {
             fputs(pline, stat_file_handle);
         }
@@ -247,6 +1748,7 @@ void stat_print(int MPI_RANK, Stat* prov_stat, duration_ht* counts,
         }        
         free(it.value);
     }
+    coll_skew_print(stat_file_handle);
     fclose(stat_file_handle);
 }
 
@@ -278,13 +1780,21 @@ void stat_print_(int MPI_RANK, Stat* prov_stat, duration_ht*
         prov_stat->ATTR_LL_TOTAL_TIME,
         prov_stat->PROV_SERIALIZE_TIME);
         fputs(pline, stat_file_handle);
+        sprintf(pline, "TIMER_SOURCE %s\nTIMER_READ_COST %lu ns\n",
+            TIMER_SOURCE == STAT_TIMER_TSC ? "tsc" : "monotonic", TIMER_READ_COST);
+        fputs(pline, stat_file_handle);
+        perf_events_print(stat_file_handle);
     }
 
+    func_table_print(stat_file_handle);
+    pool_print(stat_file_handle);
+    async_print(stat_file_handle);
+    counts_merge_blocks(counts);
     hti it = stat_iterator(counts);
     // Iteratively print out accumulated duration hash table, freeing values as we go.
     while (stat_next(&it)) {
         sprintf(pline,
-            "%s %d us\n", it.key, *(int*)it.value);
+            "%s %lu us\n", it.key, *(unsigned long*)it.value);
         if (stat_file_handle != NULL) {
             fputs(pline, stat_file_handle);
         }
@@ -293,4 +1803,5 @@ void stat_print_(int MPI_RANK, Stat* prov_stat, duration_ht*
         }        
         free(it.value);
     }
+    coll_skew_print(stat_file_handle);
 }
\ No newline at end of file
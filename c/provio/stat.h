@@ -19,6 +19,33 @@ typedef struct Stat {
     unsigned long PROV_SERIALIZE_TIME;      //
 } Stat;
 
+/* Collective transfer skew of one dataset, reduced across ranks */
+typedef struct coll_skew_entry {
+    char* name;
+    int ops;                    // collective transfers
+    unsigned long total_skew;   // sum of (last entry - first entry) over all transfers, us
+    unsigned long max_skew;     // largest single transfer skew, us
+    int slowest_rank;           // rank that entered last most often
+    double wasted;              // rank-seconds spent waiting for the last rank
+    struct coll_skew_entry* next;
+} coll_skew_entry;
+
+/* Log-linear latency histogram in us (HDR style): values below
+ * 2^STAT_HIST_SUB_BITS are counted exactly, every larger power of two is
+ * split into 2^STAT_HIST_SUB_BITS linear buckets, so the relative error of a
+ * reported percentile stays below 1/2^STAT_HIST_SUB_BITS. Histograms with
+ * the same layout merge by adding buckets. */
+#define STAT_HIST_SUB_BITS 4
+#define STAT_HIST_MAX_BITS 40       // larger values (> 12 days) share the last bucket
+#define STAT_HIST_BUCKETS ((STAT_HIST_MAX_BITS - STAT_HIST_SUB_BITS + 1) << STAT_HIST_SUB_BITS)
+
+typedef struct stat_hist {
+    unsigned long count;
+    unsigned long sum;
+    unsigned long max;
+    unsigned int buckets[STAT_HIST_BUCKETS];
+} stat_hist;
+
 typedef struct {
     const char* key;  // key is NULL if this slot is empty
     void* value;
@@ -39,9 +66,236 @@ typedef struct {
     size_t _index;    // current index into ht._entries
 } hti;
 
+/* Phases of the provenance overhead, timed in ns when built with
+ * -DPROVIO_PHASE_STAT. Phase times are exclusive: a phase nested in another
+ * one is subtracted from it. They are attributed to the callback that
+ * records its duration next (accumulate_duration_id). */
+typedef enum stat_phase_t {
+    STAT_PHASE_NAME,    // object name lookup
+    STAT_PHASE_FILL,    // prov_fill_* field copies
+    STAT_PHASE_UUID,    // UUID generation
+    STAT_PHASE_NODE,    // librdf node and statement creation
+    STAT_PHASE_STORE,   // librdf model insertion
+    STAT_PHASE_TEXT,    // plain-text line formatting and writes
+    STAT_PHASE_LIST,    // connector object list maintenance
+    STAT_PHASE_COUNT
+} stat_phase_t;
+
+#define STAT_PHASE_DEPTH 8
+
+#ifdef PROVIO_PHASE_STAT
+#define STAT_PHASE_BEGIN(phase) stat_phase_begin(phase)
+#define STAT_PHASE_END() stat_phase_end()
+// For regions with several exits
+#define STAT_PHASE_START(t) unsigned long t = stat_timer_ns()
+#define STAT_PHASE_STOP(phase, t) stat_phase_add(phase, stat_timer_ns() - (t))
+#else
+#define STAT_PHASE_BEGIN(phase)
+#define STAT_PHASE_END()
+#define STAT_PHASE_START(t)
+#define STAT_PHASE_STOP(phase, t)
+#endif
+
+/* Event counters around the native call and the provenance work of a
+ * callback, read with perf_event_open (Linux) when ENABLE_PERF_COUNTERS=T.
+ * Each thread opens its own counters on its first sample. Events the kernel
+ * refuses (no PMU in a VM, perf_event_paranoid, seccomp in containers) are
+ * left out; sampling does nothing when no event could be opened. */
+typedef enum stat_perf_event {
+    STAT_PERF_TASK_CLOCK,       // ns on a CPU
+    STAT_PERF_CTX_SWITCHES,
+    STAT_PERF_PAGE_FAULTS,
+    STAT_PERF_CYCLES,
+    STAT_PERF_INSTRUCTIONS,
+    STAT_PERF_CACHE_MISSES,
+    STAT_PERF_COUNT
+} stat_perf_event;
+
+// Samples taken by one callback, passed to stat_perf_record() as an array
+typedef enum stat_perf_point {
+    STAT_PERF_ENTRY,
+    STAT_PERF_NATIVE_BEGIN,     // right before the native call is timed
+    STAT_PERF_NATIVE_END,       // right after
+    STAT_PERF_EXIT,             // before the callback records its duration
+    STAT_PERF_POINTS
+} stat_perf_point;
+
+#define STAT_PERF_GROUPS 2      // software and hardware events are read as two groups
+#define STAT_PERF_COST_READS 100
+
+typedef struct stat_perf_sample {
+    unsigned long v[STAT_PERF_COUNT];
+} stat_perf_sample;
+
+/* Allocation counters of one object pool of the VOL connector, pool ids
+ * index the names given to stat_pool_table_init() */
+#define STAT_POOL_MAX 16
+
+typedef struct stat_pool_counts {
+    unsigned long allocs;           // objects handed out
+    unsigned long reused;           // of these, taken from a freelist
+    unsigned long frees;            // objects given back
+    unsigned long released;         // of these, passed on to free()
+} stat_pool_counts;
+
+/* Requests of an async VOL below the connector, set once at its term */
+typedef struct stat_async_counts {
+    unsigned long ops;              // operations recorded at their completion
+    unsigned long max_in_flight;    // most requests in flight at once
+    unsigned long issue_us;         // time the application spent in the calls
+    unsigned long complete_us;      // call to completion
+    unsigned long overlap_us;       // part of it the application kept running
+} stat_async_counts;
+
+/* Per-thread statistics. Each thread adds to its own cache-line aligned
+ * block with plain increments; a block is pushed once onto a lock-free list
+ * on the thread's first update and the print functions sum all blocks. */
+#define STAT_CACHE_LINE 64
+
+typedef struct stat_block {
+    Stat prov;                      // libprovio counters, see prov_stat
+    Stat connector;                 // VOL connector counters
+    unsigned long* func_durations;  // indexed by stat_func_table_init() ids
+    stat_hist** native_hists;
+    stat_hist** overhead_hists;
+    duration_ht* counts;            // user-defined func_stat names
+    unsigned long timer_reads;      // get_time_usec() calls, their cost is taken off overheads
+    unsigned long timer_reads_charged;
+    unsigned long* phase_ns;        // STAT_PHASE_COUNT per callback id, unattributed last
+    unsigned long phase_pending[STAT_PHASE_COUNT];
+    int phase_any;                  // phase_pending is not all zero
+    int perf_state;                 // 0 not opened yet, 1 counting, -1 no events
+    int perf_fd[STAT_PERF_COUNT];
+    int perf_slot[STAT_PERF_COUNT]; // position in its group's read, -1 if not opened
+    int perf_leader[STAT_PERF_GROUPS];
+    unsigned long perf_reads;       // stat_perf_read() calls, charged like timer_reads
+    unsigned long perf_reads_charged;
+    unsigned long* perf;            // per callback id: calls, native and overhead event counts
+    stat_pool_counts pools[STAT_POOL_MAX];
+    int phase_depth;
+    int phase_stack[STAT_PHASE_DEPTH];
+    unsigned long phase_start[STAT_PHASE_DEPTH];
+    unsigned long phase_child[STAT_PHASE_DEPTH];
+    struct stat_block* next;
+} __attribute__((aligned(STAT_CACHE_LINE))) stat_block;
+
+extern __thread stat_block* STAT_LOCAL_BLOCK;
+stat_block* stat_block_register(void);
+
+static inline stat_block* stat_local_block(void) {
+    return STAT_LOCAL_BLOCK ? STAT_LOCAL_BLOCK : stat_block_register();
+}
+
+static inline stat_pool_counts* stat_pool_local(int pool_id) {
+    return &stat_local_block()->pools[pool_id];
+}
+
+// Sum of all threads' blocks, either output may be NULL
+void stat_blocks_sum(Stat* prov_out, Stat* connector_out);
+// This thread's table for accumulate_duration()
+duration_ht* stat_local_counts(void);
+
+/* Live statistics segment, STAT_SHM_DIR/provio.<pid>. A stat_shm_header is
+ * followed by callback_cnt stat_shm_callback records. The writer makes seq
+ * odd before updating and even again afterwards; a reader copies the segment
+ * and retries while seq is odd or has changed (seqlock). */
+#define STAT_SHM_DIR "/dev/shm"
+#define STAT_SHM_MAGIC 0x31565250     // "PRV1"
+#define STAT_SHM_VERSION 1
+#define STAT_SHM_NAME_LEN 64
+
+typedef struct stat_shm_header {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int seq;
+    int rank;
+    int pid;
+    unsigned int header_size;       // offset of the first callback record
+    unsigned int callback_cnt;
+    unsigned int callback_size;
+    unsigned int hist_buckets;      // STAT_HIST_BUCKETS of the writer
+    unsigned int hist_sub_bits;     // STAT_HIST_SUB_BITS of the writer
+    unsigned long start_time;       // us since epoch
+    unsigned long update_time;
+    Stat prov;
+    Stat connector;
+} stat_shm_header;
+
+typedef struct stat_shm_callback {
+    char name[STAT_SHM_NAME_LEN];
+    stat_hist native;
+    stat_hist overhead;
+} stat_shm_callback;
+
+// Publish every interval_usec from the stat calls, the segment is created on the first publish
+void stat_shm_open(int rank, unsigned long interval_usec);
+void stat_shm_close(void);
+
+/* Time series file: every interval_usec one CSV row per counter and per
+ * callback histogram that changed, holding the change since the last row.
+ * Times are local time + clock_offset (rank 0's clock with clock sync). */
+#define STAT_SERIES_VERSION 1
+#define STAT_SERIES_BUFFER (64 * 1024)  // rows are written when it fills up
+int stat_series_open(const char* path, int rank, unsigned long interval_usec, long clock_offset);
+void stat_series_close(void);
+
+/* Structured record of one rank's statistics at teardown, appended to a file
+ * shared by ranks and runs: one JSON object per line, or with binary a
+ * length-prefixed record in host byte order (layout in stat_record_write).
+ * Each record is written with one write() under an fcntl lock. */
+#define STAT_RECORD_VERSION 3
+#define STAT_RECORD_MAGIC 0x31525250    // "PRR1"
+
+typedef struct stat_record_info {
+    const char* run_id;         // shared by all ranks of a run
+    int rank;
+    int nprocs;
+    unsigned long config_hash;
+    const char* program;
+    unsigned long start_time;   // us since epoch
+    unsigned long end_time;
+} stat_record_info;
+
+/* Merges the thread name tables into counts like stat_print_(), nothing is
+ * freed so the text statistics can be printed afterwards */
+int stat_record_write(const char* path, int binary, const stat_record_info* info,
+        duration_ht* counts);
+
+// Called after every recorded duration, runs the periodic shm/series updates
+void stat_tick(void);
+
+/* Timer. Reads the invariant TSC (rdtscp) when the CPU has one and
+ * CLOCK_MONOTONIC otherwise, calibrated by stat_timer_init(). get_time_usec()
+ * returns us since the epoch: the timer is anchored to the wall clock and
+ * re-anchored every STAT_TIMER_REANCHOR us by adjusting its rate, so it
+ * never steps backwards. */
+#define STAT_TIMER_CALIBRATE 2000       // us spent measuring the TSC rate
+#define STAT_TIMER_REANCHOR 1000000
+#define STAT_TIMER_COST_READS 1000      // reads timed to estimate the read cost
+
+typedef enum stat_timer_source {
+    STAT_TIMER_MONOTONIC,
+    STAT_TIMER_TSC
+} stat_timer_source;
+
+// allow_tsc 0 forces CLOCK_MONOTONIC, may be called again to recalibrate
+void stat_timer_init(int allow_tsc);
+stat_timer_source stat_timer_get_source(void);
+unsigned long stat_timer_read_cost(void);   // ns per get_time_usec()
+
+// Returns the number of events this thread could open, 0 disables sampling
+int stat_perf_open(int enable);
+void stat_perf_close(void);
+void stat_perf_read(stat_perf_sample* sample);
+// samples holds STAT_PERF_POINTS reads of callback func_id
+void stat_perf_record(int func_id, const stat_perf_sample* samples);
+
 /* Helper methods */
 unsigned long get_time_usec(void);
-void _dic_init_int(void);
+unsigned long stat_timer_ns(void);      // monotonic, for short intervals
+void stat_phase_begin(int phase);
+void stat_phase_end(void);
+void stat_phase_add(int phase, unsigned long ns);
 
 
 /* Stat hash table user methods */
@@ -49,6 +303,19 @@ duration_ht* stat_create(int capacity);
 void stat_destroy(duration_ht* table);
 void accumulate_duration(duration_ht* counts, const char* func_name,
                             unsigned long elapsed);
+// Flat counters for a fixed set of functions, ids index names[]
+void stat_func_table_init(const char* const* names, int count);
+void accumulate_duration_id(int func_id, unsigned long native, unsigned long overhead);
+// Names of the pools counted in stat_pool_local(), at most STAT_POOL_MAX
+void stat_pool_table_init(const char* const* names, int count);
+/* Latency histograms */
+void stat_hist_record(stat_hist* hist, unsigned long value);
+void stat_hist_merge(stat_hist* dst, const stat_hist* src);
+unsigned long stat_hist_percentile(const stat_hist* hist, double q);
+void stat_add_coll_skew(const char* name, int ops, unsigned long total_skew,
+        unsigned long max_skew, int slowest_rank, double wasted);
+// Counters of requests of an async VOL below the connector
+void stat_set_async(const stat_async_counts* counts);
 // Dump to file, print if leave as NULL
 void stat_print(int MPI_RANK, Stat* prov_stat, 
         duration_ht* counts, const char* path);
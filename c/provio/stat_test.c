@@ -1,7 +1,12 @@
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <assert.h>
 #include "stat.h"
 
+#define STAT_RECORD_JSON "stat_record.jsonl"
+#define STAT_RECORD_BIN "stat_record.bin"
+
 
 duration_ht* FUNCTION_FREQUENCY;
 
@@ -30,7 +35,106 @@ void function_3() {
 	accumulate_duration(FUNCTION_FREQUENCY, __func__, elapsed);
 }
 
+/* Bound of the bucket holding value: with a larger sample recorded after it,
+ * the median is that bound instead of the maximum */
+unsigned long bucket_bound(unsigned long value) {
+	stat_hist hist;
+
+	memset(&hist, 0, sizeof(hist));
+	stat_hist_record(&hist, value);
+	stat_hist_record(&hist, 1UL << 50);
+	return stat_hist_percentile(&hist, 0.5);
+}
+
+void test_hist_buckets() {
+	unsigned long bound;
+
+	// Exact below 2^STAT_HIST_SUB_BITS
+	for(unsigned long v = 0; v < (1UL << STAT_HIST_SUB_BITS); v++)
+		assert(bucket_bound(v) == v);
+
+	// The bound is the last value of the bucket, the next one starts a new
+	// bucket, and the relative error stays under 1/2^STAT_HIST_SUB_BITS
+	for(unsigned long v = 1UL << STAT_HIST_SUB_BITS; v < (1UL << 34); v += v / 7 + 1) {
+		bound = bucket_bound(v);
+		assert(bound >= v);
+		assert(bound - v < (v >> STAT_HIST_SUB_BITS) + 1);
+		assert(bucket_bound(bound) == bound);
+		assert(bucket_bound(bound + 1) > bound);
+	}
+	assert(bucket_bound(16) == 16 && bucket_bound(17) == 17);
+	assert(bucket_bound(32) == 33 && bucket_bound(33) == 33);
+	assert(bucket_bound(500) == 511 && bucket_bound(990) == 991);
+}
+
+void test_hist_percentiles() {
+	stat_hist uniform, constant, odd, even;
+
+	memset(&uniform, 0, sizeof(uniform));
+	memset(&constant, 0, sizeof(constant));
+	assert(stat_hist_percentile(&uniform, 0.5) == 0);
+
+	// 1..1000: p50 is 500, in bucket [496, 511], p99 is 990, in [960, 991]
+	for(unsigned long v = 1; v <= 1000; v++)
+		stat_hist_record(&uniform, v);
+	assert(uniform.count == 1000 && uniform.sum == 500500 && uniform.max == 1000);
+	assert(stat_hist_percentile(&uniform, 0.5) == 511);
+	assert(stat_hist_percentile(&uniform, 0.99) == 991);
+	assert(stat_hist_percentile(&uniform, 0.0) == 1);
+	assert(stat_hist_percentile(&uniform, 1.0) == 1000);
+
+	// Bounds past the largest sample report the sample
+	for(int i = 0; i < 100; i++)
+		stat_hist_record(&constant, 100);
+	assert(stat_hist_percentile(&constant, 0.5) == 100);
+	assert(stat_hist_percentile(&constant, 0.99) == 100);
+
+	// 100 fast calls and a slow one: p99 is the bound of [96, 103]
+	stat_hist_record(&constant, 1000000);
+	assert(stat_hist_percentile(&constant, 0.99) == 103);
+	assert(stat_hist_percentile(&constant, 1.0) == 1000000);
+
+	// Blocks merged give the histogram of all their samples
+	memset(&odd, 0, sizeof(odd));
+	memset(&even, 0, sizeof(even));
+	for(unsigned long v = 1; v <= 1000; v++)
+		stat_hist_record(v % 2 ? &odd : &even, v);
+	stat_hist_merge(&odd, &even);
+	assert(memcmp(&odd, &uniform, sizeof(stat_hist)) == 0);
+	assert(stat_hist_percentile(&odd, 0.5) == 511);
+	assert(stat_hist_percentile(&odd, 0.99) == 991);
+}
+
+/* The same statistics as a JSON and a binary record, stat_record_test.py in
+ * user_engine/monitor checks that both parse to the same record */
+void write_records(duration_ht* counts) {
+	static const char* func_names[] = {"H5VL_provenance_dataset_read", "H5VL_provenance_file_close"};
+	static const char* pool_names[] = {"obj", "req"};
+	stat_async_counts async = {7, 3, 1200, 3400, 900};
+	stat_record_info info = {"stat_test_run", 0, 1, 0x0123456789abcdefUL, "stat_test",
+		1700000000000000UL, 1700000001000000UL};
+
+	stat_func_table_init(func_names, 2);
+	for(unsigned long v = 1; v <= 1000; v++)
+		accumulate_duration_id(0, v, v % 17);
+	accumulate_duration_id(1, 250000, 40);
+	stat_pool_table_init(pool_names, 2);
+	stat_pool_local(0)->allocs = 5;
+	stat_pool_local(0)->reused = 3;
+	stat_pool_local(1)->frees = 2;
+	stat_set_async(&async);
+	stat_add_coll_skew("H5Fclose", 4, 800, 300, 2, 0.25);
+
+	unlink(STAT_RECORD_JSON);
+	unlink(STAT_RECORD_BIN);
+	assert(stat_record_write(STAT_RECORD_JSON, 0, &info, counts) == 0);
+	assert(stat_record_write(STAT_RECORD_BIN, 1, &info, counts) == 0);
+}
+
 int main() {
+	test_hist_buckets();
+	test_hist_percentiles();
+
 	FUNCTION_FREQUENCY = stat_create(3);
 	for(int i=0; i< 100; i++) {
 		int j = rand() % 4;
@@ -46,6 +150,7 @@ int main() {
 				break;
 		}
 	}
+	write_records(FUNCTION_FREQUENCY);
 	stat_print(0, NULL, FUNCTION_FREQUENCY, "stat.txt");
 	stat_destroy(FUNCTION_FREQUENCY);
 	return 0;
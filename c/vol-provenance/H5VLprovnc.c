@@ -56,7 +56,36 @@
 #define va_copy(D,S)      ((D) = (S))
 #endif
 
-#define STAT_FUNC_MOD 733//a reasonably big size to avoid expensive collision handling, make sure it works with 62 function names.
+#define COLL_SKEW_MAX_OPS 4096 // collective transfers timed per dataset between closes
+#define DEP_MAX_RANK 4          // dataset dimensions tracked by the dependency detector
+#define DEP_MAX_EDGES 1024      // distinct dependency edges reported per file close
+
+/* VOL callbacks, in H5VL_provenance_cls order. Expanded into the PROV_CB_*
+ * ids that index the per-callback stat counters and into their names.
+ * The count is checked against the class struct below it. */
+#define PROV_VOL_CALLBACKS(X) \
+    X(init) X(term) \
+    X(info_copy) X(info_cmp) X(info_free) X(info_to_str) X(str_to_info) \
+    X(get_object) X(get_wrap_ctx) X(wrap_object) X(unwrap_object) X(free_wrap_ctx) \
+    X(attr_create) X(attr_open) X(attr_read) X(attr_write) X(attr_get) \
+    X(attr_specific) X(attr_optional) X(attr_close) \
+    X(dataset_create) X(dataset_open) X(dataset_read) X(dataset_write) X(dataset_get) \
+    X(dataset_specific) X(dataset_optional) X(dataset_close) \
+    X(datatype_commit) X(datatype_open) X(datatype_get) \
+    X(datatype_specific) X(datatype_optional) X(datatype_close) \
+    X(file_create) X(file_open) X(file_get) \
+    X(file_specific) X(file_optional) X(file_close) \
+    X(group_create) X(group_open) X(group_get) \
+    X(group_specific) X(group_optional) X(group_close) \
+    X(link_create) X(link_copy) X(link_move) X(link_get) \
+    X(link_specific) X(link_optional) \
+    X(object_open) X(object_copy) X(object_get) X(object_specific) X(object_optional) \
+    X(introspect_get_cap_flags) X(introspect_opt_query) \
+    X(request_wait) X(request_notify) X(request_cancel) \
+    X(request_specific) X(request_optional) X(request_free) \
+    X(blob_put) X(blob_get) X(blob_specific) X(blob_optional) \
+    X(token_cmp) X(token_to_str) X(token_from_str) \
+    X(optional)
 
 //H5PL_type_t H5PLget_plugin_type(void) {return H5PL_TYPE_FILTER;}
 //const void *H5PLget_plugin_info(void) {return &H5VL_provenance_cls;}
@@ -64,12 +93,34 @@
 /************/
 /* Typedefs */
 /************/
+#define PROV_CB_ID(name) PROV_CB_##name,
+typedef enum prov_cb_id_t {
+    PROV_VOL_CALLBACKS(PROV_CB_ID)
+    PROV_CB_COUNT
+} prov_cb_id_t;
+#undef PROV_CB_ID
+
 typedef struct H5VL_prov_dataset_info_t dataset_prov_info_t;
 typedef struct H5VL_prov_group_info_t group_prov_info_t;
 typedef struct H5VL_prov_datatype_info_t datatype_prov_info_t;
 typedef struct H5VL_prov_attribute_info_t attribute_prov_info_t;
 typedef struct H5VL_prov_file_info_t file_prov_info_t;
 
+/* Chained hash table of the open files of a process, or of the open objects
+ * of one class in a file. Nodes are embedded in the prov info structs, keyed
+ * by the file number or a hash of the object token. */
+typedef struct H5VL_prov_hash_node_t prov_hash_node_t;
+struct H5VL_prov_hash_node_t {
+    prov_hash_node_t *next;      // Next node in the same bucket
+    unsigned long key;
+};
+
+typedef struct H5VL_prov_hash_t {
+    prov_hash_node_t **buckets;
+    unsigned long nbuckets;      // Power of two, 0 before the first insert
+    int cnt;
+} prov_hash_t;
+
 typedef struct ProvenanceHelper {
     /* Provenance properties */
     char* prov_file_path;
@@ -81,8 +132,7 @@ typedef struct ProvenanceHelper {
     pthread_t tid;
     char proc_name[64];
     int ptr_cnt;
-    int opened_files_cnt;
-    file_prov_info_t* opened_files;//linkedlist,
+    prov_hash_t opened_files;   // file_prov_info_t by file_no
 } prov_helper_t;
 
 typedef struct H5VL_provenance_t {
@@ -93,6 +143,8 @@ typedef struct H5VL_provenance_t {
     void *generic_prov_info;    /* Pointer to a class-specific prov info struct. */
                                 /* Should be cast to layer-specific type before use, */
                                 /* such as file_prov_info, dataset_prov_info. */
+    struct prov_pending_t *pending; /* Requests only, see prov_record_add() */
+    file_prov_info_t *bare_file;    /* Objects without prov info, see obj_wrap_bare() */
 } H5VL_provenance_t;
 
 /* The PROVENANCE VOL wrapper context */
@@ -112,7 +164,55 @@ typedef struct H5VL_provenance_wrap_ctx_t {
 //    int func_cnt;//stats
 //} H5VL_prov_t;
 
+#ifdef H5_HAVE_PARALLEL
+typedef enum dep_op_t {
+    DEP_READ,
+    DEP_WRITE
+} dep_op_t;
+
+// Compact summary of dataset accesses, exchanged between ranks at file close
+typedef struct H5VL_prov_dep_access_t {
+    H5O_token_t token;                  // Dataset within the file
+    char name[64];
+    int rank;                           // Rank in the file's communicator
+    int op;                             // dep_op_t
+    int ndims;                          // Tracked dimensions, at most DEP_MAX_RANK
+    unsigned long start;                // Global time of the first access (us)
+    unsigned long end;                  // Global time the last access returned (us)
+    hsize_t lo[DEP_MAX_RANK];           // Selection bounds in blocks of
+    hsize_t hi[DEP_MAX_RANK];           // DEP_GRANULARITY elements, inclusive
+} dep_access_t;
+#endif /* H5_HAVE_PARALLEL */
+
+/* A file's own records, kept for ENABLE_EMBED_PROV and written into its
+ * Provenance group when it is closed. Every distinct string is stored once,
+ * records refer to strings by their byte offset. */
+typedef struct H5VL_prov_embed_rec_t {
+    uint64_t time;                      // Start on rank 0's clock (us since epoch)
+    uint64_t duration;                  // us
+    uint64_t bytes;                     // Bytes moved, 0 if none
+    uint32_t object;                    // Offsets of NUL-terminated strings
+    uint32_t type;                      // in the Strings dataset
+    uint32_t relation;
+    uint32_t api;
+    int32_t rank;
+} embed_rec_t;
+
+typedef struct H5VL_prov_embed_t {
+    embed_rec_t *recs;
+    size_t rec_cnt;
+    size_t rec_max;
+    int dropped;                        // Records beyond EMBED_MAX_RECORDS
+    char *strs;                         // Strings, back to back
+    size_t strs_len;
+    size_t strs_max;
+    uint32_t *slots;                    // Open addressing: string offset + 1, 0 if free
+    size_t nslots;                      // Power of two, 0 before the first string
+    size_t str_cnt;
+} prov_embed_t;
+
 struct H5VL_prov_file_info_t {//assigned when a file is closed, serves to store stats (copied from shared_file_info)
+    prov_hash_node_t hash_node;  // In prov_helper->opened_files, must be first
     prov_helper_t* prov_helper;  //pointer shared among all layers, one per process.
     char* file_name;
     unsigned long file_no;
@@ -121,18 +221,23 @@ struct H5VL_prov_file_info_t {//assigned when a file is closed, serves to store
     MPI_Comm mpi_comm;           // Copy of MPI communicator for file
     MPI_Info mpi_info;           // Copy of MPI info for file
     hbool_t mpi_comm_info_valid; // Indicate that MPI Comm & Info are valid
+    dep_access_t *dep_log;       // Dataset accesses since the last file close
+    int dep_cnt;
+    int dep_max;
+    int dep_dropped;             // Accesses that did not fit in the log
 #endif /* H5_HAVE_PARALLEL */
     int ref_cnt;
-
-    /* Currently open objects */
-    int opened_datasets_cnt;
-    dataset_prov_info_t *opened_datasets;
-    int opened_grps_cnt;
-    group_prov_info_t *opened_grps;
-    int opened_dtypes_cnt;
-    datatype_prov_info_t *opened_dtypes;
-    int opened_attrs_cnt;
-    attribute_prov_info_t *opened_attrs;
+    unsigned int name_gen;       // Bumped by link moves/deletes and attribute renames
+    hbool_t writable;            // Created, or opened with H5F_ACC_RDWR
+    prov_embed_t embed;          // Records not yet written into the file
+    char *meta_path;             // Provenance file path, not yet written to the Provenance group
+    char meta_created[64];       // Creation time to write with it, empty for opened files
+
+    /* Currently open objects, see obj_table_find() */
+    prov_hash_t opened_datasets;
+    prov_hash_t opened_grps;
+    prov_hash_t opened_dtypes;
+    prov_hash_t opened_attrs;
 
     /* Statistics */
     int ds_created;
@@ -141,17 +246,20 @@ struct H5VL_prov_file_info_t {//assigned when a file is closed, serves to store
     int grp_accessed;
     int dtypes_created;
     int dtypes_accessed;
-
-    file_prov_info_t *next;
 };
 
 // Common provenance information, for all objects
 typedef struct H5VL_prov_object_info_t {
+    prov_hash_node_t hash_node;         // In the file's table of open objects
+                                        // of the class, must be first field
     prov_helper_t *prov_helper;         //pointer shared among all layers, one per process.
     file_prov_info_t *file_info;        // Pointer to file info for object's file
     H5O_token_t token;                  // Unique ID within file for object
     char *name;                         // Name of object within file
                                         // (possibly NULL and / or non-unique)
+    char *path;                         // Path (attribute name for attributes)
+                                        // recorded for I/O, see obj_prov_name()
+    unsigned int path_gen;              // file_info->name_gen path was resolved at
     int ref_cnt;                        // # of references to this prov info
 } object_prov_info_t;
 
@@ -181,10 +289,14 @@ struct H5VL_prov_dataset_info_t {
     int coll_dataset_write_cnt;
     int broken_coll_dataset_read_cnt;
     int broken_coll_dataset_write_cnt;
+    // Entry/exit of each collective transfer on the global clock (us),
+    // reduced across ranks when the dataset is closed
+    int coll_ops_cnt;
+    int coll_ops_max;
+    double *coll_entry_times;
+    double *coll_exit_times;
 #endif /* H5_HAVE_PARALLEL */
     int access_cnt;
-
-    dataset_prov_info_t *next;
 };
 
 struct H5VL_prov_group_info_t {
@@ -193,10 +305,9 @@ struct H5VL_prov_group_info_t {
                                         // generic upcasts to work
 
     int func_cnt;//stats
+    int access_cnt;                     // Opens and creates, for the summary
 //    int group_get_cnt;
 //    int group_specific_cnt;
-
-    group_prov_info_t *next;
 };
 
 typedef struct H5VL_prov_link_info_t {
@@ -212,8 +323,6 @@ struct H5VL_prov_datatype_info_t {
     hid_t dtype_id;
     int datatype_commit_cnt;
     int datatype_get_cnt;
-
-    datatype_prov_info_t *next;
 };
 
 struct H5VL_prov_attribute_info_t {
@@ -222,18 +331,10 @@ struct H5VL_prov_attribute_info_t {
                                         // generic upcasts to work
 
     int func_cnt;//stats
-
-    attribute_prov_info_t *next;
 };
 
-unsigned long TOTAL_PROV_OVERHEAD;
-unsigned long TOTAL_NATIVE_H5_TIME;
-unsigned long PROV_WRITE_TOTAL_TIME;
-unsigned long FILE_LL_TOTAL_TIME;       //record file linked list overhead
-unsigned long DS_LL_TOTAL_TIME;         //dataset
-unsigned long GRP_LL_TOTAL_TIME;        //group
-unsigned long DT_LL_TOTAL_TIME;         //datatype
-unsigned long ATTR_LL_TOTAL_TIME;       //attribute
+/* Connector counters of the calling thread, summed over threads at teardown */
+#define vol_stat (stat_local_block()->connector)
 static prov_helper_t* PROV_HELPER = NULL;
 
 
@@ -242,6 +343,48 @@ prov_fields fields;
 provio_helper_t* provio_helper;
 prov_config config;
 
+#define PROV_CB_NAME(name) "H5VL_provenance_" #name,
+static const char* const prov_cb_names[PROV_CB_COUNT] = {
+    PROV_VOL_CALLBACKS(PROV_CB_NAME)
+};
+#undef PROV_CB_NAME
+
+/* Per-callback switch, set once from the config by prov_cb_enable_init().
+ * A callback whose class is disabled skips all provenance work, read and
+ * write skip timing as well and only forward to the under connector.
+ * Dataset read and write may be on for their counters alone, they add a
+ * record only with ENABLE_DATASET. */
+static unsigned char prov_cb_enabled[PROV_CB_COUNT];
+#define PROV_CB_ENABLED(name) (prov_cb_enabled[PROV_CB_##name])
+/* Attributes and datasets of a disabled class are wrapped bare, without
+ * prov info. Datasets keep it while dependency detection or summaries
+ * have read and write on. */
+#define PROV_ATTR_BARE() (!prov_cb_enabled[PROV_CB_attr_open])
+#define PROV_DATASET_BARE() \
+    (!prov_cb_enabled[PROV_CB_dataset_open] && !prov_cb_enabled[PROV_CB_dataset_read])
+
+static void prov_cb_enable_init(const prov_config* conf) {
+    for (int i = 0; i < PROV_CB_COUNT; i++) {
+        const char* cb = prov_cb_names[i] + strlen("H5VL_provenance_");
+        unsigned char on = 1;
+
+        if (!strncmp(cb, "attr_", 5))
+            on = conf->enable_attr_prov;
+        else if (!strncmp(cb, "dataset_", 8))
+            on = conf->enable_dataset_prov;
+        else if (!strncmp(cb, "datatype_", 9))
+            on = conf->enable_dtype_prov;
+        else if (!strncmp(cb, "file_", 5))
+            on = conf->enable_file_prov;
+        else if (!strncmp(cb, "group_", 6))
+            on = conf->enable_group_prov;
+        prov_cb_enabled[i] = on ? 1 : 0;
+    }
+    // Dependency detection and summaries need every dataset read and write
+    if (conf->enable_dep_detect || conf->enable_summaries)
+        prov_cb_enabled[PROV_CB_dataset_read] = prov_cb_enabled[PROV_CB_dataset_write] = 1;
+}
+
 static ssize_t object_get_name(void *under_obj, hid_t under_vol_id, 
     const H5VL_loc_params_t *loc_params, hid_t dxpl_id, size_t buf_size, void *buf) {
     struct H5VL_object_get_args_t vol_cb_args; /* Set up VOL callback arguments */
@@ -251,12 +394,50 @@ static ssize_t object_get_name(void *under_obj, hid_t under_vol_id,
     vol_cb_args.args.get_name.buf      = buf;
     vol_cb_args.args.get_name.name_len = &obj_name_len;
     /* Retrieve object's name */
+    STAT_PHASE_BEGIN(STAT_PHASE_NAME);
     if (H5VLobject_get(under_obj, loc_params, under_vol_id, &vol_cb_args, 
-        H5P_DATASET_XFER_DEFAULT, NULL) < 0)
+        H5P_DATASET_XFER_DEFAULT, NULL) < 0) {
+        STAT_PHASE_END();
         return -1;
+    }
+    STAT_PHASE_END();
 
     return (ssize_t) obj_name_len;
 }
+
+/* File info of the file an object belongs to, NULL if it is not known */
+static file_prov_info_t* obj_file_info(const H5VL_provenance_t *obj) {
+    if(!obj)
+        return NULL;
+    if(!obj->generic_prov_info)
+        return obj->bare_file;
+    switch(obj->my_type) {
+        case H5I_FILE:
+            return (file_prov_info_t *)obj->generic_prov_info;
+        case H5I_DATASET:
+        case H5I_GROUP:
+        case H5I_DATATYPE:
+        case H5I_ATTR:
+            return ((object_prov_info_t *)obj->generic_prov_info)->file_info;
+        default:
+            return NULL;
+    }
+}
+
+/* Name of the file an object belongs to, NULL if it is not known */
+static const char* obj_file_name(const H5VL_provenance_t *obj) {
+    const file_prov_info_t *file_info = obj_file_info(obj);
+
+    return file_info ? file_info->file_name : NULL;
+}
+
+/* Cached object paths are resolved again after a change to the file's links */
+static void obj_names_changed(const H5VL_provenance_t *obj) {
+    file_prov_info_t *file_info = obj_file_info(obj);
+
+    if(file_info)
+        file_info->name_gen++;
+}
 /* PROV-IO instrument end */
 
 //======================================= statistics =======================================
@@ -301,9 +482,15 @@ static void *H5VL_provenance_dataset_create(void *obj, const H5VL_loc_params_t *
     const char *ds_name, hid_t lcpl_id, hid_t type_id, hid_t space_id,
     hid_t dcpl_id, hid_t dapl_id, hid_t dxpl_id, void **req);
 static void *H5VL_provenance_dataset_open(void *obj, const H5VL_loc_params_t *loc_params, const char *ds_name, hid_t dapl_id, hid_t dxpl_id, void **req);
+#if H5VL_VERSION >= 3
+static herr_t H5VL_provenance_dataset_read(size_t count, void *dset[], hid_t mem_type_id[], hid_t mem_space_id[],
+                                    hid_t file_space_id[], hid_t plist_id, void *buf[], void **req);
+static herr_t H5VL_provenance_dataset_write(size_t count, void *dset[], hid_t mem_type_id[], hid_t mem_space_id[], hid_t file_space_id[], hid_t plist_id, const void *buf[], void **req);
+#else
 static herr_t H5VL_provenance_dataset_read(void *dset, hid_t mem_type_id, hid_t mem_space_id,
                                     hid_t file_space_id, hid_t plist_id, void *buf, void **req);
 static herr_t H5VL_provenance_dataset_write(void *dset, hid_t mem_type_id, hid_t mem_space_id, hid_t file_space_id, hid_t plist_id, const void *buf, void **req);
+#endif
 static herr_t H5VL_provenance_dataset_get(void *dset, H5VL_dataset_get_args_t *args, hid_t dxpl_id, void **req);
 static herr_t H5VL_provenance_dataset_specific(void *obj, H5VL_dataset_specific_args_t *args, hid_t dxpl_id, void **req);
 static herr_t H5VL_provenance_dataset_optional(void *obj, H5VL_optional_args_t *args, hid_t dxpl_id, void **req);
@@ -491,6 +678,13 @@ static const H5VL_class_t H5VL_provenance_cls = {
     H5VL_provenance_optional                    /* optional */
 };
 
+/* PROV_VOL_CALLBACKS has to name every callback of the class. From
+ * initialize on the class holds only pointer-sized members: the callbacks,
+ * the info size and get_conn_cls, which is not implemented. */
+_Static_assert(sizeof(H5VL_class_t) - offsetof(H5VL_class_t, initialize)
+        == (PROV_CB_COUNT + 2) * sizeof(void *),
+    "PROV_VOL_CALLBACKS and H5VL_provenance_cls list different callbacks");
+
 H5PL_type_t H5PLget_plugin_type(void) {return H5PL_TYPE_VOL;}
 const void *H5PLget_plugin_info(void) {return &H5VL_provenance_cls;}
 
@@ -503,6 +697,7 @@ static hid_t dataset_get_space(void *under_dset, hid_t under_vol_id, hid_t dxpl_
 static hid_t dataset_get_dcpl(void *under_dset, hid_t under_vol_id, hid_t dxpl_id);
 static ssize_t attr_get_name(void *under_obj, hid_t under_vol_id, hid_t dxpl_id,
     size_t buf_size, void *buf);
+static const char *obj_prov_name(H5VL_provenance_t *obj);
 datatype_prov_info_t *new_dtype_info(file_prov_info_t* root_file,
     const char *name, H5O_token_t token);
 dataset_prov_info_t *new_dataset_info(file_prov_info_t *root_file,
@@ -514,6 +709,7 @@ attribute_prov_info_t *new_attribute_info(file_prov_info_t *root_file,
 file_prov_info_t *new_file_info(const char* fname, unsigned long file_no);
 void dtype_info_free(datatype_prov_info_t* info);
 void file_info_free(file_prov_info_t* info);
+static void embed_log_free(file_prov_info_t* info);
 void group_info_free(group_prov_info_t* info);
 void dataset_info_free(dataset_prov_info_t* info);
 void attribute_info_free(attribute_prov_info_t *info);
@@ -525,6 +721,8 @@ void attribute_stats_prov_write(const attribute_prov_info_t *attr_info);
 void prov_helper_teardown(prov_helper_t* helper);
 void file_ds_created(file_prov_info_t* info);
 void file_ds_accessed(file_prov_info_t* info);
+void file_grp_created(file_prov_info_t* info);
+void file_dtype_created(file_prov_info_t* info);
 datatype_prov_info_t *add_dtype_node(file_prov_info_t *file_info,
     H5VL_provenance_t *dtype, const char *obj_name, H5O_token_t token);
 int rm_dtype_node(prov_helper_t *helper, void *under, hid_t under_vol_id, datatype_prov_info_t *dtype_info);
@@ -555,11 +753,272 @@ void _fake_obj_free(H5VL_provenance_t* obj);
 H5VL_provenance_t* _obj_wrap_under(void* under, H5VL_provenance_t* upper_o,
         const char *name, H5I_type_t type, hid_t dxpl_id, void** req);
 H5VL_provenance_t* _file_open_common(void* under, hid_t vol_id, const char* name);
-unsigned int genHash(const char *msg);
-void _dic_init(void);
-void _dic_print(void);
-void _dic_free(void);
-void _preset_dic_print(void);
+
+#define PROV_HASH_MIN_BUCKETS 16
+
+/* splitmix64 finalizer, file numbers and FNV-1a hashes of short strings
+ * differ mostly in bits the bucket index does not use */
+static unsigned long prov_hash_mix(unsigned long key)
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9UL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebUL;
+    key ^= key >> 31;
+    return key;
+}
+
+/* Key of an open object: FNV-1a over the token bytes and, for attributes,
+ * the name. Equal tokens get equal keys as long as the bytes the connector
+ * does not use are zero, see _obj_wrap_under(). */
+static unsigned long obj_token_key(const H5O_token_t *token, const char *name)
+{
+    const unsigned char *p = (const unsigned char *)token;
+    unsigned long hash = 14695981039346656037UL;
+    size_t i;
+
+    for(i = 0; i < sizeof(H5O_token_t); i++) {
+        hash ^= p[i];
+        hash *= 1099511628211UL;
+    }
+    if(name) {
+        hash ^= 0xff;   // separator, no name byte has this value in UTF-8
+        hash *= 1099511628211UL;
+        for(p = (const unsigned char *)name; *p; p++) {
+            hash ^= *p;
+            hash *= 1099511628211UL;
+        }
+    }
+    return prov_hash_mix(hash);
+}
+
+/* Doubles the bucket array, the table keeps at most one node per bucket
+ * on average */
+static int prov_hash_grow(prov_hash_t *table)
+{
+    unsigned long nbuckets = table->nbuckets ? 2 * table->nbuckets : PROV_HASH_MIN_BUCKETS;
+    prov_hash_node_t **buckets;
+    unsigned long i;
+
+    buckets = (prov_hash_node_t **)calloc(nbuckets, sizeof(prov_hash_node_t *));
+    if(!buckets)
+        return -1;
+
+    for(i = 0; i < table->nbuckets; i++) {
+        prov_hash_node_t *node = table->buckets[i];
+
+        while(node) {
+            prov_hash_node_t *next = node->next;
+            prov_hash_node_t **bucket = &buckets[node->key & (nbuckets - 1)];
+
+            node->next = *bucket;
+            *bucket = node;
+            node = next;
+        }
+    }
+
+    free(table->buckets);
+    table->buckets = buckets;
+    table->nbuckets = nbuckets;
+    return 0;
+}
+
+static int prov_hash_insert(prov_hash_t *table, prov_hash_node_t *node, unsigned long key)
+{
+    prov_hash_node_t **bucket;
+
+    // Chains just get longer if a full table cannot grow
+    if((unsigned long)table->cnt >= table->nbuckets)
+        if(prov_hash_grow(table) < 0 && !table->nbuckets)
+            return -1;
+
+    node->key = key;
+    bucket = &table->buckets[key & (table->nbuckets - 1)];
+    node->next = *bucket;
+    *bucket = node;
+    table->cnt++;
+    return 0;
+}
+
+/* First node with the key, prov_hash_next() walks the others */
+static prov_hash_node_t *prov_hash_find(const prov_hash_t *table, unsigned long key)
+{
+    prov_hash_node_t *node;
+
+    if(!table->nbuckets)
+        return NULL;
+
+    node = table->buckets[key & (table->nbuckets - 1)];
+    while(node && node->key != key)
+        node = node->next;
+    return node;
+}
+
+static prov_hash_node_t *prov_hash_next(const prov_hash_node_t *node)
+{
+    prov_hash_node_t *cur = node->next;
+
+    while(cur && cur->key != node->key)
+        cur = cur->next;
+    return cur;
+}
+
+static int prov_hash_remove(prov_hash_t *table, prov_hash_node_t *node)
+{
+    prov_hash_node_t **link;
+
+    if(!table->nbuckets)
+        return -1;
+
+    link = &table->buckets[node->key & (table->nbuckets - 1)];
+    while(*link && *link != node)
+        link = &(*link)->next;
+    if(!*link)
+        return -1;
+
+    *link = node->next;
+    node->next = NULL;
+    table->cnt--;
+    return 0;
+}
+
+// Frees the buckets only, nodes belong to their prov info
+static void prov_hash_free(prov_hash_t *table)
+{
+    free(table->buckets);
+    table->buckets = NULL;
+    table->nbuckets = 0;
+    table->cnt = 0;
+}
+
+/* Freelist pools for the structs the connector allocates per wrapped object,
+ * request, wrap context and open object. Every thread keeps its own lists,
+ * so pools need no locks; an object freed by another thread than the one
+ * that allocated it just moves to that thread's list. A list keeps at most
+ * PROV_POOL_CACHE objects, more are passed on to free(), and a thread's
+ * lists are released when it exits. */
+#define PROV_POOL_CACHE 256
+
+typedef enum prov_pool_id {
+    PROV_POOL_OBJ,          // H5VL_provenance_t
+    PROV_POOL_WRAP_CTX,     // H5VL_provenance_wrap_ctx_t
+    PROV_POOL_FILE,
+    PROV_POOL_DATASET,
+    PROV_POOL_GROUP,
+    PROV_POOL_DATATYPE,
+    PROV_POOL_ATTR,
+    PROV_POOL_COUNT
+} prov_pool_id;
+
+static const char* const prov_pool_names[PROV_POOL_COUNT] = {
+    "object", "wrap_ctx", "file_info", "dataset_info",
+    "group_info", "datatype_info", "attribute_info"
+};
+
+static const size_t prov_pool_sizes[PROV_POOL_COUNT] = {
+    sizeof(H5VL_provenance_t), sizeof(H5VL_provenance_wrap_ctx_t),
+    sizeof(file_prov_info_t), sizeof(dataset_prov_info_t),
+    sizeof(group_prov_info_t), sizeof(datatype_prov_info_t),
+    sizeof(attribute_prov_info_t)
+};
+
+typedef struct prov_pool_t {
+    void *head;             // Free objects, linked through their first bytes
+    int cnt;
+} prov_pool_t;
+
+static __thread prov_pool_t prov_pools[PROV_POOL_COUNT];
+/* The key is deleted at term since HDF5 may unload the plugin and its
+ * destructor with it. Threads register again under the next key. */
+static __thread int prov_pools_registered = 0;   // prov_pool_key_gen registered under
+static int prov_pool_key_gen = 1;
+static int prov_pool_key_valid = 0;
+static pthread_key_t prov_pool_key;
+static pthread_once_t prov_pool_once = PTHREAD_ONCE_INIT;
+static const pthread_once_t prov_pool_once_init = PTHREAD_ONCE_INIT;
+
+static void prov_pool_drain(void *pools)
+{
+    prov_pool_t *pool = (prov_pool_t *)pools;
+    int i;
+
+    for(i = 0; i < PROV_POOL_COUNT; i++) {
+        while(pool[i].head) {
+            void *next = *(void **)pool[i].head;
+
+            free(pool[i].head);
+            pool[i].head = next;
+        }
+        pool[i].cnt = 0;
+    }
+}
+
+static void prov_pool_key_create(void)
+{
+    if(pthread_key_create(&prov_pool_key, prov_pool_drain) != 0)
+        fprintf(stderr, "%s: pthread_key_create failed, pooled objects of exiting threads are leaked\n", __func__);
+    else
+        prov_pool_key_valid = 1;
+}
+
+/* Drain this thread's lists and drop the key: no destructor may run once
+ * the plugin is unloaded. Lists of other live threads are leaked. */
+static void prov_pool_key_delete(void)
+{
+    prov_pool_drain(prov_pools);
+    if(prov_pool_key_valid) {
+        pthread_key_delete(prov_pool_key);
+        prov_pool_key_valid = 0;
+    }
+    prov_pool_once = prov_pool_once_init;
+    prov_pool_key_gen++;
+}
+
+// Zeroed object, like calloc()
+static void *prov_pool_alloc(prov_pool_id id)
+{
+    prov_pool_t *pool = &prov_pools[id];
+    stat_pool_counts *counts = stat_pool_local(id);
+    void *item;
+
+    counts->allocs++;
+    if(NULL == (item = pool->head))
+        return calloc(1, prov_pool_sizes[id]);
+
+    pool->head = *(void **)item;
+    pool->cnt--;
+    counts->reused++;
+    memset(item, 0, prov_pool_sizes[id]);
+    return item;
+}
+
+static void prov_pool_free(prov_pool_id id, void *item)
+{
+    prov_pool_t *pool = &prov_pools[id];
+    stat_pool_counts *counts = stat_pool_local(id);
+
+    if(!item)
+        return;
+
+    counts->frees++;
+    if(pool->cnt >= PROV_POOL_CACHE) {
+        counts->released++;
+        free(item);
+        return;
+    }
+
+    // Have this thread's lists drained when it exits
+    if(prov_pools_registered != prov_pool_key_gen) {
+        pthread_once(&prov_pool_once, prov_pool_key_create);
+        if(prov_pool_key_valid)
+            pthread_setspecific(prov_pool_key, prov_pools);
+        prov_pools_registered = prov_pool_key_gen;
+    }
+
+    *(void **)item = pool->head;
+    pool->head = item;
+    pool->cnt++;
+}
 
 // static
 // unsigned long get_time_usec(void) {
@@ -574,7 +1033,7 @@ datatype_prov_info_t *new_dtype_info(file_prov_info_t* root_file,
 {
     datatype_prov_info_t *info;
 
-    info = (datatype_prov_info_t *)calloc(1, sizeof(datatype_prov_info_t));
+    info = (datatype_prov_info_t *)prov_pool_alloc(PROV_POOL_DATATYPE);
     info->obj_info.prov_helper = PROV_HELPER;
     info->obj_info.file_info = root_file;
     info->obj_info.name = name ? strdup(name) : NULL;
@@ -588,7 +1047,7 @@ dataset_prov_info_t *new_dataset_info(file_prov_info_t *root_file,
 {
     dataset_prov_info_t *info;
 
-    info = (dataset_prov_info_t *)calloc(1, sizeof(dataset_prov_info_t));
+    info = (dataset_prov_info_t *)prov_pool_alloc(PROV_POOL_DATASET);
     info->obj_info.prov_helper = PROV_HELPER;
     info->obj_info.file_info = root_file;
     info->obj_info.name = name ? strdup(name) : NULL;
@@ -602,7 +1061,7 @@ group_prov_info_t *new_group_info(file_prov_info_t *root_file,
 {
     group_prov_info_t *info;
 
-    info = (group_prov_info_t *)calloc(1, sizeof(group_prov_info_t));
+    info = (group_prov_info_t *)prov_pool_alloc(PROV_POOL_GROUP);
     info->obj_info.prov_helper = PROV_HELPER;
     info->obj_info.file_info = root_file;
     info->obj_info.name = name ? strdup(name) : NULL;
@@ -616,7 +1075,7 @@ attribute_prov_info_t *new_attribute_info(file_prov_info_t *root_file,
 {
     attribute_prov_info_t *info;
 
-    info = (attribute_prov_info_t *)calloc(1, sizeof(attribute_prov_info_t));
+    info = (attribute_prov_info_t *)prov_pool_alloc(PROV_POOL_ATTR);
     info->obj_info.prov_helper = PROV_HELPER;
     info->obj_info.file_info = root_file;
     info->obj_info.name = name ? strdup(name) : NULL;
@@ -629,7 +1088,7 @@ file_prov_info_t* new_file_info(const char* fname, unsigned long file_no)
 {
     file_prov_info_t *info;
 
-    info = (file_prov_info_t *)calloc(1, sizeof(file_prov_info_t));
+    info = (file_prov_info_t *)prov_pool_alloc(PROV_POOL_FILE);
     info->file_name = fname ? strdup(fname) : NULL;
     info->prov_helper = PROV_HELPER;
     info->file_no = file_no;
@@ -641,67 +1100,1103 @@ void dtype_info_free(datatype_prov_info_t* info)
 {
     if(info->obj_info.name)
         free(info->obj_info.name);
-    free(info);
+    free(info->obj_info.path);
+    prov_pool_free(PROV_POOL_DATATYPE, info);
 }
 
 void file_info_free(file_prov_info_t* info)
 {
 #ifdef H5_HAVE_PARALLEL
-    // Release MPI Comm & Info, if they are valid
-    if(info->mpi_comm_info_valid) {
-	if(MPI_COMM_NULL != info->mpi_comm)
-	    MPI_Comm_free(&info->mpi_comm);
-	if(MPI_INFO_NULL != info->mpi_info)
-	    MPI_Info_free(&info->mpi_info);
+    // Release MPI Comm & Info, if they are valid
+    if(info->mpi_comm_info_valid) {
+	if(MPI_COMM_NULL != info->mpi_comm)
+	    MPI_Comm_free(&info->mpi_comm);
+	if(MPI_INFO_NULL != info->mpi_info)
+	    MPI_Info_free(&info->mpi_info);
+    }
+    free(info->dep_log);
+#endif /* H5_HAVE_PARALLEL */
+    embed_log_free(info);
+    free(info->meta_path);
+    prov_hash_free(&info->opened_datasets);
+    prov_hash_free(&info->opened_grps);
+    prov_hash_free(&info->opened_dtypes);
+    prov_hash_free(&info->opened_attrs);
+    if(info->file_name)
+        free(info->file_name);
+    prov_pool_free(PROV_POOL_FILE, info);
+}
+
+void group_info_free(group_prov_info_t* info)
+{
+    if(info->obj_info.name)
+        free(info->obj_info.name);
+    free(info->obj_info.path);
+    prov_pool_free(PROV_POOL_GROUP, info);
+}
+
+void dataset_info_free(dataset_prov_info_t* info)
+{
+#ifdef H5_HAVE_PARALLEL
+    free(info->coll_entry_times);
+    free(info->coll_exit_times);
+#endif /* H5_HAVE_PARALLEL */
+    if(info->obj_info.name)
+        free(info->obj_info.name);
+    free(info->obj_info.path);
+    prov_pool_free(PROV_POOL_DATASET, info);
+}
+
+void attribute_info_free(attribute_prov_info_t* info)
+{
+    if(info->obj_info.name)
+        free(info->obj_info.name);
+    free(info->obj_info.path);
+    prov_pool_free(PROV_POOL_ATTR, info);
+}
+
+/* Set one counter of a summary record, returns 1 to advance the count */
+static int summary_set(prov_summary_item *item, const char *name, const char *fmt, ...)
+{
+    va_list args;
+
+    item->name = name;
+    va_start(args, fmt);
+    vsnprintf(item->value, sizeof(item->value), fmt, args);
+    va_end(args);
+    return 1;
+}
+
+/* Path of an object as last recorded, the name it was opened with otherwise */
+static const char *summary_obj_name(const object_prov_info_t *obj_info)
+{
+    if(obj_info->path)
+        return obj_info->path;
+    return obj_info->name ? obj_info->name : "";
+}
+
+static const char *dataset_layout_name(H5D_layout_t layout)
+{
+    switch(layout) {
+        case H5D_COMPACT:
+            return "compact";
+        case H5D_CONTIGUOUS:
+            return "contiguous";
+        case H5D_CHUNKED:
+            return "chunked";
+        case H5D_VIRTUAL:
+            return "virtual";
+        default:
+            return "unknown";
+    }
+}
+
+/* Summary of a dataset's transfers, written when its last open handle is
+ * closed (ENABLE_SUMMARIES) */
+void dataset_stats_prov_write(const dataset_prov_info_t* ds_info){
+    prov_summary_item items[16];
+    char dims[64];
+    int len = 0;
+    int n = 0;
+
+    if(!ds_info || !config.enable_summaries)
+        return;
+    // Other handles of the dataset share the counters
+    if(ds_info->obj_info.ref_cnt > 1)
+        return;
+
+    dims[0] = '\0';
+    for(unsigned int i = 0; i < ds_info->dimension_cnt && len < (int)sizeof(dims); i++)
+        len += snprintf(dims + len, sizeof(dims) - len, "%s%llu", i ? "x" : "",
+            (unsigned long long)ds_info->dimensions[i]);
+
+    n += summary_set(&items[n], "layout", "%s", dataset_layout_name(ds_info->layout));
+    n += summary_set(&items[n], "dimensions", "%s", ds_info->dimension_cnt ? dims : "scalar");
+    n += summary_set(&items[n], "typeSize", "%zu", ds_info->dset_type_size);
+    n += summary_set(&items[n], "opens", "%d", ds_info->access_cnt);
+    n += summary_set(&items[n], "reads", "%d", ds_info->dataset_read_cnt);
+    n += summary_set(&items[n], "bytesRead", "%llu", (unsigned long long)ds_info->total_bytes_read);
+    n += summary_set(&items[n], "readTime", "%llu", (unsigned long long)ds_info->total_read_time);
+    n += summary_set(&items[n], "writes", "%d", ds_info->dataset_write_cnt);
+    n += summary_set(&items[n], "bytesWritten", "%llu", (unsigned long long)ds_info->total_bytes_written);
+    n += summary_set(&items[n], "writeTime", "%llu", (unsigned long long)ds_info->total_write_time);
+#ifdef H5_HAVE_PARALLEL
+    n += summary_set(&items[n], "independentReads", "%d", ds_info->ind_dataset_read_cnt);
+    n += summary_set(&items[n], "collectiveReads", "%d", ds_info->coll_dataset_read_cnt);
+    n += summary_set(&items[n], "brokenCollectiveReads", "%d", ds_info->broken_coll_dataset_read_cnt);
+    n += summary_set(&items[n], "independentWrites", "%d", ds_info->ind_dataset_write_cnt);
+    n += summary_set(&items[n], "collectiveWrites", "%d", ds_info->coll_dataset_write_cnt);
+    n += summary_set(&items[n], "brokenCollectiveWrites", "%d", ds_info->broken_coll_dataset_write_cnt);
+#endif /* H5_HAVE_PARALLEL */
+
+    add_summary_record(&config, provio_helper, &fields, summary_obj_name(&ds_info->obj_info),
+        "provio:Dataset", ds_info->obj_info.file_info ? ds_info->obj_info.file_info->file_name : "",
+        items, n);
+}
+
+#ifdef H5_HAVE_PARALLEL
+/* Remember when this rank entered and left a collective transfer */
+static void dataset_coll_op_record(dataset_prov_info_t* dset_info, unsigned long entry, unsigned long exit)
+{
+    if(dset_info->coll_ops_cnt == dset_info->coll_ops_max) {
+        int new_max;
+        double *new_entry, *new_exit;
+
+        if(dset_info->coll_ops_max >= COLL_SKEW_MAX_OPS)
+            return;
+        new_max = dset_info->coll_ops_max ? 2 * dset_info->coll_ops_max : 16;
+        if(new_max > COLL_SKEW_MAX_OPS)
+            new_max = COLL_SKEW_MAX_OPS;
+        new_entry = realloc(dset_info->coll_entry_times, new_max * sizeof(double));
+        if(!new_entry)
+            return;
+        dset_info->coll_entry_times = new_entry;
+        new_exit = realloc(dset_info->coll_exit_times, new_max * sizeof(double));
+        if(!new_exit)
+            return;
+        dset_info->coll_exit_times = new_exit;
+        dset_info->coll_ops_max = new_max;
+    }
+
+    dset_info->coll_entry_times[dset_info->coll_ops_cnt] = (double)provio_global_time(&fields, entry);
+    dset_info->coll_exit_times[dset_info->coll_ops_cnt] = (double)provio_global_time(&fields, exit);
+    dset_info->coll_ops_cnt++;
+}
+
+/* Reduce collective transfer times of a dataset across the ranks of its file.
+ * Called by every rank of the file's MPI-IO communicator when the last
+ * handle of the dataset is closed, H5Dclose is collective in parallel HDF5.
+ * Skew is the gap between the first and the last rank entering a transfer,
+ * wasted time is what the other ranks spent waiting for the last one. */
+static void dataset_coll_skew_reduce(dataset_prov_info_t* dset_info)
+{
+    file_prov_info_t* file_info = dset_info->obj_info.file_info;
+    MPI_Comm comm;
+    int mpi_initialized = 0, mpi_finalized = 0;
+    int rank, nprocs, ops, ok, i;
+    struct { double time; int rank; } *last = NULL;
+    double *first = NULL, *wait = NULL, *wait_sum = NULL;
+    int *slowest_cnt = NULL;
+
+    MPI_Initialized(&mpi_initialized);
+    MPI_Finalized(&mpi_finalized);
+    if(!mpi_initialized || mpi_finalized)
+        goto done;
+    // Only the ranks that opened the file with MPI-IO take part
+    if(!file_info || !file_info->mpi_comm_info_valid || MPI_COMM_NULL == file_info->mpi_comm)
+        goto done;
+    comm = file_info->mpi_comm;
+    MPI_Comm_size(comm, &nprocs);
+    if(nprocs < 2)
+        goto done;
+    MPI_Comm_rank(comm, &rank);
+
+    // Only transfers every rank has timed can be matched up
+    MPI_Allreduce(&dset_info->coll_ops_cnt, &ops, 1, MPI_INT, MPI_MIN, comm);
+    if(ops == 0)
+        goto done;
+
+    last = malloc(ops * sizeof(*last));
+    first = malloc(ops * sizeof(double));
+    wait = malloc(ops * sizeof(double));
+    wait_sum = malloc(ops * sizeof(double));
+    slowest_cnt = calloc(nprocs, sizeof(int));
+    // Every rank has to agree before entering the next collectives
+    ok = last && first && wait && wait_sum && slowest_cnt;
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, comm);
+    if(!ok)
+        goto done;
+
+    for(i = 0; i < ops; i++) {
+        last[i].time = dset_info->coll_entry_times[i];
+        last[i].rank = rank;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, last, ops, MPI_DOUBLE_INT, MPI_MAXLOC, comm);
+
+    // Time spent in the transfer before the last rank showed up
+    for(i = 0; i < ops; i++) {
+        double entry = dset_info->coll_entry_times[i];
+        double w = last[i].time - entry;
+
+        if(w > dset_info->coll_exit_times[i] - entry)
+            w = dset_info->coll_exit_times[i] - entry;
+        wait[i] = w > 0 ? w : 0;
+    }
+    MPI_Reduce(wait, wait_sum, ops, MPI_DOUBLE, MPI_SUM, 0, comm);
+    MPI_Reduce(dset_info->coll_entry_times, first, ops, MPI_DOUBLE, MPI_MIN, 0, comm);
+
+    if(rank == 0) {
+        unsigned long total_skew = 0, max_skew = 0;
+        double wasted = 0;
+        int slowest_rank = 0;
+
+        for(i = 0; i < ops; i++) {
+            unsigned long skew = last[i].time > first[i] ? (unsigned long)(last[i].time - first[i]) : 0;
+
+            total_skew += skew;
+            if(skew > max_skew)
+                max_skew = skew;
+            wasted += wait_sum[i];
+            slowest_cnt[last[i].rank]++;
+        }
+        for(i = 1; i < nprocs; i++)
+            if(slowest_cnt[i] > slowest_cnt[slowest_rank])
+                slowest_rank = i;
+
+        stat_add_coll_skew(dset_info->obj_info.name, ops, total_skew, max_skew,
+                slowest_rank, wasted / 1000000.0);
+    }
+
+done:
+    free(last);
+    free(first);
+    free(wait);
+    free(wait_sum);
+    free(slowest_cnt);
+    dset_info->coll_ops_cnt = 0;
+}
+
+/* Log a dataset access for cross-rank dependency detection. Consecutive
+ * accesses that extend the previous box along one dimension are merged,
+ * when the log is full the access is folded into the latest summary of the
+ * same dataset and operation, which may over-report but never misses. */
+static void dataset_dep_record(dataset_prov_info_t* dset_info, hid_t file_space_id,
+    dep_op_t op, unsigned long entry, unsigned long exit)
+{
+    file_prov_info_t* file_info = dset_info->obj_info.file_info;
+    hsize_t start[H5S_MAX_RANK], end[H5S_MAX_RANK];
+    hsize_t gran = (hsize_t)config.dep_granularity;
+    dep_access_t acc, *prev;
+    int i;
+
+    if(!file_info)
+        return;
+
+    memset(&acc, 0, sizeof(acc));
+    acc.token = dset_info->obj_info.token;
+    snprintf(acc.name, sizeof(acc.name), "%s",
+        dset_info->obj_info.name ? dset_info->obj_info.name : "(anonymous)");
+    acc.op = op;
+    acc.start = provio_global_time(&fields, entry);
+    acc.end = provio_global_time(&fields, exit);
+    acc.ndims = dset_info->dimension_cnt < DEP_MAX_RANK ? (int)dset_info->dimension_cnt : DEP_MAX_RANK;
+
+    if(H5S_ALL == file_space_id) {
+        for(i = 0; i < acc.ndims; i++) {
+            start[i] = 0;
+            end[i] = dset_info->dimensions[i] ? dset_info->dimensions[i] - 1 : 0;
+        }
+    } else if(acc.ndims > 0) {
+        if(H5Sget_select_npoints(file_space_id) <= 0)
+            return;
+        if(H5Sget_select_bounds(file_space_id, start, end) < 0)
+            return;
+    }
+    for(i = 0; i < acc.ndims; i++) {
+        acc.lo[i] = start[i] / gran;
+        acc.hi[i] = end[i] / gran;
+    }
+
+    // Extend the previous summary if the union is still a box
+    prev = file_info->dep_cnt ? &file_info->dep_log[file_info->dep_cnt - 1] : NULL;
+    if(prev && prev->op == acc.op && prev->ndims == acc.ndims
+            && !memcmp(&prev->token, &acc.token, sizeof(H5O_token_t))) {
+        int differ = -1;
+
+        for(i = 0; i < acc.ndims; i++) {
+            if(prev->lo[i] == acc.lo[i] && prev->hi[i] == acc.hi[i])
+                continue;
+            if(differ >= 0 || acc.lo[i] > prev->hi[i] + 1 || prev->lo[i] > acc.hi[i] + 1) {
+                differ = -2;
+                break;
+            }
+            differ = i;
+        }
+        if(differ != -2) {
+            if(differ >= 0) {
+                prev->lo[differ] = prev->lo[differ] < acc.lo[differ] ? prev->lo[differ] : acc.lo[differ];
+                prev->hi[differ] = prev->hi[differ] > acc.hi[differ] ? prev->hi[differ] : acc.hi[differ];
+            }
+            prev->end = acc.end;
+            return;
+        }
+    }
+
+    if(file_info->dep_cnt == file_info->dep_max && file_info->dep_max < config.dep_max_accesses) {
+        int new_max = file_info->dep_max ? 2 * file_info->dep_max : 64;
+        dep_access_t* new_log;
+
+        if(new_max > config.dep_max_accesses)
+            new_max = config.dep_max_accesses;
+        new_log = realloc(file_info->dep_log, new_max * sizeof(dep_access_t));
+        if(new_log) {
+            file_info->dep_log = new_log;
+            file_info->dep_max = new_max;
+        }
+    }
+
+    if(file_info->dep_cnt < file_info->dep_max) {
+        file_info->dep_log[file_info->dep_cnt++] = acc;
+        return;
+    }
+
+    // Full: fold into the latest summary of this dataset and operation
+    for(i = file_info->dep_cnt - 1; i >= 0; i--) {
+        dep_access_t* cur = &file_info->dep_log[i];
+        int d;
+
+        if(cur->op != acc.op || cur->ndims != acc.ndims
+                || memcmp(&cur->token, &acc.token, sizeof(H5O_token_t)))
+            continue;
+        for(d = 0; d < acc.ndims; d++) {
+            cur->lo[d] = cur->lo[d] < acc.lo[d] ? cur->lo[d] : acc.lo[d];
+            cur->hi[d] = cur->hi[d] > acc.hi[d] ? cur->hi[d] : acc.hi[d];
+        }
+        cur->end = acc.end;
+        return;
+    }
+    file_info->dep_dropped++;
+}
+
+static unsigned dep_token_hash(const H5O_token_t* token)
+{
+    const unsigned char* p = (const unsigned char*)token;
+    unsigned hash = 2166136261u;
+    size_t i;
+
+    for(i = 0; i < sizeof(H5O_token_t); i++)
+        hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+static int dep_access_cmp(const void* a, const void* b)
+{
+    const dep_access_t* x = (const dep_access_t*)a;
+    const dep_access_t* y = (const dep_access_t*)b;
+    int c = memcmp(&x->token, &y->token, sizeof(H5O_token_t));
+
+    if(c)
+        return c;
+    if(x->ndims && x->lo[0] != y->lo[0])
+        return x->lo[0] < y->lo[0] ? -1 : 1;
+    return 0;
+}
+
+typedef struct dep_edge_t {
+    H5O_token_t token;              // Dataset, names may be truncated
+    const char* name;
+    const char* kind;
+    int from_rank;
+    int to_rank;
+    int count;
+} dep_edge_t;
+
+/* Classify two overlapping accesses from different ranks, ordered by start time */
+static void dep_add_edge(dep_edge_t* edges, int* edge_cnt, const dep_access_t* a, const dep_access_t* b)
+{
+    const dep_access_t *first = a, *second = b;
+    const char* kind;
+    int i;
+
+    if(a->op == DEP_READ && b->op == DEP_READ)
+        return;
+    if(b->start < a->start) {
+        first = b;
+        second = a;
+    }
+    if(first->op == DEP_WRITE)
+        kind = second->op == DEP_WRITE ? "WAW" : "RAW";
+    else
+        kind = "WAR";
+
+    for(i = 0; i < *edge_cnt; i++)
+        if(edges[i].from_rank == first->rank && edges[i].to_rank == second->rank
+                && edges[i].kind == kind && !memcmp(&edges[i].token, &first->token, sizeof(H5O_token_t))) {
+            edges[i].count++;
+            return;
+        }
+    if(*edge_cnt < DEP_MAX_EDGES) {
+        edges[*edge_cnt].token = first->token;
+        edges[*edge_cnt].name = first->name;
+        edges[*edge_cnt].kind = kind;
+        edges[*edge_cnt].from_rank = first->rank;
+        edges[*edge_cnt].to_rank = second->rank;
+        edges[*edge_cnt].count = 1;
+        (*edge_cnt)++;
+    }
+}
+
+/* Find conflicting accesses to the same dataset region from different ranks.
+ * Called by every rank of the file's MPI-IO communicator, H5Fclose is
+ * collective in parallel HDF5, files without one are skipped. Each dataset is owned by one rank (token
+ * hash), owners receive its summaries, sweep them sorted by the lower
+ * bound of the first dimension and record the dependency edges. */
+static void file_dep_detect(file_prov_info_t* file_info)
+{
+    MPI_Comm comm;
+    int mpi_initialized = 0, mpi_finalized = 0;
+    int rank, nprocs, i, j, recv_total = 0, edge_cnt = 0, ok;
+    int *send_cnt = NULL, *send_off = NULL, *recv_cnt = NULL, *recv_off = NULL, *fill = NULL;
+    dep_access_t *send_buf = NULL, *recv_buf = NULL;
+    int *active = NULL, active_cnt = 0;
+    dep_edge_t *edges = NULL;
+
+    MPI_Initialized(&mpi_initialized);
+    MPI_Finalized(&mpi_finalized);
+    if(!mpi_initialized || mpi_finalized)
+        goto done;
+    // Only the ranks that opened the file with MPI-IO take part
+    if(!file_info->mpi_comm_info_valid || MPI_COMM_NULL == file_info->mpi_comm)
+        goto done;
+    comm = file_info->mpi_comm;
+    MPI_Comm_size(comm, &nprocs);
+    if(nprocs < 2)
+        goto done;
+    MPI_Comm_rank(comm, &rank);
+
+    send_cnt = calloc(nprocs, sizeof(int));
+    send_off = calloc(nprocs, sizeof(int));
+    recv_cnt = calloc(nprocs, sizeof(int));
+    recv_off = calloc(nprocs, sizeof(int));
+    fill = calloc(nprocs, sizeof(int));
+    send_buf = malloc((file_info->dep_cnt ? file_info->dep_cnt : 1) * sizeof(dep_access_t));
+    // Every rank has to agree before entering the exchange
+    ok = send_cnt && send_off && recv_cnt && recv_off && fill && send_buf;
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, comm);
+    if(!ok)
+        goto done;
+
+    // Bucket summaries by owner, counts and offsets in bytes
+    for(i = 0; i < file_info->dep_cnt; i++)
+        send_cnt[dep_token_hash(&file_info->dep_log[i].token) % nprocs]++;
+    for(i = 1; i < nprocs; i++)
+        send_off[i] = send_off[i - 1] + send_cnt[i - 1];
+    for(i = 0; i < file_info->dep_cnt; i++) {
+        int owner = dep_token_hash(&file_info->dep_log[i].token) % nprocs;
+
+        send_buf[send_off[owner] + fill[owner]] = file_info->dep_log[i];
+        send_buf[send_off[owner] + fill[owner]].rank = rank;
+        fill[owner]++;
+    }
+    MPI_Alltoall(send_cnt, 1, MPI_INT, recv_cnt, 1, MPI_INT, comm);
+    for(i = 0; i < nprocs; i++) {
+        recv_total += recv_cnt[i];
+        send_cnt[i] *= (int)sizeof(dep_access_t);
+        send_off[i] *= (int)sizeof(dep_access_t);
+    }
+    for(i = 0; i < nprocs; i++) {
+        recv_off[i] = i ? recv_off[i - 1] + recv_cnt[i - 1] : 0;
+    }
+    for(i = 0; i < nprocs; i++) {
+        recv_cnt[i] *= (int)sizeof(dep_access_t);
+        recv_off[i] *= (int)sizeof(dep_access_t);
+    }
+
+    recv_buf = malloc((recv_total ? recv_total : 1) * sizeof(dep_access_t));
+    active = malloc((recv_total ? recv_total : 1) * sizeof(int));
+    edges = malloc(DEP_MAX_EDGES * sizeof(dep_edge_t));
+    ok = recv_buf && active && edges;
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, comm);
+    if(!ok)
+        goto done;
+    MPI_Alltoallv(send_buf, send_cnt, send_off, MPI_BYTE,
+        recv_buf, recv_cnt, recv_off, MPI_BYTE, comm);
+
+    // Sweep each dataset: keep accesses whose first-dimension interval is
+    // still open, compare the rest of the box only against those
+    qsort(recv_buf, recv_total, sizeof(dep_access_t), dep_access_cmp);
+    for(i = 0; i < recv_total; i++) {
+        dep_access_t* cur = &recv_buf[i];
+        int kept = 0;
+
+        for(j = 0; j < active_cnt; j++) {
+            dep_access_t* prev = &recv_buf[active[j]];
+            int d, overlap = 1;
+
+            if(memcmp(&prev->token, &cur->token, sizeof(H5O_token_t)))
+                continue;
+            if(prev->ndims && prev->hi[0] < cur->lo[0])
+                continue;
+            active[kept++] = active[j];
+
+            if(prev->rank == cur->rank)
+                continue;
+            for(d = 0; d < cur->ndims && d < prev->ndims; d++)
+                if(prev->hi[d] < cur->lo[d] || cur->hi[d] < prev->lo[d]) {
+                    overlap = 0;
+                    break;
+                }
+            if(overlap)
+                dep_add_edge(edges, &edge_cnt, prev, cur);
+        }
+        active_cnt = kept;
+        active[active_cnt++] = i;
+    }
+
+    for(i = 0; i < edge_cnt; i++)
+        add_dependency_record(&config, provio_helper, &fields, edges[i].name,
+            edges[i].kind, edges[i].from_rank, edges[i].to_rank, edges[i].count);
+    if(file_info->dep_dropped)
+        printf("file_dep_detect(): %s: %d accesses exceeded DEP_MAX_ACCESSES and were not checked.\n",
+            file_info->file_name, file_info->dep_dropped);
+
+done:
+    free(send_cnt);
+    free(send_off);
+    free(recv_cnt);
+    free(recv_off);
+    free(fill);
+    free(send_buf);
+    free(recv_buf);
+    free(active);
+    free(edges);
+    file_info->dep_cnt = 0;
+    file_info->dep_dropped = 0;
+}
+#endif /* H5_HAVE_PARALLEL */
+
+/* Offset of str in the file's strings, appended if it is new. Fails when the
+ * strings would pass what a record's 32-bit offsets can address. */
+static unsigned long embed_str_hash(const char *str)
+{
+    unsigned long hash = 14695981039346656037UL;
+
+    for(const unsigned char *p = (const unsigned char *)str; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211UL;
+    }
+    return prov_hash_mix(hash);
+}
+
+static int embed_intern(prov_embed_t *log, const char *str, uint32_t *off_out)
+{
+    size_t len = strlen(str) + 1;
+    size_t mask, i;
+
+    // Keep the table at most half full
+    if(2 * (log->str_cnt + 1) > log->nslots) {
+        size_t nslots = log->nslots ? 2 * log->nslots : 256;
+        uint32_t *slots = (uint32_t *)calloc(nslots, sizeof(uint32_t));
+
+        if(!slots)
+            return -1;
+        for(i = 0; i < log->nslots; i++) {
+            size_t j;
+
+            if(!log->slots[i])
+                continue;
+            j = embed_str_hash(log->strs + log->slots[i] - 1) & (nslots - 1);
+            while(slots[j])
+                j = (j + 1) & (nslots - 1);
+            slots[j] = log->slots[i];
+        }
+        free(log->slots);
+        log->slots = slots;
+        log->nslots = nslots;
+    }
+
+    mask = log->nslots - 1;
+    for(i = embed_str_hash(str) & mask; log->slots[i]; i = (i + 1) & mask) {
+        if(!strcmp(log->strs + log->slots[i] - 1, str)) {
+            *off_out = log->slots[i] - 1;
+            return 0;
+        }
+    }
+
+    if(log->strs_len + len >= UINT32_MAX)
+        return -1;
+    if(log->strs_len + len > log->strs_max) {
+        size_t strs_max = log->strs_max ? 2 * log->strs_max : 4096;
+        char *strs;
+
+        while(strs_max < log->strs_len + len)
+            strs_max *= 2;
+        if(!(strs = (char *)realloc(log->strs, strs_max)))
+            return -1;
+        log->strs = strs;
+        log->strs_max = strs_max;
+    }
+    memcpy(log->strs + log->strs_len, str, len);
+    log->slots[i] = (uint32_t)log->strs_len + 1;
+    *off_out = (uint32_t)log->strs_len;
+    log->strs_len += len;
+    log->str_cnt++;
+    return 0;
+}
+
+static file_prov_info_t *embed_last_file;  // File of the previous record
+
+/* Record hook of provio: keep a copy of every record of an open file */
+static void embed_record(const prov_fields *rec)
+{
+    const char *file_name = strcmp(rec->type, "provio:File") ? rec->file_name : rec->data_object;
+    file_prov_info_t *file_info = embed_last_file;
+    prov_embed_t *log;
+    embed_rec_t *r;
+
+    if(!file_name[0] || !PROV_HELPER)
+        return;
+    if(!file_info || !file_info->file_name || strcmp(file_info->file_name, file_name)) {
+        const prov_hash_t *table = &PROV_HELPER->opened_files;
+        unsigned long i;
+
+        file_info = NULL;
+        for(i = 0; i < table->nbuckets && !file_info; i++) {
+            prov_hash_node_t *node;
+
+            for(node = table->buckets[i]; node; node = node->next) {
+                file_prov_info_t *cur = (file_prov_info_t *)node;
+
+                if(cur->file_name && !strcmp(cur->file_name, file_name)) {
+                    file_info = cur;
+                    break;
+                }
+            }
+        }
+        if(!file_info)
+            return;
+        embed_last_file = file_info;
+    }
+
+    log = &file_info->embed;
+    if(log->rec_cnt == log->rec_max) {
+        size_t rec_max = log->rec_max ? 2 * log->rec_max : 64;
+        embed_rec_t *recs;
+
+        if(rec_max > (size_t)config.embed_max_records)
+            rec_max = config.embed_max_records;
+        if(rec_max <= log->rec_max
+                || !(recs = (embed_rec_t *)realloc(log->recs, rec_max * sizeof(embed_rec_t)))) {
+            log->dropped++;
+            return;
+        }
+        log->recs = recs;
+        log->rec_max = rec_max;
+    }
+
+    r = &log->recs[log->rec_cnt];
+    if(embed_intern(log, rec->data_object, &r->object) < 0
+            || embed_intern(log, rec->type, &r->type) < 0
+            || embed_intern(log, rec->relation, &r->relation) < 0
+            || embed_intern(log, rec->io_api, &r->api) < 0) {
+        log->dropped++;
+        return;
+    }
+    r->time = rec->timestamp;
+    r->duration = rec->duration;
+    r->bytes = rec->io_bytes;
+    r->rank = rec->mpi_rank_int;
+    log->rec_cnt++;
+}
+
+static void embed_log_reset(prov_embed_t *log)
+{
+    log->rec_cnt = 0;
+    log->dropped = 0;
+    log->strs_len = 0;
+    log->str_cnt = 0;
+    if(log->slots)
+        memset(log->slots, 0, log->nslots * sizeof(uint32_t));
+}
+
+static void embed_log_free(file_prov_info_t *info)
+{
+    free(info->embed.recs);
+    free(info->embed.strs);
+    free(info->embed.slots);
+    if(embed_last_file == info)
+        embed_last_file = NULL;
+}
+
+/* Open the dataset name of the Provenance group, or create an empty
+ * extendible one. *len_out is its current length. */
+static void *embed_dataset_open(void *group, hid_t vol_id, const char *name, hid_t type_id,
+        hsize_t chunk, int shuffle, hid_t dxpl_id, hsize_t *len_out)
+{
+    H5VL_loc_params_t loc_params;
+    H5VL_link_specific_args_t link_args;
+    H5VL_dataset_get_args_t get_args;
+    hbool_t exists = false;
+    void *dset;
+
+    loc_params.type = H5VL_OBJECT_BY_NAME;
+    loc_params.obj_type = H5I_GROUP;
+    loc_params.loc_data.loc_by_name.name = name;
+    loc_params.loc_data.loc_by_name.lapl_id = H5P_LINK_ACCESS_DEFAULT;
+    link_args.op_type = H5VL_LINK_EXISTS;
+    link_args.args.exists.exists = &exists;
+    if(H5VLlink_specific(group, &loc_params, vol_id, &link_args, dxpl_id, NULL) < 0)
+        return NULL;
+
+    loc_params.type = H5VL_OBJECT_BY_SELF;
+    if(!exists) {
+        hsize_t dims = 0, maxdims = H5S_UNLIMITED;
+        hid_t space_id = H5Screate_simple(1, &dims, &maxdims);
+        hid_t dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+
+        H5Pset_chunk(dcpl_id, 1, &chunk);
+        if(H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0) {
+            if(shuffle)
+                H5Pset_shuffle(dcpl_id);
+            H5Pset_deflate(dcpl_id, 6);
+        }
+        dset = H5VLdataset_create(group, &loc_params, vol_id, name, H5P_LINK_CREATE_DEFAULT,
+            type_id, space_id, dcpl_id, H5P_DATASET_ACCESS_DEFAULT, dxpl_id, NULL);
+        H5Pclose(dcpl_id);
+        H5Sclose(space_id);
+        *len_out = 0;
+        return dset;
+    }
+
+    dset = H5VLdataset_open(group, &loc_params, vol_id, name, H5P_DATASET_ACCESS_DEFAULT, dxpl_id, NULL);
+    if(!dset)
+        return NULL;
+    get_args.op_type = H5VL_DATASET_GET_SPACE;
+    get_args.args.get_space.space_id = H5I_INVALID_HID;
+    if(H5VLdataset_get(dset, vol_id, &get_args, dxpl_id, NULL) < 0
+            || H5Sget_simple_extent_ndims(get_args.args.get_space.space_id) != 1) {
+        if(get_args.args.get_space.space_id >= 0)
+            H5Sclose(get_args.args.get_space.space_id);
+        H5VLdataset_close(dset, vol_id, dxpl_id, NULL);
+        return NULL;
+    }
+    H5Sget_simple_extent_dims(get_args.args.get_space.space_id, len_out, NULL);
+    H5Sclose(get_args.args.get_space.space_id);
+    return dset;
+}
+
+/* Read or write count datasets of the underlying connector in one call,
+ * count must be 1 before HDF5 1.13.3 (VOL class version 3) */
+static herr_t under_dataset_io(size_t count, void *under[], hid_t vol_id, hid_t mem_type_id[],
+        hid_t mem_space_id[], hid_t file_space_id[], hid_t plist_id, void *buf[],
+        hbool_t write, void **req)
+{
+#if H5VL_VERSION >= 3
+    if(write)
+        return H5VLdataset_write(count, under, vol_id, mem_type_id, mem_space_id, file_space_id,
+            plist_id, (const void **)buf, req);
+    return H5VLdataset_read(count, under, vol_id, mem_type_id, mem_space_id, file_space_id,
+        plist_id, buf, req);
+#else
+    assert(count == 1);
+    if(write)
+        return H5VLdataset_write(under[0], vol_id, mem_type_id[0], mem_space_id[0], file_space_id[0],
+            plist_id, buf[0], req);
+    return H5VLdataset_read(under[0], vol_id, mem_type_id[0], mem_space_id[0], file_space_id[0],
+        plist_id, buf[0], req);
+#endif
+}
+
+/* Extend dset from len to len + total and write this rank's cnt elements at
+ * offset len + before. Collective over the file's communicator with a
+ * collective transfer list: the ranks agree the extent and space are fine
+ * before any of them enters the write. */
+static herr_t embed_dataset_append(file_prov_info_t *file_info, void *dset, hid_t vol_id,
+        hid_t mem_type_id, const void *buf, hsize_t len, hsize_t total, hsize_t before,
+        hsize_t cnt, hid_t dxpl_id)
+{
+    H5VL_dataset_specific_args_t spec_args;
+    H5VL_dataset_get_args_t get_args;
+    hsize_t size = len + total;
+    hsize_t start = len + before;
+    hsize_t mem_dims = cnt ? cnt : 1;
+    hid_t mem_space_id;
+    void *bufs[1] = {(void *)buf};
+    herr_t ret;
+    int ok;
+
+    spec_args.op_type = H5VL_DATASET_SET_EXTENT;
+    spec_args.args.set_extent.size = &size;
+    get_args.op_type = H5VL_DATASET_GET_SPACE;
+    get_args.args.get_space.space_id = H5I_INVALID_HID;
+    ok = H5VLdataset_specific(dset, vol_id, &spec_args, dxpl_id, NULL) >= 0
+        && H5VLdataset_get(dset, vol_id, &get_args, dxpl_id, NULL) >= 0;
+#ifdef H5_HAVE_PARALLEL
+    if(file_info->mpi_comm_info_valid && MPI_COMM_NULL != file_info->mpi_comm)
+        MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, file_info->mpi_comm);
+#endif /* H5_HAVE_PARALLEL */
+    if(!ok) {
+        if(get_args.args.get_space.space_id >= 0)
+            H5Sclose(get_args.args.get_space.space_id);
+        return -1;
     }
+
+    // Ranks without records still take part in the collective write
+    mem_space_id = H5Screate_simple(1, &mem_dims, NULL);
+    if(cnt)
+        H5Sselect_hyperslab(get_args.args.get_space.space_id, H5S_SELECT_SET, &start, NULL, &cnt, NULL);
+    else {
+        H5Sselect_none(get_args.args.get_space.space_id);
+        H5Sselect_none(mem_space_id);
+    }
+    ret = under_dataset_io(1, &dset, vol_id, &mem_type_id, &mem_space_id,
+        &get_args.args.get_space.space_id, dxpl_id, &bufs[0], true, NULL);
+    H5Sclose(mem_space_id);
+    H5Sclose(get_args.args.get_space.space_id);
+
+    // The next append is collective too, all ranks have to stop or go on
+    ok = ret >= 0;
+#ifdef H5_HAVE_PARALLEL
+    if(file_info->mpi_comm_info_valid && MPI_COMM_NULL != file_info->mpi_comm)
+        MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, file_info->mpi_comm);
 #endif /* H5_HAVE_PARALLEL */
-    if(info->file_name)
-        free(info->file_name);
-    free(info);
+    return ok ? 0 : -1;
 }
 
-void group_info_free(group_prov_info_t* info)
+/* The Provenance group of the file obj belongs to, created if it does
+ * not exist yet. obj may be any object of the file, the group is found
+ * by its absolute path. */
+static void *prov_group_open(void *under_obj, hid_t under_vol_id, H5I_type_t obj_type, hid_t dxpl_id)
 {
-    if(info->obj_info.name)
-        free(info->obj_info.name);
-    free(info);
+    H5VL_loc_params_t loc_params;
+    H5VL_link_specific_args_t link_args;
+    hbool_t exists = false;
+
+    loc_params.type = H5VL_OBJECT_BY_NAME;
+    loc_params.obj_type = obj_type;
+    loc_params.loc_data.loc_by_name.name = "/Provenance";
+    loc_params.loc_data.loc_by_name.lapl_id = H5P_LINK_ACCESS_DEFAULT;
+    link_args.op_type = H5VL_LINK_EXISTS;
+    link_args.args.exists.exists = &exists;
+    if(H5VLlink_specific(under_obj, &loc_params, under_vol_id, &link_args, dxpl_id, NULL) < 0)
+        return NULL;
+    loc_params.type = H5VL_OBJECT_BY_SELF;
+    if(exists)
+        return H5VLgroup_open(under_obj, &loc_params, under_vol_id, "/Provenance",
+            H5P_GROUP_ACCESS_DEFAULT, dxpl_id, NULL);
+    return H5VLgroup_create(under_obj, &loc_params, under_vol_id, "/Provenance",
+        H5P_LINK_CREATE_DEFAULT, H5P_GROUP_CREATE_DEFAULT, H5P_GROUP_ACCESS_DEFAULT, dxpl_id, NULL);
 }
 
-void dataset_info_free(dataset_prov_info_t* info)
+/* Write a string attribute of the Provenance group, unless it is there already */
+static int prov_group_attr_write(void *group, hid_t under_vol_id, const char *name,
+    const char *value, hid_t dxpl_id)
 {
-    if(info->obj_info.name)
-        free(info->obj_info.name);
-    free(info);
+    H5VL_loc_params_t loc_params;
+    H5VL_attr_specific_args_t attr_args;
+    hbool_t exists = false;
+    hsize_t dims = 1;
+    hid_t space_id, type_id;
+    void *attr;
+    int ret = 0;
+
+    loc_params.type = H5VL_OBJECT_BY_SELF;
+    loc_params.obj_type = H5I_GROUP;
+    attr_args.op_type = H5VL_ATTR_EXISTS;
+    attr_args.args.exists.name = name;
+    attr_args.args.exists.exists = &exists;
+    if(H5VLattr_specific(group, &loc_params, under_vol_id, &attr_args, dxpl_id, NULL) < 0)
+        return -1;
+    if(exists)
+        return 0;
+
+    space_id = H5Screate_simple(1, &dims, NULL);
+    type_id = H5Tcopy(H5T_C_S1);
+    H5Tset_size(type_id, strlen(value) + 1);
+    attr = H5VLattr_create(group, &loc_params, under_vol_id, name, type_id, space_id,
+        H5P_ATTRIBUTE_CREATE_DEFAULT, H5P_ATTRIBUTE_ACCESS_DEFAULT, dxpl_id, NULL);
+    if(!attr || H5VLattr_write(attr, under_vol_id, type_id, value, dxpl_id, NULL) < 0)
+        ret = -1;
+    if(attr)
+        H5VLattr_close(attr, under_vol_id, dxpl_id, NULL);
+    H5Tclose(type_id);
+    H5Sclose(space_id);
+    return ret;
 }
 
-void attribute_info_free(attribute_prov_info_t* info)
+/* The provenance file path and, for created files, the creation time are
+ * kept in file_info by file create/open and written as attributes of the
+ * Provenance group at the first flush or at close, which keeps the group
+ * and attribute creation off the H5Fcreate critical path. With parallel
+ * HDF5 all ranks of the file's communicator write rank 0's values. */
+static int file_prov_meta_write(H5VL_provenance_t *obj, hid_t dxpl_id)
 {
-    if(info->obj_info.name)
-        free(info->obj_info.name);
-    free(info);
+    file_prov_info_t *file_info = obj_file_info(obj);
+    void *group;
+    int ret = 0;
+
+    if(!file_info || !file_info->meta_path)
+        return 0;
+#ifdef H5_HAVE_PARALLEL
+    if(file_info->mpi_comm_info_valid && MPI_COMM_NULL != file_info->mpi_comm) {
+        int len = strlen(file_info->meta_path) + 1;
+        char *meta_path;
+        int ok;
+
+        MPI_Bcast(&len, 1, MPI_INT, 0, file_info->mpi_comm);
+        meta_path = realloc(file_info->meta_path, len);
+        if(meta_path)
+            file_info->meta_path = meta_path;
+        // All ranks skip the group together if one has no room for the path
+        ok = meta_path != NULL;
+        MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, file_info->mpi_comm);
+        if(!ok) {
+            printf("file_prov_meta_write(): %s: out of memory for the file path.\n",
+                file_info->file_name);
+            free(file_info->meta_path);
+            file_info->meta_path = NULL;
+            return -1;
+        }
+        MPI_Bcast(file_info->meta_path, len, MPI_CHAR, 0, file_info->mpi_comm);
+        MPI_Bcast(file_info->meta_created, sizeof(file_info->meta_created), MPI_CHAR, 0,
+            file_info->mpi_comm);
+    }
+#endif /* H5_HAVE_PARALLEL */
+
+    group = prov_group_open(obj->under_object, obj->under_vol_id, obj->my_type, dxpl_id);
+    if(!group
+            || prov_group_attr_write(group, obj->under_vol_id, "Path", file_info->meta_path, dxpl_id) < 0
+            || (file_info->meta_created[0] && prov_group_attr_write(group, obj->under_vol_id,
+                "Creation time", file_info->meta_created, dxpl_id) < 0)) {
+        printf("file_prov_meta_write(): %s: failed to write the Provenance group attributes.\n",
+            file_info->file_name);
+        ret = -1;
+    }
+    if(group)
+        H5VLgroup_close(group, obj->under_vol_id, dxpl_id, NULL);
+    free(file_info->meta_path);
+    file_info->meta_path = NULL;
+    return ret;
 }
 
-void dataset_stats_prov_write(const dataset_prov_info_t* ds_info){
-    if(!ds_info){
-//        printf("dataset_stats_prov_write(): ds_info is NULL.\n");
-        return;
+/* Write the file's records into its Provenance group (ENABLE_EMBED_PROV),
+ * as two extendible, chunked and compressed datasets:
+ *   Strings      every distinct string once, NUL-terminated
+ *   Activities   one compound record per activity, with the byte offsets of
+ *                its object, type, relation and API in Strings, its rank,
+ *                start time, duration and bytes moved
+ * Each close appends. With parallel HDF5 all ranks of the file's
+ * communicator write their records collectively. */
+static void file_embed_prov(H5VL_provenance_t *file)
+{
+    file_prov_info_t *file_info = (file_prov_info_t *)file->generic_prov_info;
+    prov_embed_t *log = &file_info->embed;
+    unsigned long long local[2], total[2], before[2] = {0, 0};  // records, string bytes
+    hid_t dxpl_id = H5Pcreate(H5P_DATASET_XFER);
+    hid_t mem_type_id = -1, file_type_id = -1;
+    void *group = NULL, *strs = NULL, *recs = NULL;
+    hsize_t strs_len = 0, recs_len = 0;
+    int dropped = log->dropped;
+    int ok;
+
+    local[0] = log->rec_cnt;
+    local[1] = log->strs_len;
+    total[0] = local[0];
+    total[1] = local[1];
+#ifdef H5_HAVE_PARALLEL
+    if(file_info->mpi_comm_info_valid && MPI_COMM_NULL != file_info->mpi_comm) {
+        int rank;
+
+        MPI_Allreduce(local, total, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, file_info->mpi_comm);
+        MPI_Exscan(local, before, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, file_info->mpi_comm);
+        MPI_Comm_rank(file_info->mpi_comm, &rank);
+        if(rank == 0)
+            before[0] = before[1] = 0;
+        H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_COLLECTIVE);
     }
-//    printf("Dataset name = %s,\ndata type class = %d, data space class = %d, data space size = %llu, data type size =%zu.\n",
-//            ds_info->dset_name, ds_info->dt_class, ds_info->ds_class,  (unsigned long long)ds_info->dset_space_size, ds_info->dset_type_size);
-//    printf("Dataset is %u dimensions.\n", ds_info->dimension_cnt);
-//    printf("Dataset is read %d time, %llu bytes in total, costs %llu us.\n", ds_info->dataset_read_cnt, ds_info->total_bytes_read, ds_info->total_read_time);
-//    printf("Dataset is written %d time, %llu bytes in total, costs %llu us.\n", ds_info->dataset_write_cnt, ds_info->total_bytes_written, ds_info->total_write_time);
+#endif /* H5_HAVE_PARALLEL */
+    if(!file_info->writable || total[0] == 0)
+        goto done;
+
+    group = prov_group_open(file->under_object, file->under_vol_id, H5I_FILE, dxpl_id);
+    if(group)
+        strs = embed_dataset_open(group, file->under_vol_id, "Strings", H5T_STD_U8LE, 65536, 0,
+            dxpl_id, &strs_len);
+
+    mem_type_id = H5Tcreate(H5T_COMPOUND, sizeof(embed_rec_t));
+    H5Tinsert(mem_type_id, "time", HOFFSET(embed_rec_t, time), H5T_NATIVE_UINT64);
+    H5Tinsert(mem_type_id, "duration", HOFFSET(embed_rec_t, duration), H5T_NATIVE_UINT64);
+    H5Tinsert(mem_type_id, "bytes", HOFFSET(embed_rec_t, bytes), H5T_NATIVE_UINT64);
+    H5Tinsert(mem_type_id, "object", HOFFSET(embed_rec_t, object), H5T_NATIVE_UINT32);
+    H5Tinsert(mem_type_id, "type", HOFFSET(embed_rec_t, type), H5T_NATIVE_UINT32);
+    H5Tinsert(mem_type_id, "relation", HOFFSET(embed_rec_t, relation), H5T_NATIVE_UINT32);
+    H5Tinsert(mem_type_id, "api", HOFFSET(embed_rec_t, api), H5T_NATIVE_UINT32);
+    H5Tinsert(mem_type_id, "rank", HOFFSET(embed_rec_t, rank), H5T_NATIVE_INT32);
+    file_type_id = H5Tcreate(H5T_COMPOUND, 3 * 8 + 5 * 4);
+    H5Tinsert(file_type_id, "time", 0, H5T_STD_U64LE);
+    H5Tinsert(file_type_id, "duration", 8, H5T_STD_U64LE);
+    H5Tinsert(file_type_id, "bytes", 16, H5T_STD_U64LE);
+    H5Tinsert(file_type_id, "object", 24, H5T_STD_U32LE);
+    H5Tinsert(file_type_id, "type", 28, H5T_STD_U32LE);
+    H5Tinsert(file_type_id, "relation", 32, H5T_STD_U32LE);
+    H5Tinsert(file_type_id, "api", 36, H5T_STD_U32LE);
+    H5Tinsert(file_type_id, "rank", 40, H5T_STD_I32LE);
+
+    if(strs)
+        recs = embed_dataset_open(group, file->under_vol_id, "Activities", file_type_id, 1024, 1,
+            dxpl_id, &recs_len);
+
+    // A rank that failed alone must not leave the others waiting in the
+    // collective appends
+    ok = recs != NULL;
+#ifdef H5_HAVE_PARALLEL
+    if(file_info->mpi_comm_info_valid && MPI_COMM_NULL != file_info->mpi_comm)
+        MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, file_info->mpi_comm);
+#endif /* H5_HAVE_PARALLEL */
+    if(!ok)
+        goto error;
+
+    // Records refer to the strings by offset in the whole dataset
+    if(strs_len + total[1] >= UINT32_MAX) {
+        printf("file_embed_prov(): %s: Strings would pass 4 GiB, records not embedded.\n",
+            file_info->file_name);
+        goto done;
+    }
+    for(size_t i = 0; i < log->rec_cnt; i++) {
+        embed_rec_t *r = &log->recs[i];
+        uint32_t base = (uint32_t)(strs_len + before[1]);
+
+        r->object += base;
+        r->type += base;
+        r->relation += base;
+        r->api += base;
+    }
+
+    if(embed_dataset_append(file_info, strs, file->under_vol_id, H5T_NATIVE_UCHAR, log->strs,
+            strs_len, total[1], before[1], local[1], dxpl_id) < 0
+            || embed_dataset_append(file_info, recs, file->under_vol_id, mem_type_id, log->recs,
+            recs_len, total[0], before[0], local[0], dxpl_id) < 0)
+        goto error;
+    goto done;
+
+error:
+    printf("file_embed_prov(): %s: failed to write records into the Provenance group.\n",
+        file_info->file_name);
+done:
+    if(recs)
+        H5VLdataset_close(recs, file->under_vol_id, dxpl_id, NULL);
+    if(strs)
+        H5VLdataset_close(strs, file->under_vol_id, dxpl_id, NULL);
+    if(group)
+        H5VLgroup_close(group, file->under_vol_id, dxpl_id, NULL);
+    if(file_type_id >= 0)
+        H5Tclose(file_type_id);
+    if(mem_type_id >= 0)
+        H5Tclose(mem_type_id);
+    H5Pclose(dxpl_id);
+    if(dropped)
+        printf("file_embed_prov(): %s: %d records exceeded EMBED_MAX_RECORDS and were not embedded.\n",
+            file_info->file_name, dropped);
+    embed_log_reset(log);
 }
 
 //not file_prov_info_t!
 void file_stats_prov_write(const file_prov_info_t* file_info) {
-    if(!file_info){
- //       printf("file_stats_prov_write(): ds_info is NULL.\n");
+    prov_summary_item items[6];
+    int n = 0;
+
+    if(!file_info || !config.enable_summaries)
         return;
-    }
 
-    //printf("H5 file closed, %d datasets are created, %d datasets are accessed.\n", file_info->ds_created, file_info->ds_accessed);
+    n += summary_set(&items[n], "datasetsCreated", "%d", file_info->ds_created);
+    n += summary_set(&items[n], "datasetsOpened", "%d", file_info->ds_accessed);
+    n += summary_set(&items[n], "groupsCreated", "%d", file_info->grp_created);
+    n += summary_set(&items[n], "groupsOpened", "%d", file_info->grp_accessed);
+    n += summary_set(&items[n], "datatypesCommitted", "%d", file_info->dtypes_created);
+    n += summary_set(&items[n], "datatypesOpened", "%d", file_info->dtypes_accessed);
 
+    add_summary_record(&config, provio_helper, &fields, file_info->file_name,
+        "provio:File", file_info->file_name, items, n);
 }
 
 void datatype_stats_prov_write(const datatype_prov_info_t* dt_info) {
@@ -713,11 +2208,19 @@ void datatype_stats_prov_write(const datatype_prov_info_t* dt_info) {
 }
 
 void group_stats_prov_write(const group_prov_info_t* grp_info) {
-    if(!grp_info){
-        //printf("group_stats_prov_write(): grp_info is NULL.\n");
+    prov_summary_item items[1];
+    int n = 0;
+
+    if(!grp_info || !config.enable_summaries)
         return;
-    }
-    //printf("group_stats_prov_write() is yet to be implemented.\n");
+    if(grp_info->obj_info.ref_cnt > 1)
+        return;
+
+    n += summary_set(&items[n], "opens", "%d", grp_info->access_cnt);
+
+    add_summary_record(&config, provio_helper, &fields, summary_obj_name(&grp_info->obj_info),
+        "provio:Group", grp_info->obj_info.file_info ? grp_info->obj_info.file_info->file_name : "",
+        items, n);
 }
 
 void attribute_stats_prov_write(const attribute_prov_info_t *attr_info) {
@@ -731,18 +2234,17 @@ void attribute_stats_prov_write(const attribute_prov_info_t *attr_info) {
 void prov_verify_open_things(int open_files, int open_dsets)
 {
     if(PROV_HELPER) {
-        assert(open_files == PROV_HELPER->opened_files_cnt);
+        assert(open_files == PROV_HELPER->opened_files.cnt);
 
         /* Check opened datasets */
         if(open_files > 0) {
-            file_prov_info_t* opened_file;
+            prov_hash_node_t* node;
             int total_open_dsets = 0;
+            unsigned long i;
 
-            opened_file = PROV_HELPER->opened_files;
-            while(opened_file) {
-                total_open_dsets += opened_file->opened_datasets_cnt;
-                opened_file = opened_file->next;
-            }
+            for(i = 0; i < PROV_HELPER->opened_files.nbuckets; i++)
+                for(node = PROV_HELPER->opened_files.buckets[i]; node; node = node->next)
+                    total_open_dsets += ((file_prov_info_t *)node)->opened_datasets.cnt;
             assert(open_dsets == total_open_dsets);
         }
     }
@@ -752,39 +2254,41 @@ void prov_verify_open_things(int open_files, int open_dsets)
 void prov_dump_open_things(FILE *f)
 {
     if(PROV_HELPER) {
-        file_prov_info_t *opened_file;
+        prov_hash_node_t *file_node;
         unsigned file_count = 0;
+        unsigned long i, j;
 
-        fprintf(f, "# of open files: %d\n", PROV_HELPER->opened_files_cnt);
+        fprintf(f, "# of open files: %d\n", PROV_HELPER->opened_files.cnt);
 
         /* Print opened files */
-        opened_file = PROV_HELPER->opened_files;
-        while(opened_file) {
-            dataset_prov_info_t *opened_dataset;
+        for(i = 0; i < PROV_HELPER->opened_files.nbuckets; i++)
+        for(file_node = PROV_HELPER->opened_files.buckets[i]; file_node; file_node = file_node->next) {
+            file_prov_info_t *opened_file = (file_prov_info_t *)file_node;
+            prov_hash_node_t *dset_node;
             unsigned dset_count = 0;
 
             fprintf(f, "file #%u: info ptr = %p, name = '%s', fileno = %lu\n", file_count, (void *)opened_file, opened_file->file_name, opened_file->file_no);
             fprintf(f, "\tref_cnt = %d\n", opened_file->ref_cnt);
 
             /* Print opened datasets */
-            fprintf(f, "\topened_datasets_cnt = %d\n", opened_file->opened_datasets_cnt);
-            opened_dataset = opened_file->opened_datasets;
-            while(opened_dataset) {
+            fprintf(f, "\topened_datasets_cnt = %d\n", opened_file->opened_datasets.cnt);
+            for(j = 0; j < opened_file->opened_datasets.nbuckets; j++)
+            for(dset_node = opened_file->opened_datasets.buckets[j]; dset_node; dset_node = dset_node->next) {
+                dataset_prov_info_t *opened_dataset = (dataset_prov_info_t *)dset_node;
+
                 // need to be fixed if the function got called
                 // fprintf(f, "\t\tdataset #%u: name = '%s', objno = %llu\n", dset_count, opened_dataset->obj_info.name, (unsigned long long)opened_dataset->obj_info.objno);
                 fprintf(f, "\t\t\tfile_info ptr = %p\n", (void *)opened_dataset->obj_info.file_info);
                 fprintf(f, "\t\t\tref_cnt = %d\n", opened_dataset->obj_info.ref_cnt);
 
                 dset_count++;
-                opened_dataset = opened_dataset->next;
             }
 
-            fprintf(f, "\topened_grps_cnt = %d\n", opened_file->opened_grps_cnt);
-            fprintf(f, "\topened_dtypes_cnt = %d\n", opened_file->opened_dtypes_cnt);
-            fprintf(f, "\topened_attrs_cnt = %d\n", opened_file->opened_attrs_cnt);
+            fprintf(f, "\topened_grps_cnt = %d\n", opened_file->opened_grps.cnt);
+            fprintf(f, "\topened_dtypes_cnt = %d\n", opened_file->opened_dtypes.cnt);
+            fprintf(f, "\topened_attrs_cnt = %d\n", opened_file->opened_attrs.cnt);
 
             file_count++;
-            opened_file = opened_file->next;
         }
     }
     else
@@ -804,6 +2308,8 @@ prov_helper_t * prov_helper_init( char* file_path, Prov_level prov_level, char*
 
     /* PROV-IO instrument point */
     provio_helper = provio_helper_init(&config, &fields);
+    stat_func_table_init(prov_cb_names, PROV_CB_COUNT);
+    stat_pool_table_init(prov_pool_names, PROV_POOL_COUNT);
 
     new_helper->prov_file_path = strdup(file_path);
     new_helper->prov_line_format = strdup(prov_line_format);
@@ -811,21 +2317,20 @@ prov_helper_t * prov_helper_init( char* file_path, Prov_level prov_level, char*
     new_helper->pid = getpid();
     new_helper->tid = pthread_self();
 
-    new_helper->opened_files = NULL;
-    new_helper->opened_files_cnt = 0;
-
     getlogin_r(new_helper->user_name, 32);
 
     // if(new_helper->prov_level == File_only || new_helper->prov_level == File_and_print)
     //     new_helper->prov_file_handle = fopen(new_helper->prov_file_path, "a");
 
-    _dic_init();
     return new_helper;
 }
 
 void prov_helper_teardown(prov_helper_t* helper){
     if(helper){// not null
         char pline[512];
+        Stat total;
+
+        stat_blocks_sum(NULL, &total);
         sprintf(pline,
                 "TOTAL_PROV_OVERHEAD %lu\n"
                 "TOTAL_NATIVE_H5_TIME %lu\n"
@@ -835,14 +2340,14 @@ void prov_helper_teardown(prov_helper_t* helper){
                 "GRP_LL_TOTAL_TIME %lu\n"
                 "DT_LL_TOTAL_TIME %lu\n"
                 "ATTR_LL_TOTAL_TIME %lu\n",
-                TOTAL_PROV_OVERHEAD,
-                TOTAL_NATIVE_H5_TIME,
-                PROV_WRITE_TOTAL_TIME,
-                FILE_LL_TOTAL_TIME,
-                DS_LL_TOTAL_TIME,
-                GRP_LL_TOTAL_TIME,
-                DT_LL_TOTAL_TIME,
-                ATTR_LL_TOTAL_TIME);
+                total.TOTAL_PROV_OVERHEAD,
+                total.TOTAL_NATIVE_H5_TIME,
+                total.PROV_WRITE_TOTAL_TIME,
+                total.FILE_LL_TOTAL_TIME,
+                total.DS_LL_TOTAL_TIME,
+                total.GRP_LL_TOTAL_TIME,
+                total.DT_LL_TOTAL_TIME,
+                total.ATTR_LL_TOTAL_TIME);
 
         switch(helper->prov_level){
             case File_only:
@@ -880,8 +2385,8 @@ void prov_helper_teardown(prov_helper_t* helper){
         if(provio_helper)
             provio_helper_teardown(&config, provio_helper, &fields);
 
+        prov_hash_free(&helper->opened_files);
         free(helper);
-        _dic_free();
     }
 }
 
@@ -901,25 +2406,63 @@ void file_ds_accessed(file_prov_info_t* info)
         info->ds_accessed++;
 }
 
+void file_grp_created(file_prov_info_t *info)
+{
+    assert(info);
+    if(info)
+        info->grp_created++;
+}
+
+void file_dtype_created(file_prov_info_t *info)
+{
+    assert(info);
+    if(info)
+        info->dtypes_created++;
+}
+
+/* Open object of a file table with the token, attributes also need the name
+ * as all attributes of an object have the object's token */
+static object_prov_info_t *obj_table_find(const prov_hash_t *table, unsigned long key,
+    const H5VL_provenance_t *obj, const H5O_token_t *token, const char *name, int match_name)
+{
+    prov_hash_node_t *node;
+
+    for(node = prov_hash_find(table, key); node; node = prov_hash_next(node)) {
+        object_prov_info_t *info = (object_prov_info_t *)node;
+        int cmp_value = 1;
+
+        if (H5VLtoken_cmp(obj->under_object, obj->under_vol_id,
+                          &(info->token), token, &cmp_value) < 0)
+            fprintf(stderr, "H5VLtoken_cmp error");
+        if (cmp_value != 0)
+            continue;
+        if (!match_name || (info->name && name ? !strcmp(info->name, name) : info->name == name))
+            return info;
+    }
+
+    return NULL;
+}
+
+static void obj_table_insert(prov_hash_t *table, object_prov_info_t *info, unsigned long key)
+{
+    if(prov_hash_insert(table, &info->hash_node, key) < 0)
+        fprintf(stderr, "%s: out of memory, object '%s' is not tracked\n",
+                __func__, info->name ? info->name : "");
+}
+
 datatype_prov_info_t * add_dtype_node(file_prov_info_t *file_info,
     H5VL_provenance_t *dtype, const char *obj_name, H5O_token_t token)
 {
     unsigned long start = get_time_usec();
+    STAT_PHASE_START(list_start);
     datatype_prov_info_t *cur;
-    int cmp_value;
+    unsigned long key = obj_token_key(&token, NULL);
 
     assert(file_info);
 
-    // Find datatype in linked list of opened datatypes
-    cur = file_info->opened_dtypes;
-    while (cur) {
-        if (H5VLtoken_cmp(dtype->under_object, dtype->under_vol_id,
-		          &(cur->obj_info.token), &token, &cmp_value) < 0)
-	    fprintf(stderr, "H5VLtoken_cmp error");
-        if (cmp_value == 0)
-            break;
-        cur = cur->next;
-    }
+    // Find datatype in the table of opened datatypes
+    cur = (datatype_prov_info_t *)obj_table_find(&file_info->opened_dtypes, key,
+            dtype, &token, NULL, 0);
 
     if(!cur) {
         // Allocate and initialize new datatype node
@@ -928,26 +2471,23 @@ datatype_prov_info_t * add_dtype_node(file_prov_info_t *file_info,
         // Increment refcount on file info
         file_info->ref_cnt++;
 
-        // Add to linked list
-        cur->next = file_info->opened_dtypes;
-        file_info->opened_dtypes = cur;
-        file_info->opened_dtypes_cnt++;
+        // Add to table of opened datatypes
+        obj_table_insert(&file_info->opened_dtypes, &cur->obj_info, key);
     }
 
     // Increment refcount on datatype
     cur->obj_info.ref_cnt++;
 
-    DT_LL_TOTAL_TIME += (get_time_usec() - start);
+    vol_stat.DT_LL_TOTAL_TIME += (get_time_usec() - start);
+    STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
     return cur;
 }
 
 int rm_dtype_node(prov_helper_t *helper, void *under, hid_t under_vol_id, datatype_prov_info_t *dtype_info)
 {
     unsigned long start = get_time_usec();
+    STAT_PHASE_START(list_start);
     file_prov_info_t *file_info;
-    datatype_prov_info_t *cur;
-    datatype_prov_info_t *last;
-    int cmp_value;
 
     // Decrement refcount
     dtype_info->obj_info.ref_cnt--;
@@ -960,41 +2500,23 @@ int rm_dtype_node(prov_helper_t *helper, void *under, hid_t under_vol_id, dataty
 
     file_info = dtype_info->obj_info.file_info;
     assert(file_info);
-    assert(file_info->opened_dtypes);
-
-    cur = file_info->opened_dtypes;
-    last = cur;
-    while(cur) {
-        if (H5VLtoken_cmp(under, under_vol_id, &(cur->obj_info.token),
-                          &(dtype_info->obj_info.token), &cmp_value) < 0)
-	    fprintf(stderr, "H5VLtoken_cmp error");
-        if (cmp_value == 0) {
-            //special case: first node is the target, ==cur
-            if(cur == file_info->opened_dtypes)
-                file_info->opened_dtypes = file_info->opened_dtypes->next;
-            else
-                last->next = cur->next;
-
-            dtype_info_free(cur);
 
-            file_info->opened_dtypes_cnt--;
-            if(file_info->opened_dtypes_cnt == 0)
-                assert(file_info->opened_dtypes == NULL);
+    if(prov_hash_remove(&file_info->opened_dtypes, &dtype_info->obj_info.hash_node) < 0) {
+        vol_stat.DT_LL_TOTAL_TIME += (get_time_usec() - start);
+        STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
+        //node not found.
+        return -1;
+    }
 
-            // Decrement refcount on file info
-            DT_LL_TOTAL_TIME += (get_time_usec() - start);
-            rm_file_node(helper, file_info->file_no);
+    dtype_info_free(dtype_info);
 
-            return 0;
-        }
+    vol_stat.DT_LL_TOTAL_TIME += (get_time_usec() - start);
+    STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
 
-        last = cur;
-        cur = cur->next;
-    }
+    // Decrement refcount on file info
+    rm_file_node(helper, file_info->file_no);
 
-    DT_LL_TOTAL_TIME += (get_time_usec() - start);
-    //node not found.
-    return -1;
+    return 0;
 }
 
 group_prov_info_t *add_grp_node(file_prov_info_t *file_info,
@@ -1002,19 +2524,14 @@ group_prov_info_t *add_grp_node(file_prov_info_t *file_info,
 {
     group_prov_info_t *cur;
     unsigned long start = get_time_usec();
+    STAT_PHASE_START(list_start);
+    unsigned long key = obj_token_key(&token, NULL);
+
     assert(file_info);
-    int cmp_value;
-
-    // Find group in linked list of opened groups
-    cur = file_info->opened_grps;
-    while (cur) {
-        if (H5VLtoken_cmp(upper_o->under_object, upper_o->under_vol_id,
-                          &(cur->obj_info.token), &token, &cmp_value) < 0)
-	    fprintf(stderr, "H5VLtoken_cmp error");
-        if (cmp_value == 0)
-            break;
-        cur = cur->next;
-    }
+
+    // Find group in the table of opened groups
+    cur = (group_prov_info_t *)obj_table_find(&file_info->opened_grps, key,
+            upper_o, &token, NULL, 0);
 
     if(!cur) {
         // Allocate and initialize new group node
@@ -1023,25 +2540,23 @@ group_prov_info_t *add_grp_node(file_prov_info_t *file_info,
         // Increment refcount on file info
         file_info->ref_cnt++;
 
-        // Add to linked list
-        cur->next = file_info->opened_grps;
-        file_info->opened_grps = cur;
-        file_info->opened_grps_cnt++;
+        // Add to table of opened groups
+        obj_table_insert(&file_info->opened_grps, &cur->obj_info, key);
     }
 
     // Increment refcount on group
     cur->obj_info.ref_cnt++;
+    cur->access_cnt++;
 
-    GRP_LL_TOTAL_TIME += (get_time_usec() - start);
+    vol_stat.GRP_LL_TOTAL_TIME += (get_time_usec() - start);
+    STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
     return cur;
 }
 
 int rm_grp_node(prov_helper_t *helper, void *under_obj, hid_t under_vol_id, group_prov_info_t *grp_info)
 {   unsigned long start = get_time_usec();
+    STAT_PHASE_START(list_start);
     file_prov_info_t *file_info;
-    group_prov_info_t *cur;
-    group_prov_info_t *last;
-    int cmp_value;
 
     // Decrement refcount
     grp_info->obj_info.ref_cnt--;
@@ -1054,88 +2569,66 @@ int rm_grp_node(prov_helper_t *helper, void *under_obj, hid_t under_vol_id, grou
 
     file_info = grp_info->obj_info.file_info;
     assert(file_info);
-    assert(file_info->opened_grps);
-
-    cur = file_info->opened_grps;
-    last = cur;
-    while(cur) {
-        if (H5VLtoken_cmp(under_obj, under_vol_id, &(cur->obj_info.token),
-                          &(grp_info->obj_info.token), &cmp_value) < 0)
-	    fprintf(stderr, "H5VLtoken_cmp error");
-        if (cmp_value == 0) { //node found
-            //special case: first node is the target, ==cur
-            if (cur == file_info->opened_grps)
-                file_info->opened_grps = file_info->opened_grps->next;
-            else
-                last->next = cur->next;
 
-            group_info_free(cur);
-
-            file_info->opened_grps_cnt--;
-            if (file_info->opened_grps_cnt == 0)
-                assert(file_info->opened_grps == NULL);
+    if(prov_hash_remove(&file_info->opened_grps, &grp_info->obj_info.hash_node) < 0) {
+        vol_stat.GRP_LL_TOTAL_TIME += (get_time_usec() - start);
+        STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
+        //node not found.
+        return -1;
+    }
 
-            // Decrement refcount on file info
-            GRP_LL_TOTAL_TIME += (get_time_usec() - start);
-            rm_file_node(helper, file_info->file_no);
+    group_info_free(grp_info);
 
-            return 0;
-        }
+    vol_stat.GRP_LL_TOTAL_TIME += (get_time_usec() - start);
+    STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
 
-        last = cur;
-        cur = cur->next;
-    }
+    // Decrement refcount on file info
+    rm_file_node(helper, file_info->file_no);
 
-    GRP_LL_TOTAL_TIME += (get_time_usec() - start);
-    //node not found.
-    return -1;
+    return 0;
 }
 
 attribute_prov_info_t *add_attr_node(file_prov_info_t *file_info,
     H5VL_provenance_t *attr, const char *obj_name, H5O_token_t token)
 {   unsigned long start = get_time_usec();
+    STAT_PHASE_START(list_start);
     attribute_prov_info_t *cur;
-    int cmp_value;
+    unsigned long key = obj_token_key(&token, obj_name);
 
     assert(file_info);
 
-    // Find attribute in linked list of opened attributes
-    cur = file_info->opened_attrs;
-    while (cur) {
-        if (H5VLtoken_cmp(attr->under_object, attr->under_vol_id,
-                          &(cur->obj_info.token), &token, &cmp_value) < 0)
-	    fprintf(stderr, "H5VLtoken_cmp error");
-        if (cmp_value == 0)
-            break;
-        cur = cur->next;
-    }
+    // Find attribute in the table of opened attributes. Attributes have
+    // the token of the object they are attached to, the name tells them apart.
+    cur = (attribute_prov_info_t *)obj_table_find(&file_info->opened_attrs, key,
+            attr, &token, obj_name, 1);
 
     if(!cur) {
         // Allocate and initialize new attribute node
         cur = new_attribute_info(file_info, obj_name, token);
 
+        // The attribute name is all obj_prov_name() needs
+        cur->obj_info.path = obj_name ? strdup(obj_name) : NULL;
+        cur->obj_info.path_gen = file_info->name_gen;
+
         // Increment refcount on file info
         file_info->ref_cnt++;
 
-        // Add to linked list
-        cur->next = file_info->opened_attrs;
-        file_info->opened_attrs = cur;
-        file_info->opened_attrs_cnt++;
+        // Add to table of opened attributes
+        obj_table_insert(&file_info->opened_attrs, &cur->obj_info, key);
     }
 
     // Increment refcount on attribute
     cur->obj_info.ref_cnt++;
 
-    ATTR_LL_TOTAL_TIME += (get_time_usec() - start);
+    vol_stat.ATTR_LL_TOTAL_TIME += (get_time_usec() - start);
+    STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
     return cur;
 }
 
 int rm_attr_node(prov_helper_t *helper, void *under_obj, hid_t under_vol_id, attribute_prov_info_t *attr_info)
 {   unsigned long start = get_time_usec();
+    STAT_PHASE_START(list_start);
     file_prov_info_t *file_info;
-    attribute_prov_info_t *cur;
-    attribute_prov_info_t *last;
-    int cmp_value;
 
     // Decrement refcount
     attr_info->obj_info.ref_cnt--;
@@ -1148,155 +2641,114 @@ int rm_attr_node(prov_helper_t *helper, void *under_obj, hid_t under_vol_id, att
 
     file_info = attr_info->obj_info.file_info;
     assert(file_info);
-    assert(file_info->opened_attrs);
-
-    cur = file_info->opened_attrs;
-    last = cur;
-    while(cur) {
-	if (H5VLtoken_cmp(under_obj, under_vol_id, &(cur->obj_info.token),
-                          &(attr_info->obj_info.token), &cmp_value) < 0)
-	    fprintf(stderr, "H5VLtoken_cmp error");
-	if (cmp_value == 0) { //node found
-            //special case: first node is the target, ==cur
-            if(cur == file_info->opened_attrs)
-                file_info->opened_attrs = file_info->opened_attrs->next;
-            else
-                last->next = cur->next;
 
-            attribute_info_free(cur);
+    if(prov_hash_remove(&file_info->opened_attrs, &attr_info->obj_info.hash_node) < 0) {
+        vol_stat.ATTR_LL_TOTAL_TIME += (get_time_usec() - start);
+        STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
+        //node not found.
+        return -1;
+    }
+
+    attribute_info_free(attr_info);
 
-            file_info->opened_attrs_cnt--;
-            if(file_info->opened_attrs_cnt == 0)
-                assert(file_info->opened_attrs == NULL);
+    vol_stat.ATTR_LL_TOTAL_TIME += (get_time_usec() - start);
+    STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
 
-            ATTR_LL_TOTAL_TIME += (get_time_usec() - start);
+    // Decrement refcount on file info
+    rm_file_node(helper, file_info->file_no);
 
-            // Decrement refcount on file info
-            rm_file_node(helper, file_info->file_no);
+    return 0;
+}
 
-            return 0;
-        }
+static file_prov_info_t* file_table_find(const prov_helper_t* helper, unsigned long file_no)
+{
+    prov_hash_node_t* node;
 
-        last = cur;
-        cur = cur->next;
-    }
+    for(node = prov_hash_find(&helper->opened_files, prov_hash_mix(file_no));
+            node; node = prov_hash_next(node))
+        if(((file_prov_info_t *)node)->file_no == file_no)
+            return (file_prov_info_t *)node;
 
-    ATTR_LL_TOTAL_TIME += (get_time_usec() - start);
-    //node not found.
-    return -1;
+    return NULL;
 }
 
 file_prov_info_t* add_file_node(prov_helper_t* helper, const char* file_name,
     unsigned long file_no)
 {
     unsigned long start = get_time_usec();
+    STAT_PHASE_START(list_start);
     file_prov_info_t* cur;
 
     assert(helper);
+    assert(file_no);
 
-    if(!helper->opened_files) //empty linked list, no opened file.
-        assert(helper->opened_files_cnt == 0);
-
-    // Search for file in list of currently opened ones
-    cur = helper->opened_files;
-    while (cur) {
-        assert(cur->file_no);
-
-        if (cur->file_no == file_no)
-            break;
-
-        cur = cur->next;
-    }
+    // Search for file in table of currently opened ones
+    cur = file_table_find(helper, file_no);
 
     if(!cur) {
         // Allocate and initialize new file node
         cur = new_file_info(file_name, file_no);
 
-        // Add to linked list
-        cur->next = helper->opened_files;
-        helper->opened_files = cur;
-        helper->opened_files_cnt++;
+        // Add to table of opened files
+        if(prov_hash_insert(&helper->opened_files, &cur->hash_node, prov_hash_mix(file_no)) < 0)
+            fprintf(stderr, "%s: out of memory, file '%s' is not tracked\n",
+                    __func__, file_name ? file_name : "");
     }
 
     // Increment refcount on file node
     cur->ref_cnt++;
 
-    FILE_LL_TOTAL_TIME += (get_time_usec() - start);
+    vol_stat.FILE_LL_TOTAL_TIME += (get_time_usec() - start);
+    STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
     return cur;
 }
 
-//need a dumy node to make it simpler
 int rm_file_node(prov_helper_t* helper, unsigned long file_no)
 {
     unsigned long start = get_time_usec();
+    STAT_PHASE_START(list_start);
     file_prov_info_t* cur;
-    file_prov_info_t* last;
 
     assert(helper);
-    assert(helper->opened_files);
-    assert(helper->opened_files_cnt);
+    assert(helper->opened_files.cnt);
     assert(file_no);
 
-    cur = helper->opened_files;
-    last = cur;
-    while(cur) {
-        // Node found
-        if(cur->file_no == file_no) {
-            // Decrement file node's refcount
-            cur->ref_cnt--;
-
-            // If refcount == 0, remove file node & maybe print file stats
-            if(cur->ref_cnt == 0) {
-                // Sanity checks
-                assert(0 == cur->opened_datasets_cnt);
-                assert(0 == cur->opened_grps_cnt);
-                assert(0 == cur->opened_dtypes_cnt);
-                assert(0 == cur->opened_attrs_cnt);
-
-                // Unlink from list of opened files
-                if(cur == helper->opened_files) //first node is the target
-                    helper->opened_files = helper->opened_files->next;
-                else
-                    last->next = cur->next;
+    cur = file_table_find(helper, file_no);
+    if(cur) {
+        // Decrement file node's refcount
+        cur->ref_cnt--;
 
-                // Free file info
-                file_info_free(cur);
+        // If refcount == 0, remove file node & maybe print file stats
+        if(cur->ref_cnt == 0) {
+            // Sanity checks
+            assert(0 == cur->opened_datasets.cnt);
+            assert(0 == cur->opened_grps.cnt);
+            assert(0 == cur->opened_dtypes.cnt);
+            assert(0 == cur->opened_attrs.cnt);
 
-                // Update connector info
-                helper->opened_files_cnt--;
-                if(helper->opened_files_cnt == 0)
-                    assert(helper->opened_files == NULL);
-            }
+            file_stats_prov_write(cur);
 
-            break;
-        }
+            // Remove from table of opened files
+            prov_hash_remove(&helper->opened_files, &cur->hash_node);
 
-        // Advance to next file node
-        last = cur;
-        cur = cur->next;
+            // Free file info
+            file_info_free(cur);
+        }
     }
 
-    FILE_LL_TOTAL_TIME += (get_time_usec() - start);
-    return helper->opened_files_cnt;
+    vol_stat.FILE_LL_TOTAL_TIME += (get_time_usec() - start);
+    STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
+    return helper->opened_files.cnt;
 }
 
 file_prov_info_t* _search_home_file(unsigned long obj_file_no){
     file_prov_info_t* cur;
 
-    if(PROV_HELPER->opened_files_cnt < 1)
-        return NULL;
-
-    cur = PROV_HELPER->opened_files;
-    while (cur) {
-        if (cur->file_no == obj_file_no) {//file found
-            cur->ref_cnt++;
-            return cur;
-        }
-
-        cur = cur->next;
-    }
+    cur = file_table_find(PROV_HELPER, obj_file_no);
+    if(cur)//file found
+        cur->ref_cnt++;
 
-    return NULL;
+    return cur;
 }
 
 dataset_prov_info_t * add_dataset_node(unsigned long obj_file_no,
@@ -1305,9 +2757,10 @@ dataset_prov_info_t * add_dataset_node(unsigned long obj_file_no,
     hid_t dxpl_id, void** req)
 {
     unsigned long start = get_time_usec();
+    STAT_PHASE_START(list_start);
     file_prov_info_t* file_info;
     dataset_prov_info_t* cur;
-    int cmp_value;
+    unsigned long key = obj_token_key(&token, NULL);
 
     assert(dset);
     assert(dset->under_object);
@@ -1326,17 +2779,9 @@ dataset_prov_info_t * add_dataset_node(unsigned long obj_file_no,
         file_info = file_info_in;
     }
 
-    // Find dataset in linked list of opened datasets
-    cur = file_info->opened_datasets;
-    while (cur) {
-        if (H5VLtoken_cmp(dset->under_object, dset->under_vol_id,
-                          &(cur->obj_info.token), &token, &cmp_value) < 0)
-	    fprintf(stderr, "H5VLtoken_cmp error");
-        if (cmp_value == 0)
-	    break;
-
-        cur = cur->next;
-    }
+    // Find dataset in the table of opened datasets
+    cur = (dataset_prov_info_t *)obj_table_find(&file_info->opened_datasets, key,
+            dset, &token, NULL, 0);
 
     if(!cur) {
         cur = new_ds_prov_info(dset->under_object, dset->under_vol_id, token, file_info, ds_name, dxpl_id, req);
@@ -1344,27 +2789,24 @@ dataset_prov_info_t * add_dataset_node(unsigned long obj_file_no,
         // Increment refcount on file info
         file_info->ref_cnt++;
 
-        // Add to linked list of opened datasets
-        cur->next = file_info->opened_datasets;
-        file_info->opened_datasets = cur;
-        file_info->opened_datasets_cnt++;
+        // Add to table of opened datasets
+        obj_table_insert(&file_info->opened_datasets, &cur->obj_info, key);
     }
 
     // Increment refcount on dataset
     cur->obj_info.ref_cnt++;
+    cur->access_cnt++;
 
-    DS_LL_TOTAL_TIME += (get_time_usec() - start);
+    vol_stat.DS_LL_TOTAL_TIME += (get_time_usec() - start);
+    STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
     return cur;
 }
 
-//need a dumy node to make it simpler
 int rm_dataset_node(prov_helper_t *helper, void *under_obj, hid_t under_vol_id, dataset_prov_info_t *dset_info)
 {
     unsigned long start = get_time_usec();
+    STAT_PHASE_START(list_start);
     file_prov_info_t *file_info;
-    dataset_prov_info_t *cur;
-    dataset_prov_info_t *last;
-    int cmp_value;
 
     // Decrement refcount
     dset_info->obj_info.ref_cnt--;
@@ -1376,41 +2818,23 @@ int rm_dataset_node(prov_helper_t *helper, void *under_obj, hid_t under_vol_id,
     // Refcount == 0, remove dataset from file info
     file_info = dset_info->obj_info.file_info;
     assert(file_info);
-    assert(file_info->opened_datasets);
-
-    cur = file_info->opened_datasets;
-    last = cur;
-    while(cur){
-        if (H5VLtoken_cmp(under_obj, under_vol_id, &(cur->obj_info.token),
-                          &(dset_info->obj_info.token), &cmp_value) < 0)
-	    fprintf(stderr, "H5VLtoken_cmp error");
-	if (cmp_value == 0) {//node found
-            //special case: first node is the target, ==cur
-            if(cur == file_info->opened_datasets)
-                file_info->opened_datasets = file_info->opened_datasets->next;
-            else
-                last->next = cur->next;
 
-            dataset_info_free(cur);
-
-            file_info->opened_datasets_cnt--;
-            if(file_info->opened_datasets_cnt == 0)
-                assert(file_info->opened_datasets == NULL);
+    if(prov_hash_remove(&file_info->opened_datasets, &dset_info->obj_info.hash_node) < 0) {
+        vol_stat.DS_LL_TOTAL_TIME += (get_time_usec() - start);
+        STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
+        //node not found.
+        return -1;
+    }
 
-            // Decrement refcount on file info
-            DS_LL_TOTAL_TIME += (get_time_usec() - start);
-            rm_file_node(helper, file_info->file_no);
+    dataset_info_free(dset_info);
 
-            return 0;
-        }
+    vol_stat.DS_LL_TOTAL_TIME += (get_time_usec() - start);
+    STAT_PHASE_STOP(STAT_PHASE_LIST, list_start);
 
-        last = cur;
-        cur = cur->next;
-    }
+    // Decrement refcount on file info
+    rm_file_node(helper, file_info->file_no);
 
-    DS_LL_TOTAL_TIME += (get_time_usec() - start);
-    //node not found.
-    return -1;
+    return 0;
 }
 
 //This function makes up a fake upper layer obj used as a parameter in _obj_wrap_under(..., H5VL_provenance_t* upper_o,... ),
@@ -1452,34 +2876,8 @@ H5VL_provenance_t * _obj_wrap_under(void *under, H5VL_provenance_t *upper_o,
         H5O_token_t token;
         unsigned long file_no;
 
-        //open from types
-        switch(upper_o->my_type) {
-            case H5I_DATASET:
-            case H5I_GROUP:
-            case H5I_DATATYPE:
-            case H5I_ATTR:
-                file_info = ((object_prov_info_t *)(upper_o->generic_prov_info))->file_info;
-                break;
-
-            case H5I_FILE:
-                file_info = (file_prov_info_t*)upper_o->generic_prov_info;
-                break;
-
-            case H5I_UNINIT:
-            case H5I_BADID:
-            case H5I_DATASPACE:
-            case H5I_VFL:
-            case H5I_VOL:
-            case H5I_GENPROP_CLS:
-            case H5I_GENPROP_LST:
-            case H5I_ERROR_CLASS:
-            case H5I_ERROR_MSG:
-            case H5I_ERROR_STACK:
-            case H5I_NTYPES:
-            default:
-                file_info = NULL;  // Error
-                break;
-        }
+        //open from types, upper_o may be bare
+        file_info = obj_file_info(upper_o);
         assert(file_info);
 
         obj = H5VL_provenance_new_obj(under, upper_o->under_vol_id, upper_o->prov_helper);
@@ -1494,6 +2892,8 @@ H5VL_provenance_t * _obj_wrap_under(void *under, H5VL_provenance_t *upper_o,
             assert(target_obj_type == H5I_DATASET || target_obj_type == H5I_GROUP ||
                     target_obj_type == H5I_DATATYPE || target_obj_type == H5I_ATTR);
 
+            // Token bytes the connector leaves unset must not change its hash
+            memset(&oinfo, 0, sizeof(oinfo));
             get_native_info(under, target_obj_type, upper_o->under_vol_id,
                             dxpl_id, &oinfo);
             token = oinfo.token;
@@ -1513,6 +2913,8 @@ H5VL_provenance_t * _obj_wrap_under(void *under, H5VL_provenance_t *upper_o,
             case H5I_GROUP:
                 obj->generic_prov_info = add_grp_node(file_info, obj, target_obj_name, token);
                 obj->my_type = H5I_GROUP;
+
+                file_info->grp_accessed++;
                 break;
 
             case H5I_FILE: //newly added. if target_obj_name == NULL: it's a fake upper_o
@@ -1523,12 +2925,28 @@ H5VL_provenance_t * _obj_wrap_under(void *under, H5VL_provenance_t *upper_o,
             case H5I_DATATYPE:
                 obj->generic_prov_info = add_dtype_node(file_info, obj, target_obj_name, token);
                 obj->my_type = H5I_DATATYPE;
+
+                file_info->dtypes_accessed++;
                 break;
 
-            case H5I_ATTR:
+            case H5I_ATTR: {
+                char *attr_name = NULL;
+
+                // Opened by index, look the name up to tell it from its siblings
+                if(NULL == target_obj_name) {
+                    ssize_t size_ret = attr_get_name(under, upper_o->under_vol_id, dxpl_id, 0, NULL);
+
+                    if(size_ret > 0 && (attr_name = (char *)malloc((size_t)size_ret + 1))) {
+                        if(attr_get_name(under, upper_o->under_vol_id, dxpl_id,
+                                (size_t)size_ret + 1, attr_name) >= 0)
+                            target_obj_name = attr_name;
+                    }
+                }
                 obj->generic_prov_info = add_attr_node(file_info, obj, target_obj_name, token);
                 obj->my_type = H5I_ATTR;
+                free(attr_name);
                 break;
+            }
 
             case H5I_UNINIT:
             case H5I_BADID:
@@ -1551,6 +2969,28 @@ H5VL_provenance_t * _obj_wrap_under(void *under, H5VL_provenance_t *upper_o,
     return obj;
 }
 
+/* Wrap an attribute or dataset of a class with provenance off: no prov
+ * info, so no token or name lookups. The object holds a reference on its
+ * file's info for the wrap contexts and objects opened through it, see
+ * obj_file_info(). */
+static H5VL_provenance_t *obj_wrap_bare(void *under, H5VL_provenance_t *upper_o,
+        H5I_type_t type, void **req)
+{
+    H5VL_provenance_t *obj = H5VL_provenance_new_obj(under, upper_o->under_vol_id,
+        upper_o->prov_helper);
+
+    if(req && *req)
+        *req = H5VL_provenance_new_obj(*req, upper_o->under_vol_id, upper_o->prov_helper);
+
+    obj->my_type = type;
+    obj->bare_file = obj_file_info(upper_o);
+    assert(obj->bare_file);
+    obj->bare_file->ref_cnt++;
+    if(type == H5I_DATASET)
+        file_ds_accessed(obj->bare_file);
+    return obj;
+}
+
 void ptr_cnt_increment(prov_helper_t* helper){
     assert(helper);
 
@@ -1742,130 +3182,49 @@ static ssize_t attr_get_name(void *under_obj, hid_t under_vol_id, hid_t dxpl_id,
     return (ssize_t)attr_name_len;
 }
 
-//shorten function id: use hash value
-static char* FUNC_DIC[STAT_FUNC_MOD];
-
-void _dic_init(void){
-    for(int i = 0; i < STAT_FUNC_MOD; i++){
-        FUNC_DIC[i] = NULL;
-    }
-}
-
-unsigned int genHash(const char *msg) {
-    unsigned long hash = 0;
-    unsigned long c;
-    unsigned int func_index;
-    const char* tmp = msg;
-
-    while (0 != (c = (unsigned long)(*msg++))) {//SDBM hash
-        hash = c + (hash << 6) + (hash << 16) - hash;
-    }
-
-    msg = tmp;//restore string head address
-    func_index = (unsigned int)(hash % STAT_FUNC_MOD);
-    if(!FUNC_DIC[func_index]) {
-        FUNC_DIC[func_index] = strdup(msg);
-        //printf("received msg = %s, hash index = %d, result msg = %s\n", msg, func_index, FUNC_DIC[func_index]);
-    }
-
-    return func_index;
-}
+/* Name recorded for I/O on an object: its path in the file, or the
+ * attribute name for attributes. Looked up once per open object and cached
+ * in its prov info until the file's links change; the last known name is
+ * kept if the object has none any more (deleted link), "" if there never
+ * was one. */
+static const char *obj_prov_name(H5VL_provenance_t *obj)
+{
+    object_prov_info_t *info;
+    H5VL_loc_params_t loc_params;
+    ssize_t len;
+    char *path;
 
-void _dic_free(void){
-    for(int i = 0; i < STAT_FUNC_MOD; i++){
-        if(FUNC_DIC[i]){
-            free(FUNC_DIC[i]);
-        }
-    }
-}
+    if(!obj || !obj->generic_prov_info || obj->my_type == H5I_FILE)
+        return "";
+    info = (object_prov_info_t *)obj->generic_prov_info;
+    if(info->path && (!info->file_info || info->path_gen == info->file_info->name_gen))
+        return info->path;
+    if(info->file_info)
+        info->path_gen = info->file_info->name_gen;
 
-void _dic_print(void){
-    for(int i = 0; i < STAT_FUNC_MOD; i++){
-        if(FUNC_DIC[i]){
-            printf("%d %s\n", i, FUNC_DIC[i]);
-        }
-    }
-}
-void _preset_dic_print(void){
-    const char* preset_dic[] = {
-            "H5VL_provenance_init",                         /* initialize   */
-            "H5VL_provenance_term",                         /* terminate    */
-            "H5VL_provenance_info_copy",                /* info copy    */
-            "H5VL_provenance_info_cmp",                 /* info compare */
-            "H5VL_provenance_info_free",                /* info free    */
-            "H5VL_provenance_info_to_str",              /* info to str  */
-            "H5VL_provenance_str_to_info",              /* str to info  */
-            "H5VL_provenance_get_object",               /* get_object   */
-            "H5VL_provenance_get_wrap_ctx",             /* get_wrap_ctx */
-            "H5VL_provenance_wrap_object",              /* wrap_object  */
-            "H5VL_provenance_unwrap_object",            /* unwrap_object  */
-            "H5VL_provenance_free_wrap_ctx",            /* free_wrap_ctx */
-            "H5VL_provenance_attr_create",                       /* create */
-            "H5VL_provenance_attr_open",                         /* open */
-            "H5VL_provenance_attr_read",                         /* read */
-            "H5VL_provenance_attr_write",                        /* write */
-            "H5VL_provenance_attr_get",                          /* get */
-            "H5VL_provenance_attr_specific",                     /* specific */
-            "H5VL_provenance_attr_optional",                     /* optional */
-            "H5VL_provenance_attr_close",                         /* close */
-            "H5VL_provenance_dataset_create",                    /* create */
-            "H5VL_provenance_dataset_open",                      /* open */
-            "H5VL_provenance_dataset_read",                      /* read */
-            "H5VL_provenance_dataset_write",                     /* write */
-            "H5VL_provenance_dataset_get",                       /* get */
-            "H5VL_provenance_dataset_specific",                  /* specific */
-            "H5VL_provenance_dataset_optional",                  /* optional */
-            "H5VL_provenance_dataset_close",                      /* close */
-            "H5VL_provenance_datatype_commit",                   /* commit */
-            "H5VL_provenance_datatype_open",                     /* open */
-            "H5VL_provenance_datatype_get",                      /* get_size */
-            "H5VL_provenance_datatype_specific",                 /* specific */
-            "H5VL_provenance_datatype_optional",                 /* optional */
-            "H5VL_provenance_datatype_close",                     /* close */
-            "H5VL_provenance_file_create",                       /* create */
-            "H5VL_provenance_file_open",                         /* open */
-            "H5VL_provenance_file_get",                          /* get */
-            "H5VL_provenance_file_specific",                     /* specific */
-            "H5VL_provenance_file_optional",                     /* optional */
-            "H5VL_provenance_file_close",                         /* close */
-            "H5VL_provenance_group_create",                      /* create */
-            "H5VL_provenance_group_open",                        /* open */
-            "H5VL_provenance_group_get",                         /* get */
-            "H5VL_provenance_group_specific",                    /* specific */
-            "H5VL_provenance_group_optional",                    /* optional */
-            "H5VL_provenance_group_close",                        /* close */
-            "H5VL_provenance_link_create",                       /* create */
-            "H5VL_provenance_link_copy",                         /* copy */
-            "H5VL_provenance_link_move",                         /* move */
-            "H5VL_provenance_link_get",                          /* get */
-            "H5VL_provenance_link_specific",                     /* specific */
-            "H5VL_provenance_link_optional",                     /* optional */
-            "H5VL_provenance_object_open",                       /* open */
-            "H5VL_provenance_object_copy",                       /* copy */
-            "H5VL_provenance_object_get",                        /* get */
-            "H5VL_provenance_object_specific",                   /* specific */
-            "H5VL_provenance_object_optional",                   /* optional */
-            "H5VL_provenance_request_wait",                      /* wait */
-            "H5VL_provenance_request_notify",
-            "H5VL_provenance_request_cancel",
-            "H5VL_provenance_request_specific",
-            "H5VL_provenance_request_optional",
-            "H5VL_provenance_request_free",
-    };
-    int size = sizeof(preset_dic) / sizeof(const char*);
-    int key_space[1000];
-
-    for(int i = 0; i < 1000; i++){
-        key_space[i] = -1;
-    }
-
-    for(int i = 0; i < size; i++){
-        printf("%d %s\n", genHash(preset_dic[i]), preset_dic[i]);
-        if(key_space[genHash(preset_dic[i])] == -1){
-            key_space[genHash(preset_dic[i])] = (int)genHash(preset_dic[i]);
-        }else
-            printf("Collision found: key = %d, hash index = %d\n", key_space[genHash(preset_dic[i])], genHash(preset_dic[i]));
+    loc_params.type     = H5VL_OBJECT_BY_SELF;
+    loc_params.obj_type = obj->my_type;
+    if(obj->my_type == H5I_ATTR)
+        len = attr_get_name(obj->under_object, obj->under_vol_id, H5P_DATASET_XFER_DEFAULT, 0, NULL);
+    else
+        len = object_get_name(obj->under_object, obj->under_vol_id, &loc_params,
+            H5P_DATASET_XFER_DEFAULT, 0, NULL);
+    if(len <= 0 || NULL == (path = (char *)malloc((size_t)len + 1)))
+        return summary_obj_name(info);
+
+    if(obj->my_type == H5I_ATTR)
+        len = attr_get_name(obj->under_object, obj->under_vol_id, H5P_DATASET_XFER_DEFAULT,
+            (size_t)len + 1, path);
+    else
+        len = object_get_name(obj->under_object, obj->under_vol_id, &loc_params,
+            H5P_DATASET_XFER_DEFAULT, (size_t)len + 1, path);
+    if(len <= 0) {
+        free(path);
+        return summary_obj_name(info);
     }
+    free(info->path);
+    info->path = path;
+    return info->path;
 }
 
 int prov_write(prov_helper_t* helper_in, const char* msg, unsigned long duration){
@@ -1919,14 +3278,164 @@ int prov_write(prov_helper_t* helper_in, const char* msg, unsigned long duration
     if(helper_in->prov_level == (File_only | File_and_print)){
         fputs(pline, helper_in->prov_file_handle);
     }
-//    unsigned tmp = PROV_WRITE_TOTAL_TIME;
-    PROV_WRITE_TOTAL_TIME += (get_time_usec() - start);
+//    unsigned tmp = vol_stat.PROV_WRITE_TOTAL_TIME;
+    vol_stat.PROV_WRITE_TOTAL_TIME += (get_time_usec() - start);
 
 
 
     return 0;
 }
 
+/* Provenance record of an operation an async VOL below still runs. It is
+ * kept with the request and added when the request completes, timed from
+ * the call to the completion. */
+typedef struct prov_pending_t {
+    char io_api[64];
+    char type[128];
+    char relation[128];
+    char *data_object;
+    char *file_name;
+    unsigned long io_bytes;
+    unsigned long start;            // Callback entered (us)
+    unsigned long issued;           // Control back to the application (us)
+    unsigned long end;              // Completion seen (us)
+    hbool_t failed;
+    struct prov_pending_t *next;    // On pending_done
+} prov_pending_t;
+
+/* Completion callbacks may run on the async VOL's threads, they only push
+ * onto pending_done. The records are added on the application's thread. */
+static prov_pending_t *pending_done = NULL;
+static int pending_in_flight = 0;
+static int pending_max_in_flight = 0;
+static stat_async_counts pending_stats;    // Handed to the stats at term
+
+typedef struct prov_notify_ctx_t {
+    H5VL_request_notify_t cb;       // Application's callback and context
+    void *ctx;
+    prov_pending_t *pending;
+} prov_notify_ctx_t;
+
+static void pending_free(prov_pending_t *p)
+{
+    pending_in_flight--;
+    free(p->data_object);
+    free(p->file_name);
+    free(p);
+}
+
+/* Record of a completed operation. Besides the record, the stats get the
+ * time the application waited for the call to return (issue), the time to
+ * the completion and the part of it that overlapped the application.
+ * Built in a copy of fields, a callback may be filling those. */
+static void pending_record(prov_pending_t *p)
+{
+    if(!p->failed) {
+        prov_fields rec = fields;
+
+        prov_fill_data_object(&rec, p->data_object, p->type);
+        prov_fill_file(&rec, p->file_name);
+        prov_fill_relation(&rec, p->relation);
+        prov_fill_io_bytes(&rec, p->io_bytes);
+        // Timestamp of the call, duration up to the completion
+        prov_fill_io_api(&rec, p->io_api, get_time_usec() - p->start);
+        rec.duration = p->end - p->start;
+        add_prov_record(&config, provio_helper, &rec);
+
+        pending_stats.ops++;
+        pending_stats.issue_us += p->issued - p->start;
+        pending_stats.complete_us += p->end - p->start;
+        pending_stats.overlap_us += p->end > p->issued ? p->end - p->issued : 0;
+    }
+    pending_free(p);
+}
+
+/* Records of the operations notify callbacks have seen complete, in
+ * order of completion */
+static void pending_drain(void)
+{
+    prov_pending_t *list, *ordered = NULL;
+
+    if(!__atomic_load_n(&pending_done, __ATOMIC_RELAXED))
+        return;
+    list = __atomic_exchange_n(&pending_done, NULL, __ATOMIC_ACQUIRE);
+    while(list) {
+        prov_pending_t *next = list->next;
+
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+    while(ordered) {
+        prov_pending_t *next = ordered->next;
+
+        pending_record(ordered);
+        ordered = next;
+    }
+}
+
+static herr_t pending_notify(void *ctx, H5VL_request_status_t status)
+{
+    prov_notify_ctx_t *notify = (prov_notify_ctx_t *)ctx;
+    H5VL_request_notify_t cb = notify->cb;
+    void *user_ctx = notify->ctx;
+    prov_pending_t *p = notify->pending;
+
+    p->end = get_time_usec();
+    p->failed = (status != H5VL_REQUEST_STATUS_SUCCEED);
+    p->next = __atomic_load_n(&pending_done, __ATOMIC_RELAXED);
+    while(!__atomic_compare_exchange_n(&pending_done, &p->next, p, true,
+            __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+    free(notify);
+    return cb(user_ctx, status);
+}
+
+/* The request completed (or was released untracked, the end is then an
+ * upper bound), add its record */
+static void request_pending_finish(H5VL_provenance_t *request, hbool_t succeeded)
+{
+    prov_pending_t *p = request->pending;
+
+    if(!p)
+        return;
+    request->pending = NULL;
+    p->end = get_time_usec();
+    p->failed = !succeeded;
+    pending_record(p);
+}
+
+/* Add the record in fields, or keep it with the request when the
+ * operation went to an async VOL below. Called after *req is wrapped. */
+static void prov_record_add(void **req, const char *io_api_async, unsigned long start)
+{
+    H5VL_provenance_t *request = (req && *req) ? (H5VL_provenance_t *)*req : NULL;
+    prov_pending_t *p;
+
+    pending_drain();
+    if(!request || NULL == (p = calloc(1, sizeof(prov_pending_t)))) {
+        add_prov_record(&config, provio_helper, &fields);
+        return;
+    }
+
+    snprintf(p->io_api, sizeof(p->io_api), "%s", io_api_async);
+    snprintf(p->type, sizeof(p->type), "%s", fields.type);
+    snprintf(p->relation, sizeof(p->relation), "%s", fields.relation);
+    p->data_object = strdup(fields.data_object);
+    p->file_name = strdup(fields.file_name);
+    p->io_bytes = fields.io_bytes;
+    p->start = start;
+    p->issued = get_time_usec();
+    request->pending = p;
+    if(++pending_in_flight > pending_max_in_flight)
+        pending_max_in_flight = pending_in_flight;
+
+    // Nothing recorded yet, keep file and bytes out of the next record
+    prov_fill_file(&fields, NULL);
+    prov_fill_io_bytes(&fields, 0);
+}
+
+
 /*-------------------------------------------------------------------------
  * Function:    H5VL__provenance_new_obj
  *
@@ -1949,13 +3458,13 @@ H5VL_provenance_new_obj(void *under_obj, hid_t under_vol_id, prov_helper_t* help
     assert(under_vol_id);
     assert(helper);
 
-    new_obj = (H5VL_provenance_t *)calloc(1, sizeof(H5VL_provenance_t));
+    new_obj = (H5VL_provenance_t *)prov_pool_alloc(PROV_POOL_OBJ);
     new_obj->under_object = under_obj;
     new_obj->under_vol_id = under_vol_id;
     new_obj->prov_helper = helper;
     ptr_cnt_increment(new_obj->prov_helper);
     H5Iinc_ref(new_obj->under_vol_id);
-    //TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
+    //vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
     return new_obj;
 } /* end H5VL__provenance_new_obj() */
 
@@ -1981,6 +3490,10 @@ H5VL_provenance_free_obj(H5VL_provenance_t *obj)
 
     assert(obj);
 
+    if(obj->pending)
+        pending_free(obj->pending);
+    if(obj->bare_file)
+        rm_file_node(PROV_HELPER, obj->bare_file->file_no);
     ptr_cnt_decrement(PROV_HELPER);
 
     err_id = H5Eget_current_stack();
@@ -1989,8 +3502,8 @@ H5VL_provenance_free_obj(H5VL_provenance_t *obj)
 
     H5Eset_current_stack(err_id);
 
-    free(obj);
-    //TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
+    prov_pool_free(PROV_POOL_OBJ, obj);
+    //vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
     return 0;
 } /* end H5VL__provenance_free_obj() */
 
@@ -2021,7 +3534,7 @@ H5VL_provenance_register(void)
     if(H5I_VOL != H5Iget_type(prov_connector_id_global))
         prov_connector_id_global = H5VLregister_connector(&H5VL_provenance_cls, H5P_DEFAULT);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
     return prov_connector_id_global;
 } /* end H5VL_provenance_register() */
 
@@ -2045,20 +3558,23 @@ H5VL_provenance_init(hid_t vipl_id)
 #ifdef ENABLE_PROVNC_LOGGING
     printf("------- PROVENANCE VOL INIT\n");
 #endif
-    TOTAL_PROV_OVERHEAD = 0;
-    TOTAL_NATIVE_H5_TIME = 0;
-    PROV_WRITE_TOTAL_TIME = 0;
-    FILE_LL_TOTAL_TIME = 0;
-    DS_LL_TOTAL_TIME = 0;
-    GRP_LL_TOTAL_TIME = 0;
-    DT_LL_TOTAL_TIME = 0;
-    ATTR_LL_TOTAL_TIME = 0;
+    vol_stat.TOTAL_PROV_OVERHEAD = 0;
+    vol_stat.TOTAL_NATIVE_H5_TIME = 0;
+    vol_stat.PROV_WRITE_TOTAL_TIME = 0;
+    vol_stat.FILE_LL_TOTAL_TIME = 0;
+    vol_stat.DS_LL_TOTAL_TIME = 0;
+    vol_stat.GRP_LL_TOTAL_TIME = 0;
+    vol_stat.DT_LL_TOTAL_TIME = 0;
+    vol_stat.ATTR_LL_TOTAL_TIME = 0;
 
     /* Shut compiler up about unused parameter */
     (void)vipl_id;
 
     /* PROV-IO instrument point */
     provio_init(&config, &fields);
+    prov_cb_enable_init(&config);
+    if(config.enable_embed_prov)
+        provio_set_record_hook(embed_record);
 
     return 0;
 } /* end H5VL_provenance_init() */
@@ -2084,9 +3600,15 @@ H5VL_provenance_term(void)
 #ifdef ENABLE_PROVNC_LOGGING
     printf("------- PROVENANCE VOL TERM\n");
 #endif
+    // Records of operations completed since the last callback
+    pending_drain();
+    pending_stats.max_in_flight = pending_max_in_flight;
+    stat_set_async(&pending_stats);
+
     // Release resources, etc.
     prov_helper_teardown(PROV_HELPER);
     PROV_HELPER = NULL;
+    prov_pool_key_delete();
 
     /* Reset VOL ID */
     prov_connector_id_global = H5I_INVALID_HID;
@@ -2135,7 +3657,7 @@ H5VL_provenance_info_copy(const void *_info)
         new_info->prov_line_format = strdup(info->prov_line_format);
     new_info->prov_level = info->prov_level;
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
     return new_info;
 } /* end H5VL_provenance_info_copy() */
 
@@ -2173,36 +3695,36 @@ H5VL_provenance_info_cmp(int *cmp_value, const void *_info1, const void *_info2)
     /* Compare under VOL connector classes */
     H5VLcmp_connector_cls(cmp_value, info1->under_vol_id, info2->under_vol_id);
     if(*cmp_value != 0){
-        TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
+        vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
         return 0;
     }
 
     /* Compare under VOL connector info objects */
     H5VLcmp_connector_info(cmp_value, info1->under_vol_id, info1->under_vol_info, info2->under_vol_info);
     if(*cmp_value != 0){
-        TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
+        vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
         return 0;
     }
 
     *cmp_value = strcmp(info1->prov_file_path, info2->prov_file_path);
     if(*cmp_value != 0){
-        TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
+        vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
         return 0;
     }
 
     *cmp_value = strcmp(info1->prov_line_format, info2->prov_line_format);
     if(*cmp_value != 0){
-        TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
+        vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
         return 0;
     }
 
     *cmp_value = (int)info1->prov_level - (int)info2->prov_level;
     if(*cmp_value != 0){
-        TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
+        vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
         return 0;
     }
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
 
     return 0;
 } /* end H5VL_provenance_info_cmp() */
@@ -2245,7 +3767,7 @@ H5VL_provenance_info_free(void *_info)
     free(info->prov_line_format);
     free(info);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
     return 0;
 } /* end H5VL_provenance_info_free() */
 
@@ -2451,13 +3973,13 @@ H5VL_provenance_get_wrap_ctx(const void *obj, void **wrap_ctx)
     assert(o->my_type != 0);
 
     /* Allocate new VOL object wrapping context for the PROVENANCE connector */
-    new_wrap_ctx = (H5VL_provenance_wrap_ctx_t *)calloc(1, sizeof(H5VL_provenance_wrap_ctx_t));
+    new_wrap_ctx = (H5VL_provenance_wrap_ctx_t *)prov_pool_alloc(PROV_POOL_WRAP_CTX);
     switch(o->my_type){
         case H5I_DATASET:
         case H5I_GROUP:
         case H5I_DATATYPE:
         case H5I_ATTR:
-            new_wrap_ctx->file_info = ((object_prov_info_t *)(o->generic_prov_info))->file_info;
+            new_wrap_ctx->file_info = obj_file_info(o);
             break;
 
         case H5I_FILE:
@@ -2494,7 +4016,7 @@ H5VL_provenance_get_wrap_ctx(const void *obj, void **wrap_ctx)
     /* Set wrap context to return */
     *wrap_ctx = new_wrap_ctx;
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return 0;
 } /* end H5VL_provenance_get_wrap_ctx() */
 
@@ -2542,7 +4064,7 @@ H5VL_provenance_wrap_object(void *under_under_in, H5I_type_t obj_type, void *_wr
     else
         new_obj = NULL;
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return (void*)new_obj;
 } /* end H5VL_provenance_wrap_object() */
 
@@ -2577,8 +4099,8 @@ H5VL_provenance_unwrap_object(void *obj)
     m2 = get_time_usec();
 
     if(under) {
-        // Free the class-specific info
-        switch(o->my_type) {
+        // Free the class-specific info, bare objects have none
+        switch(o->generic_prov_info ? o->my_type : H5I_BADID) {
             case H5I_DATASET:
                 rm_dataset_node(o->prov_helper, o->under_object, o->under_vol_id, (dataset_prov_info_t *)(o->generic_prov_info));
                 break;
@@ -2618,7 +4140,7 @@ H5VL_provenance_unwrap_object(void *obj)
         H5VL_provenance_free_obj(o);
     }
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return under;
 } /* end H5VL_provenance_unwrap_object() */
 
@@ -2658,9 +4180,9 @@ H5VL_provenance_free_wrap_ctx(void *_wrap_ctx)
     H5Eset_current_stack(err_id);
 
     /* Free PROVENANCE wrap context object itself */
-    free(wrap_ctx);
+    prov_pool_free(PROV_POOL_WRAP_CTX, wrap_ctx);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start);
     return 0;
 } /* end H5VL_provenance_free_wrap_ctx() */
 
@@ -2680,13 +4202,19 @@ H5VL_provenance_attr_create(void *obj, const H5VL_loc_params_t *loc_params,
     const char *name, hid_t type_id, hid_t space_id, hid_t acpl_id,
     hid_t aapl_id, hid_t dxpl_id, void **req)
 {
-    unsigned long start = get_time_usec();
+    unsigned long start;
     unsigned long m1, m2;
 
     H5VL_provenance_t *attr;
     H5VL_provenance_t *o = (H5VL_provenance_t *)obj;
     void *under;
 
+    if(PROV_ATTR_BARE()) {
+        under = H5VLattr_create(o->under_object, loc_params, o->under_vol_id, name, type_id, space_id, acpl_id, aapl_id, dxpl_id, req);
+        return under ? (void *)obj_wrap_bare(under, o, H5I_ATTR, req) : NULL;
+    }
+    start = get_time_usec();
+
 #ifdef ENABLE_PROVNC_LOGGING
     printf("------- PROVENANCE VOL ATTRIBUTE Create\n");
 #endif
@@ -2703,19 +4231,22 @@ H5VL_provenance_attr_create(void *obj, const H5VL_loc_params_t *loc_params,
     if(o) 
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
 
     /* PROV-IO instrument start */
-    const char* io_api = "H5Acreate2";
-    const char* io_api_async = "H5Acreate_async";
-    const char* relation = "prov:wasGeneratedBy";
-    const char* type = "provio:Attr";
-    prov_fill_data_object(&fields, name, type);
-    prov_fill_relation(&fields, relation);
-    prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
-    prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    if(PROV_CB_ENABLED(attr_create)) {
+        const char* io_api = "H5Acreate2";
+        const char* io_api_async = "H5Acreate_async";
+        const char* relation = "prov:wasGeneratedBy";
+        const char* type = "provio:Attr";
+        prov_fill_data_object(&fields, name, type);
+        prov_fill_file(&fields, obj_file_name(o));
+        prov_fill_relation(&fields, relation);
+        prov_fill_io_api(&fields, io_api, get_time_usec() - start);
+        prov_record_add(req, io_api_async, start);
+        func_stat_id(PROV_CB_attr_create, m2 - m1, get_time_usec() - start - (m2 - m1));
+        prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    }
     /* PROV-IO instrument end */   
 
     return (void*)attr;
@@ -2736,13 +4267,19 @@ static void *
 H5VL_provenance_attr_open(void *obj, const H5VL_loc_params_t *loc_params,
     const char *name, hid_t aapl_id, hid_t dxpl_id, void **req)
 {
-    unsigned long start = get_time_usec();
+    unsigned long start;
     unsigned long m1, m2;
 
     H5VL_provenance_t *attr;
     H5VL_provenance_t *o = (H5VL_provenance_t *)obj;
     void *under;
 
+    if(PROV_ATTR_BARE()) {
+        under = H5VLattr_open(o->under_object, loc_params, o->under_vol_id, name, aapl_id, dxpl_id, req);
+        return under ? (void *)obj_wrap_bare(under, o, H5I_ATTR, req) : NULL;
+    }
+    start = get_time_usec();
+
 #ifdef ENABLE_PROVNC_LOGGING
     printf("------- PROVENANCE VOL ATTRIBUTE Open\n");
 #endif
@@ -2751,47 +4288,30 @@ H5VL_provenance_attr_open(void *obj, const H5VL_loc_params_t *loc_params,
     under = H5VLattr_open(o->under_object, loc_params, o->under_vol_id, name, aapl_id, dxpl_id, req);
     m2 = get_time_usec();
 
-    if(under) {
-        char *attr_name = NULL;
-
-        if(NULL == name) {
-            ssize_t size_ret = 0;
-
-            size_ret = attr_get_name(under, o->under_vol_id, dxpl_id, 0, NULL);
-            if(size_ret > 0) {
-                size_t buf_len = (size_t)(size_ret + 1);
-
-                attr_name = (char *)malloc(buf_len);
-                size_ret = attr_get_name(under, o->under_vol_id, dxpl_id, buf_len, attr_name);
-                if(size_ret >= 0)
-                    name = attr_name;
-            }
-        }
-
+    if(under)
         attr = _obj_wrap_under(under, o, name, H5I_ATTR, dxpl_id, req);
-
-        if(attr_name)
-            free(attr_name);
-    }
     else
         attr = NULL;
 
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
 
     /* PROV-IO instrument start */
-    const char* io_api = "H5Aopen";
-    const char* io_api_async = "H5Aopen_async";
-    const char* relation = "provio:wasOpenedBy";
-    const char* type = "provio:Attr";
-    prov_fill_data_object(&fields, name, type);
-    prov_fill_relation(&fields, relation);
-    prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
-    prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    if(PROV_CB_ENABLED(attr_open)) {
+        const char* io_api = "H5Aopen";
+        const char* io_api_async = "H5Aopen_async";
+        const char* relation = "provio:wasOpenedBy";
+        const char* type = "provio:Attr";
+        prov_fill_data_object(&fields, attr ? obj_prov_name(attr) : name, type);
+        prov_fill_file(&fields, obj_file_name(o));
+        prov_fill_relation(&fields, relation);
+        prov_fill_io_api(&fields, io_api, get_time_usec() - start);
+        prov_record_add(req, io_api_async, start);
+        func_stat_id(PROV_CB_attr_open, m2 - m1, get_time_usec() - start - (m2 - m1));
+        prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    }
     /* PROV-IO instrument end */  
 
     return (void *)attr;
@@ -2812,12 +4332,20 @@ static herr_t
 H5VL_provenance_attr_read(void *attr, hid_t mem_type_id, void *buf,
     hid_t dxpl_id, void **req)
 {
-    unsigned long start = get_time_usec();
+    unsigned long start;
     unsigned long m1, m2;
 
     H5VL_provenance_t *o = (H5VL_provenance_t *)attr;
     herr_t ret_value;
 
+    if(!PROV_CB_ENABLED(attr_read)) {
+        ret_value = H5VLattr_read(o->under_object, o->under_vol_id, mem_type_id, buf, dxpl_id, req);
+        if(req && *req)
+            *req = H5VL_provenance_new_obj(*req, o->under_vol_id, o->prov_helper);
+        return ret_value;
+    }
+    start = get_time_usec();
+
 #ifdef ENABLE_PROVNC_LOGGING
     printf("------- PROVENANCE VOL ATTRIBUTE Read\n");
 #endif
@@ -2833,30 +4361,19 @@ H5VL_provenance_attr_read(void *attr, hid_t mem_type_id, void *buf,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
 
     /* PROV-IO instrument start */
-    char* name = NULL;
-    char *attr_name = NULL;
-    ssize_t size_ret = 0;
     const char* io_api = "H5Aread";
     const char* io_api_async = "H5Aread_async";
     const char* relation = "provio:wasReadBy";
     const char* type = "provio:Attr";
-    size_ret = attr_get_name(o->under_object, o->under_vol_id, dxpl_id, 0, NULL);
-    if(size_ret > 0) {
-        size_t buf_len = (size_t)(size_ret + 1);
-
-        attr_name = (char *)malloc(buf_len);
-        size_ret = attr_get_name(o->under_object, o->under_vol_id, dxpl_id, buf_len, attr_name);
-        if(size_ret >= 0)
-            name = attr_name;
-    }
-    prov_fill_data_object(&fields, name, type);
+    prov_fill_data_object(&fields, obj_prov_name(o), type);
+    prov_fill_file(&fields, obj_file_name(o));
     prov_fill_relation(&fields, relation);
     prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
+    prov_record_add(req, io_api_async, start);
+    func_stat_id(PROV_CB_attr_read, m2 - m1, get_time_usec() - start - (m2 - m1));
     prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     /* PROV-IO instrument end */  
 
@@ -2878,12 +4395,20 @@ static herr_t
 H5VL_provenance_attr_write(void *attr, hid_t mem_type_id, const void *buf,
     hid_t dxpl_id, void **req)
 {
-    unsigned long start = get_time_usec();
+    unsigned long start;
     unsigned long m1, m2;
 
     H5VL_provenance_t *o = (H5VL_provenance_t *)attr;
     herr_t ret_value;
 
+    if(!PROV_CB_ENABLED(attr_write)) {
+        ret_value = H5VLattr_write(o->under_object, o->under_vol_id, mem_type_id, buf, dxpl_id, req);
+        if(req && *req)
+            *req = H5VL_provenance_new_obj(*req, o->under_vol_id, o->prov_helper);
+        return ret_value;
+    }
+    start = get_time_usec();
+
 #ifdef ENABLE_PROVNC_LOGGING
     printf("------- PROVENANCE VOL ATTRIBUTE Write\n");
 #endif
@@ -2899,30 +4424,19 @@ H5VL_provenance_attr_write(void *attr, hid_t mem_type_id, const void *buf,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
 
     /* PROV-IO instrument start */
-    char* name = NULL;
-    char *attr_name = NULL;
-    ssize_t size_ret = 0;
     const char* io_api = "H5Awrite";
     const char* io_api_async = "H5Awrite_async";
     const char* relation = "provio:wasWrittenBy";
     const char* type = "provio:Attr";
-    size_ret = attr_get_name(o->under_object, o->under_vol_id, dxpl_id, 0, NULL);
-    if(size_ret > 0) {
-        size_t buf_len = (size_t)(size_ret + 1);
-
-        attr_name = (char *)malloc(buf_len);
-        size_ret = attr_get_name(o->under_object, o->under_vol_id, dxpl_id, buf_len, attr_name);
-        if(size_ret >= 0)
-            name = attr_name;
-    }
-    prov_fill_data_object(&fields, name, type);
+    prov_fill_data_object(&fields, obj_prov_name(o), type);
+    prov_fill_file(&fields, obj_file_name(o));
     prov_fill_relation(&fields, relation);
     prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
+    prov_record_add(req, io_api_async, start);
+    func_stat_id(PROV_CB_attr_write, m2 - m1, get_time_usec() - start - (m2 - m1));
     prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     /* PROV-IO instrument end */  
 
@@ -2965,7 +4479,7 @@ H5VL_provenance_attr_get(void *obj, H5VL_attr_get_args_t *args, hid_t dxpl_id,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_attr_get() */
 
@@ -2998,6 +4512,9 @@ H5VL_provenance_attr_specific(void *obj, const H5VL_loc_params_t *loc_params,
     ret_value = H5VLattr_specific(o->under_object, loc_params, o->under_vol_id, args, dxpl_id, req);
     m2 = get_time_usec();
 
+    if(ret_value >= 0 && args->op_type == H5VL_ATTR_RENAME)
+        obj_names_changed(o);
+
     /* Check for async request */
     if(req && *req)
         *req = H5VL_provenance_new_obj(*req, o->under_vol_id, o->prov_helper);
@@ -3005,7 +4522,7 @@ H5VL_provenance_attr_specific(void *obj, const H5VL_loc_params_t *loc_params,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_attr_specific() */
 
@@ -3044,7 +4561,7 @@ H5VL_provenance_attr_optional(void *obj, H5VL_optional_args_t *args, hid_t dxpl_
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_attr_optional() */
 
@@ -3062,12 +4579,22 @@ H5VL_provenance_attr_optional(void *obj, H5VL_optional_args_t *args, hid_t dxpl_
 static herr_t
 H5VL_provenance_attr_close(void *attr, hid_t dxpl_id, void **req)
 {
-    unsigned long start = get_time_usec();
+    unsigned long start;
     unsigned long m1, m2;
 
     H5VL_provenance_t *o = (H5VL_provenance_t *)attr;
     herr_t ret_value;
 
+    if(!o->generic_prov_info) {
+        ret_value = H5VLattr_close(o->under_object, o->under_vol_id, dxpl_id, req);
+        if(req && *req)
+            *req = H5VL_provenance_new_obj(*req, o->under_vol_id, o->prov_helper);
+        if(ret_value >= 0)
+            H5VL_provenance_free_obj(o);
+        return ret_value;
+    }
+    start = get_time_usec();
+
 #ifdef ENABLE_PROVNC_LOGGING
     printf("------- PROVENANCE VOL ATTRIBUTE Close\n");
 #endif
@@ -3096,7 +4623,7 @@ H5VL_provenance_attr_close(void *attr, hid_t dxpl_id, void **req)
         H5VL_provenance_free_obj(o);
     }
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_attr_close() */
 
@@ -3116,13 +4643,23 @@ H5VL_provenance_dataset_create(void *obj, const H5VL_loc_params_t *loc_params,
     const char *ds_name, hid_t lcpl_id, hid_t type_id, hid_t space_id,
     hid_t dcpl_id, hid_t dapl_id, hid_t dxpl_id, void **req)
 {
-    unsigned long start = get_time_usec();
+    unsigned long start;
     unsigned long m1, m2;
 
     H5VL_provenance_t *dset;
     H5VL_provenance_t *o = (H5VL_provenance_t *)obj;
     void *under;
 
+    if(PROV_DATASET_BARE()) {
+        under = H5VLdataset_create(o->under_object, loc_params, o->under_vol_id, ds_name, lcpl_id, type_id, space_id, dcpl_id,  dapl_id, dxpl_id, req);
+        if(!under)
+            return NULL;
+        dset = obj_wrap_bare(under, o, H5I_DATASET, req);
+        file_ds_created(dset->bare_file);
+        return (void *)dset;
+    }
+    start = get_time_usec();
+
 #ifdef ENABLE_PROVNC_LOGGING
     printf("------- PROVENANCE VOL DATASET Create\n");
 #endif
@@ -3136,24 +4673,30 @@ H5VL_provenance_dataset_create(void *obj, const H5VL_loc_params_t *loc_params,
     else
         dset = NULL;
 
+    if(dset)
+        file_ds_created(obj_file_info(dset));
+
     if(o) 
         ;
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
     /* PROV-IO instrument start */
-    const char* io_api = "H5Dcreate2";
-    const char* io_api_async = "H5Dcreate_async";
-    const char* relation = "prov:wasGeneratedBy";
-    const char* type = "provio:Dataset"; 
-    prov_fill_data_object(&fields, ds_name, type);
-    prov_fill_relation(&fields, relation);
-    prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
-    prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    if(PROV_CB_ENABLED(dataset_create)) {
+        const char* io_api = "H5Dcreate2";
+        const char* io_api_async = "H5Dcreate_async";
+        const char* relation = "prov:wasGeneratedBy";
+        const char* type = "provio:Dataset"; 
+        prov_fill_data_object(&fields, ds_name, type);
+        prov_fill_file(&fields, obj_file_name(o));
+        prov_fill_relation(&fields, relation);
+        prov_fill_io_api(&fields, io_api, get_time_usec() - start);
+        prov_record_add(req, io_api_async, start);
+        func_stat_id(PROV_CB_dataset_create, m2 - m1, get_time_usec() - start - (m2 - m1));
+        prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    }
     /* PROV-IO instrument end */
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return (void *)dset;
 } /* end H5VL_provenance_dataset_create() */
 
@@ -3172,13 +4715,19 @@ static void *
 H5VL_provenance_dataset_open(void *obj, const H5VL_loc_params_t *loc_params,
     const char *ds_name, hid_t dapl_id, hid_t dxpl_id, void **req)
 {
-    unsigned long start = get_time_usec();
+    unsigned long start;
     unsigned long m1, m2;
 
     void *under;
     H5VL_provenance_t *dset;
     H5VL_provenance_t *o = (H5VL_provenance_t *)obj;
 
+    if(PROV_DATASET_BARE()) {
+        under = H5VLdataset_open(o->under_object, loc_params, o->under_vol_id, ds_name, dapl_id, dxpl_id, req);
+        return under ? (void *)obj_wrap_bare(under, o, H5I_DATASET, req) : NULL;
+    }
+    start = get_time_usec();
+
 
 
 #ifdef ENABLE_PROVNC_LOGGING
@@ -3199,29 +4748,36 @@ H5VL_provenance_dataset_open(void *obj, const H5VL_loc_params_t *loc_params,
         // prov_write(dset->prov_helper, __func__, get_time_usec() - start);
 
     /* PROV-IO instrument start */
-    const char* io_api = "H5Dopen2";
-    const char* io_api_async = "H5Dopen_async";
-    const char* relation = "provio:wasOpenedBy";
-    const char* type = "provio:Dataset"; 
-    prov_fill_data_object(&fields, ds_name, type);
-    prov_fill_relation(&fields, relation);
-    char name[64];
-    object_get_name(o->under_object, o->under_vol_id, loc_params, H5P_DATASET_XFER_DEFAULT, 64, name);
-    prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
-    prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    if(PROV_CB_ENABLED(dataset_open)) {
+        const char* io_api = "H5Dopen2";
+        const char* io_api_async = "H5Dopen_async";
+        const char* relation = "provio:wasOpenedBy";
+        const char* type = "provio:Dataset"; 
+        prov_fill_data_object(&fields, ds_name, type);
+        prov_fill_file(&fields, obj_file_name(o));
+        prov_fill_relation(&fields, relation);
+        prov_fill_io_api(&fields, io_api, get_time_usec() - start);
+        prov_record_add(req, io_api_async, start);
+        func_stat_id(PROV_CB_dataset_open, m2 - m1, get_time_usec() - start - (m2 - m1));
+        prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    }
     /* PROV-IO instrument end */
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return (void *)dset;
 } /* end H5VL_provenance_dataset_open() */
 
 
 /*-------------------------------------------------------------------------
- * Function:    H5VL_provenance_dataset_read
+ * Function:    dataset_io
  *
- * Purpose:     Reads data elements from a dataset into a buffer.
+ * Purpose:     Reads or writes count datasets in one call of the
+ *              underlying connector. HDF5 1.13.3 and later (VOL class
+ *              version 3) pass arrays of datasets, H5Dread_multi and
+ *              H5Dwrite_multi among others; before, count is always 1.
+ *              A call on one dataset adds an H5Dread/H5Dwrite record, a
+ *              call on several one H5Dread_multi/H5Dwrite_multi record
+ *              with the bytes of every dataset.
  *
  * Return:      Success:    0
  *              Failure:    -1
@@ -3229,34 +4785,47 @@ H5VL_provenance_dataset_open(void *obj, const H5VL_loc_params_t *loc_params,
  *-------------------------------------------------------------------------
  */
 static herr_t
-H5VL_provenance_dataset_read(void *dset, hid_t mem_type_id, hid_t mem_space_id,
-    hid_t file_space_id, hid_t plist_id, void *buf, void **req)
+dataset_io(size_t count, void *dset[], hid_t mem_type_id[], hid_t mem_space_id[],
+    hid_t file_space_id[], hid_t plist_id, void *buf[], hbool_t write, void **req)
 {
-    unsigned long start = get_time_usec();
+    unsigned long start;
     unsigned long m1, m2;
+    stat_perf_sample perf[STAT_PERF_POINTS];
+    int cb = write ? PROV_CB_dataset_write : PROV_CB_dataset_read;
 
-    H5VL_provenance_t *o = (H5VL_provenance_t *)dset;
+    H5VL_provenance_t *o = (H5VL_provenance_t *)dset[0];
+    void *under_local, **under = &under_local;
+    prov_batch_item item_local, *items = &item_local;
 #ifdef H5_HAVE_PARALLEL
     H5FD_mpio_xfer_t xfer_mode = H5FD_MPIO_INDEPENDENT;
 #endif /* H5_HAVE_PARALLEL */
     herr_t ret_value;
 
-    /* PROV-IO instrument start */
-    const char* io_api = "H5Dread";
-    const char* io_api_async = "H5Dread_async";
-    const char* relation = "provio:wasReadBy";
-    const char* type = "provio:Dataset"; 
-    char name[64];
-    H5VL_loc_params_t loc_params; 
-    loc_params.type     = H5VL_OBJECT_BY_SELF;
-    loc_params.obj_type = H5I_DATASET;
-    object_get_name(o->under_object, o->under_vol_id, &loc_params, H5P_DATASET_XFER_DEFAULT, 64, name);
-    prov_fill_data_object(&fields, name, type);
-    prov_fill_relation(&fields, relation);
-    /* PROV-IO instrument end */
+    if(count > 1) {
+        under = malloc(count * sizeof(void *));
+        items = malloc(count * sizeof(prov_batch_item));
+        if(!under || !items) {
+            free(under);
+            free(items);
+            return -1;
+        }
+    }
+    for(size_t i = 0; i < count; i++)
+        under[i] = ((H5VL_provenance_t *)dset[i])->under_object;
+
+    if(!prov_cb_enabled[cb]) {
+        ret_value = under_dataset_io(count, under, o->under_vol_id, mem_type_id, mem_space_id,
+            file_space_id, plist_id, buf, write, req);
+        if(req && *req)
+            *req = H5VL_provenance_new_obj(*req, o->under_vol_id, o->prov_helper);
+        goto done;
+    }
+    start = get_time_usec();
+
+    stat_perf_read(&perf[STAT_PERF_ENTRY]);
 
 #ifdef ENABLE_PROVNC_LOGGING
-    printf("------- PROVENANCE VOL DATASET Read\n");
+    printf("------- PROVENANCE VOL DATASET %s\n", write ? "Write" : "Read");
 #endif
 
 #ifdef H5_HAVE_PARALLEL
@@ -3264,60 +4833,151 @@ H5VL_provenance_dataset_read(void *dset, hid_t mem_type_id, hid_t mem_space_id,
     H5Pget_dxpl_mpio(plist_id, &xfer_mode);
 #endif /* H5_HAVE_PARALLEL */
 
+    stat_perf_read(&perf[STAT_PERF_NATIVE_BEGIN]);
     m1 = get_time_usec();
-    ret_value = H5VLdataset_read(o->under_object, o->under_vol_id, mem_type_id, mem_space_id, file_space_id, plist_id, buf, req);
+    ret_value = under_dataset_io(count, under, o->under_vol_id, mem_type_id, mem_space_id,
+        file_space_id, plist_id, buf, write, req);
     m2 = get_time_usec();
+    stat_perf_read(&perf[STAT_PERF_NATIVE_END]);
 
     /* Check for async request */
     if(req && *req)
         *req = H5VL_provenance_new_obj(*req, o->under_vol_id, o->prov_helper);
 
-    if(ret_value >= 0) {
-        dataset_prov_info_t * dset_info = (dataset_prov_info_t*)o->generic_prov_info;
-        hsize_t r_size;
+    for(size_t i = 0; i < count; i++) {
+        H5VL_provenance_t *d = (H5VL_provenance_t *)dset[i];
+        dataset_prov_info_t *dset_info = (dataset_prov_info_t*)d->generic_prov_info;
+        hsize_t size = 0;
 
+        // Bare datasets have no counters, see obj_wrap_bare()
+        if(ret_value >= 0 && dset_info) {
 #ifdef H5_HAVE_PARALLEL
-        // Increment appropriate parallel I/O counters
-        if(xfer_mode == H5FD_MPIO_INDEPENDENT)
-            // Increment counter for independent reads
-            dset_info->ind_dataset_read_cnt++;
-        else {
-            H5D_mpio_actual_io_mode_t actual_io_mode;
-
-            // Increment counter for collective reads
-            dset_info->coll_dataset_read_cnt++;
+            // Increment appropriate parallel I/O counters
+            if(xfer_mode == H5FD_MPIO_INDEPENDENT) {
+                if(write)
+                    dset_info->ind_dataset_write_cnt++;
+                else
+                    dset_info->ind_dataset_read_cnt++;
+            }
+            else {
+                H5D_mpio_actual_io_mode_t actual_io_mode;
 
-            // Check for actually completing a collective I/O
-            H5Pget_mpio_actual_io_mode(plist_id, &actual_io_mode);
-            if(!actual_io_mode)
-                dset_info->broken_coll_dataset_read_cnt++;
-        } /* end else */
+                if(write)
+                    dset_info->coll_dataset_write_cnt++;
+                else
+                    dset_info->coll_dataset_read_cnt++;
+                if(config.enable_coll_skew)
+                    dataset_coll_op_record(dset_info, m1, m2);
+
+                // Check for actually completing a collective I/O
+                H5Pget_mpio_actual_io_mode(plist_id, &actual_io_mode);
+                if(!actual_io_mode) {
+                    if(write)
+                        dset_info->broken_coll_dataset_write_cnt++;
+                    else
+                        dset_info->broken_coll_dataset_read_cnt++;
+                }
+            } /* end else */
+            if(config.enable_dep_detect)
+                dataset_dep_record(dset_info, file_space_id[i], write ? DEP_WRITE : DEP_READ, m1, m2);
 #endif /* H5_HAVE_PARALLEL */
 
-        if(H5S_ALL == mem_space_id)
-            r_size = dset_info->dset_type_size * dset_info->dset_space_size;
-        else
-            r_size = dset_info->dset_type_size * (hsize_t)H5Sget_select_npoints(mem_space_id);
+            if(H5S_ALL == mem_space_id[i])
+                size = dset_info->dset_type_size * dset_info->dset_space_size;
+            else
+                size = dset_info->dset_type_size * (hsize_t)H5Sget_select_npoints(mem_space_id[i]);
 
-        dset_info->total_bytes_read += r_size;
-        dset_info->dataset_read_cnt++;
-        dset_info->total_read_time += (m2 - m1);
+            // The datasets of one call share its time evenly
+            if(write) {
+                dset_info->total_bytes_written += size;
+                dset_info->dataset_write_cnt++;
+                dset_info->total_write_time += (m2 - m1) / count;
+            }
+            else {
+                dset_info->total_bytes_read += size;
+                dset_info->dataset_read_cnt++;
+                dset_info->total_read_time += (m2 - m1) / count;
+            }
+        }
+        items[i].data_object = obj_prov_name(d);
+        items[i].file_name = obj_file_name(d);
+        items[i].io_bytes = size;
     }
 
     // prov_write(o->prov_helper, __func__, get_time_usec() - start);
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
 
     /* PROV-IO instrument start */
-    prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
+    const char* relation = write ? "provio:wasWrittenBy" : "provio:wasReadBy";
+    const char* type = "provio:Dataset";
+    prov_fill_data_object(&fields, items[0].data_object, type);
+    prov_fill_relation(&fields, relation);
+    if(count == 1) {
+        const char* io_api = write ? "H5Dwrite" : "H5Dread";
+        const char* io_api_async = write ? "H5Dwrite_async" : "H5Dread_async";
+
+        prov_fill_file(&fields, items[0].file_name);
+        prov_fill_io_bytes(&fields, items[0].io_bytes);
+        prov_fill_io_api(&fields, io_api, get_time_usec() - start);
+        if(config.enable_dataset_prov)
+            prov_record_add(req, io_api_async, start);
+        else {
+            // Counted for the summary only, keep file and bytes out of the next record
+            prov_fill_file(&fields, NULL);
+            prov_fill_io_bytes(&fields, 0);
+        }
+    }
+    else if(config.enable_dataset_prov) {
+        const char* io_api = write ? "H5Dwrite_multi" : "H5Dread_multi";
+
+        // One record for the whole call, also for async calls
+        prov_fill_io_api(&fields, io_api, get_time_usec() - start);
+        add_batch_record(&config, provio_helper, &fields, items, (int)count);
+    }
+    stat_perf_read(&perf[STAT_PERF_EXIT]);
+    func_stat_id(cb, m2 - m1, get_time_usec() - start - (m2 - m1));
+    stat_perf_record(cb, perf);
     prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     /* PROV-IO instrument end */
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+done:
+    if(count > 1) {
+        free(under);
+        free(items);
+    }
     return ret_value;
+} /* end dataset_io() */
+
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_provenance_dataset_read
+ *
+ * Purpose:     Reads data elements from a dataset into a buffer.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+#if H5VL_VERSION >= 3
+static herr_t
+H5VL_provenance_dataset_read(size_t count, void *dset[], hid_t mem_type_id[],
+    hid_t mem_space_id[], hid_t file_space_id[], hid_t plist_id, void *buf[], void **req)
+{
+    return dataset_io(count, dset, mem_type_id, mem_space_id, file_space_id, plist_id,
+        buf, false, req);
+} /* end H5VL_provenance_dataset_read() */
+#else
+static herr_t
+H5VL_provenance_dataset_read(void *dset, hid_t mem_type_id, hid_t mem_space_id,
+    hid_t file_space_id, hid_t plist_id, void *buf, void **req)
+{
+    return dataset_io(1, &dset, &mem_type_id, &mem_space_id, &file_space_id, plist_id,
+        &buf, false, req);
 } /* end H5VL_provenance_dataset_read() */
+#endif
+
 
-
 /*-------------------------------------------------------------------------
  * Function:    H5VL_provenance_dataset_write
  *
@@ -3328,96 +4988,25 @@ H5VL_provenance_dataset_read(void *dset, hid_t mem_type_id, hid_t mem_space_id,
  *
  *-------------------------------------------------------------------------
  */
+#if H5VL_VERSION >= 3
+static herr_t
+H5VL_provenance_dataset_write(size_t count, void *dset[], hid_t mem_type_id[],
+    hid_t mem_space_id[], hid_t file_space_id[], hid_t plist_id, const void *buf[], void **req)
+{
+    return dataset_io(count, dset, mem_type_id, mem_space_id, file_space_id, plist_id,
+        (void **)buf, true, req);
+} /* end H5VL_provenance_dataset_write() */
+#else
 static herr_t
 H5VL_provenance_dataset_write(void *dset, hid_t mem_type_id, hid_t mem_space_id,
     hid_t file_space_id, hid_t plist_id, const void *buf, void **req)
 {
-    unsigned long start = get_time_usec();
-    unsigned long m1, m2;
-//H5VL_provenance_t: A envelop
-    H5VL_provenance_t *o = (H5VL_provenance_t *)dset;
-#ifdef H5_HAVE_PARALLEL
-    H5FD_mpio_xfer_t xfer_mode = H5FD_MPIO_INDEPENDENT;
-#endif /* H5_HAVE_PARALLEL */
-    herr_t ret_value;
-
-    assert(dset);
-
-#ifdef ENABLE_PROVNC_LOGGING
-    printf("------- PROVENANCE VOL DATASET Write\n");
-#endif
-
-#ifdef H5_HAVE_PARALLEL
-    // Retrieve MPI-IO transfer option
-    H5Pget_dxpl_mpio(plist_id, &xfer_mode);
-#endif /* H5_HAVE_PARALLEL */
-
-//H5VLdataset_write: framework
-// VOL B do IO, so A ask B to write.    o->under_object is a B envelop.
-    // reuse A envelop
-    m1 = get_time_usec();
-    ret_value = H5VLdataset_write(o->under_object, o->under_vol_id, mem_type_id, mem_space_id, file_space_id, plist_id, buf, req);
-    m2 = get_time_usec();
-
-    /* Check for async request */
-    if(req && *req)
-        *req = H5VL_provenance_new_obj(*req, o->under_vol_id, o->prov_helper);
-
-    if(ret_value >= 0) {
-        dataset_prov_info_t * dset_info = (dataset_prov_info_t*)o->generic_prov_info;
-        hsize_t w_size;
-
-#ifdef H5_HAVE_PARALLEL
-        // Increment appropriate parallel I/O counters
-        if(xfer_mode == H5FD_MPIO_INDEPENDENT)
-            // Increment counter for independent writes
-            dset_info->ind_dataset_write_cnt++;
-        else {
-            H5D_mpio_actual_io_mode_t actual_io_mode;
-
-            // Increment counter for collective writes
-            dset_info->coll_dataset_write_cnt++;
-
-            // Check for actually completing a collective I/O
-            H5Pget_mpio_actual_io_mode(plist_id, &actual_io_mode);
-            if(!actual_io_mode)
-                dset_info->broken_coll_dataset_write_cnt++;
-        } /* end else */
-#endif /* H5_HAVE_PARALLEL */
-
-        if(H5S_ALL == mem_space_id)
-            w_size = dset_info->dset_type_size * dset_info->dset_space_size;
-        else
-            w_size = dset_info->dset_type_size * (hsize_t)H5Sget_select_npoints(mem_space_id);
-
-        dset_info->total_bytes_written += w_size;
-        dset_info->dataset_write_cnt++;
-        dset_info->total_write_time += (m2 - m1);
-    }
-
-    // prov_write(o->prov_helper, __func__, get_time_usec() - start);
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
-
-    /* PROV-IO instrument start */
-    const char* io_api = "H5Dwrite";
-    const char* io_api_async = "H5Dwrite_async";
-    const char* relation = "provio:wasWrittenBy";
-    const char* type = "provio:Dataset";  
-    char name[64];
-    H5VL_loc_params_t loc_params; 
-    loc_params.type     = H5VL_OBJECT_BY_SELF;
-    loc_params.obj_type = H5I_DATASET;
-    object_get_name(o->under_object, o->under_vol_id, &loc_params, H5P_DATASET_XFER_DEFAULT, 64, name);
-    prov_fill_data_object(&fields, name, type);
-    prov_fill_relation(&fields, relation);
-    prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
-    prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
-    /* PROV-IO instrument end */
+    void *bufs[1] = {(void *)buf};
 
-    return ret_value;
+    return dataset_io(1, &dset, &mem_type_id, &mem_space_id, &file_space_id, plist_id,
+        bufs, true, req);
 } /* end H5VL_provenance_dataset_write() */
+#endif
 
 
 /*-------------------------------------------------------------------------
@@ -3455,7 +5044,7 @@ H5VL_provenance_dataset_get(void *dset, H5VL_dataset_get_args_t *args,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_dataset_get() */
 
@@ -3481,7 +5070,7 @@ H5VL_provenance_dataset_specific(void *obj, H5VL_dataset_specific_args_t *args,
     void *under_obj = NULL;
     hid_t under_vol_id = -1;
     prov_helper_t *helper = NULL;
-    dataset_prov_info_t *my_dataset_info;
+    dataset_prov_info_t *my_dataset_info = NULL;
     herr_t ret_value;
 
 #ifdef ENABLE_PROVNC_LOGGING
@@ -3491,8 +5080,8 @@ H5VL_provenance_dataset_specific(void *obj, H5VL_dataset_specific_args_t *args,
     // Sanity check
     assert(o->my_type == H5I_DATASET);
 
-    // Check if refreshing
-    if(args->op_type == H5VL_DATASET_REFRESH) {
+    // Check if refreshing, bare datasets have no info to keep
+    if(args->op_type == H5VL_DATASET_REFRESH && o->generic_prov_info) {
         // Save dataset prov info for later, and increment the refcount on it,
         // so that the stats aren't lost when the object is closed and reopened
         // during the underlying refresh operation
@@ -3512,7 +5101,7 @@ H5VL_provenance_dataset_specific(void *obj, H5VL_dataset_specific_args_t *args,
 
     // Update dataset dimensions for 'set extent' operations
     if(args->op_type == H5VL_DATASET_SET_EXTENT) {
-        if(ret_value >= 0) {
+        if(ret_value >= 0 && o->generic_prov_info) {
             dataset_prov_info_t *ds_info;
 
             ds_info = (dataset_prov_info_t *)o->generic_prov_info;
@@ -3533,10 +5122,7 @@ H5VL_provenance_dataset_specific(void *obj, H5VL_dataset_specific_args_t *args,
         }
     }
     // Get new dataset info, after refresh
-    else if(args->op_type == H5VL_DATASET_REFRESH) {
-        // Sanity check
-        assert(my_dataset_info);
-
+    else if(args->op_type == H5VL_DATASET_REFRESH && my_dataset_info) {
         if(ret_value >= 0) {
             hid_t dataset_id;
             hid_t space_id;
@@ -3570,7 +5156,7 @@ H5VL_provenance_dataset_specific(void *obj, H5VL_dataset_specific_args_t *args,
 
     // prov_write(helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_dataset_specific() */
 
@@ -3610,7 +5196,7 @@ H5VL_provenance_dataset_optional(void *obj, H5VL_optional_args_t *args,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_dataset_optional() */
 
@@ -3628,12 +5214,22 @@ H5VL_provenance_dataset_optional(void *obj, H5VL_optional_args_t *args,
 static herr_t
 H5VL_provenance_dataset_close(void *dset, hid_t dxpl_id, void **req)
 {
-    unsigned long start = get_time_usec();
+    unsigned long start;
     unsigned long m1, m2;
 
     H5VL_provenance_t *o = (H5VL_provenance_t *)dset;
     herr_t ret_value;
 
+    if(!o->generic_prov_info) {
+        ret_value = H5VLdataset_close(o->under_object, o->under_vol_id, dxpl_id, req);
+        if(req && *req)
+            *req = H5VL_provenance_new_obj(*req, o->under_vol_id, o->prov_helper);
+        if(ret_value >= 0)
+            H5VL_provenance_free_obj(o);
+        return ret_value;
+    }
+    start = get_time_usec();
+
 #ifdef ENABLE_PROVNC_LOGGING
     printf("------- PROVENANCE VOL DATASET Close\n");
 #endif
@@ -3655,13 +5251,17 @@ H5VL_provenance_dataset_close(void *dset, hid_t dxpl_id, void **req)
 
         dataset_stats_prov_write(dset_info);//output stats
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
+#ifdef H5_HAVE_PARALLEL
+        if(config.enable_coll_skew && dset_info->obj_info.ref_cnt == 1)
+            dataset_coll_skew_reduce(dset_info);
+#endif /* H5_HAVE_PARALLEL */
 
         rm_dataset_node(o->prov_helper, o->under_object, o->under_vol_id, dset_info);
 
         H5VL_provenance_free_obj(o);
     }
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_dataset_close() */
 
@@ -3701,22 +5301,28 @@ H5VL_provenance_datatype_commit(void *obj, const H5VL_loc_params_t *loc_params,
     else
         dt = NULL;
 
+    if(dt)
+        file_dtype_created(obj_file_info(dt));
+
     if(dt)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
 
     /* PROV-IO instrument start */
-    const char* io_api = "H5Tcommit2";
-    const char* io_api_async = "H5Tcommit_async";
-    const char* relation = "prov:wasCommittedBy";
-    const char* type = "provio:Datatype";
-    prov_fill_data_object(&fields, name, type);
-    prov_fill_relation(&fields, relation);
-    prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
-    prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    if(PROV_CB_ENABLED(datatype_commit)) {
+        const char* io_api = "H5Tcommit2";
+        const char* io_api_async = "H5Tcommit_async";
+        const char* relation = "prov:wasCommittedBy";
+        const char* type = "provio:Datatype";
+        prov_fill_data_object(&fields, name, type);
+        prov_fill_file(&fields, obj_file_name(o));
+        prov_fill_relation(&fields, relation);
+        prov_fill_io_api(&fields, io_api, get_time_usec() - start);
+        prov_record_add(req, io_api_async, start);
+        func_stat_id(PROV_CB_datatype_commit, m2 - m1, get_time_usec() - start - (m2 - m1));
+        prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    }
     /* PROV-IO instrument end */
 
     return (void *)dt;
@@ -3760,19 +5366,22 @@ H5VL_provenance_datatype_open(void *obj, const H5VL_loc_params_t *loc_params,
     if(dt)
         // prov_write(dt->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
 
     /* PROV-IO instrument start */
-    const char* io_api = "H5Topen2";
-    const char* io_api_async = "H5Topen_async";
-    const char* relation = "provio:wasOpenedBy";
-    const char* type = "provio:Datatype";
-    prov_fill_data_object(&fields, name, type);
-    prov_fill_relation(&fields, relation);
-    prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
-    prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    if(PROV_CB_ENABLED(datatype_open)) {
+        const char* io_api = "H5Topen2";
+        const char* io_api_async = "H5Topen_async";
+        const char* relation = "provio:wasOpenedBy";
+        const char* type = "provio:Datatype";
+        prov_fill_data_object(&fields, name, type);
+        prov_fill_file(&fields, obj_file_name(o));
+        prov_fill_relation(&fields, relation);
+        prov_fill_io_api(&fields, io_api, get_time_usec() - start);
+        prov_record_add(req, io_api_async, start);
+        func_stat_id(PROV_CB_datatype_open, m2 - m1, get_time_usec() - start - (m2 - m1));
+        prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    }
     /* PROV-IO instrument end */
 
     return (void *)dt;
@@ -3814,7 +5423,7 @@ H5VL_provenance_datatype_get(void *dt, H5VL_datatype_get_args_t *args,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_datatype_get() */
 
@@ -3894,7 +5503,7 @@ H5VL_provenance_datatype_specific(void *obj, H5VL_datatype_specific_args_t *args
 
     // prov_write(helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_datatype_specific() */
 
@@ -3934,7 +5543,7 @@ H5VL_provenance_datatype_optional(void *obj, H5VL_optional_args_t *args,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_datatype_optional() */
 
@@ -3984,7 +5593,7 @@ H5VL_provenance_datatype_close(void *dt, hid_t dxpl_id, void **req)
         H5VL_provenance_free_obj(o);
     }
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_datatype_close() */
 
@@ -4052,6 +5661,7 @@ H5VL_provenance_file_create(const char *name, unsigned flags, hid_t fcpl_id,
             PROV_HELPER = prov_helper_init(info->prov_file_path, info->prov_level, info->prov_line_format);;
 
         file = _file_open_common(under, info->under_vol_id, name);
+        ((file_prov_info_t *)file->generic_prov_info)->writable = true;
 
 #ifdef H5_HAVE_PARALLEL
         if(have_mpi_comm_info) {
@@ -4080,85 +5690,27 @@ H5VL_provenance_file_create(const char *name, unsigned flags, hid_t fcpl_id,
 
 
     /* PROV-IO instrument start */
-    const char* io_api = "H5Topen2";
-    const char* io_api_async = "H5Topen_async";
-    const char* relation = "provio:wasOpenedBy";
-    const char* type = "provio:Datatype";
-    prov_fill_data_object(&fields, name, type);
-    prov_fill_relation(&fields, relation);
-    prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
-    prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
-
-    if (fields.mpi_rank_int == 0) {
-        // Create a Group for provenance validation in the H5 file
-        H5VL_loc_params_t loc_params; 
-        loc_params.type     = H5VL_OBJECT_BY_SELF;
-        loc_params.obj_type = H5I_FILE;
-
-        H5VL_provenance_t *group;
-
-        void *group_under = H5VLgroup_create(file->under_object, &loc_params, file->under_vol_id, "Provenance", 
-            H5P_LINK_CREATE_DEFAULT, H5P_GROUP_CREATE_DEFAULT, H5P_GROUP_ACCESS_DEFAULT, H5P_DATASET_XFER_DEFAULT, req);
-
-        if(group_under)
-            group = _obj_wrap_under(group_under, file, name, H5I_GROUP, dxpl_id, req);
-        else
-            group = NULL;
-        
-        // Add provenance file path to H5 file as a file attribute synchronously 
-        loc_params.type     = H5VL_OBJECT_BY_SELF;
-        loc_params.obj_type = H5I_GROUP;
-
-        H5VL_provenance_t *attr_path;
-
-        // hsize_t dims = MAX_NUM_PROV_FILE;
-        hsize_t dims = 1;
-        hid_t aspace = H5Screate_simple(1, &dims, NULL);
-        hid_t memtype = H5Tcopy (H5T_C_S1);
-
-        H5Tset_size (memtype, strlen(info->prov_file_path)+1);
-
-        void *attr_under = H5VLattr_create(group->under_object, &loc_params, group->under_vol_id, "Path",
-           memtype, aspace, H5P_ATTRIBUTE_CREATE_DEFAULT, H5P_ATTRIBUTE_ACCESS_DEFAULT, H5P_DATASET_XFER_DEFAULT, req);
-
-        // Wrap provenance path attribute
-        if(attr_under)
-           attr_path = _obj_wrap_under(attr_under, group, name, H5I_ATTR, dxpl_id, req);
-        else
-           attr_path = NULL;
-
-        // Write and close provenance path attribute
-        H5VLattr_write(attr_path->under_object, attr_path->under_vol_id, memtype,
-           info->prov_file_path, H5P_DATASET_XFER_DEFAULT, req);
-        H5VLattr_close(attr_path->under_object, attr_path->under_vol_id, H5P_DATASET_XFER_DEFAULT, req);
-        
-        H5VL_provenance_t *attr_time;
+    if(PROV_CB_ENABLED(file_create)) {
+        const char* io_api = "H5Fcreate";
+        const char* io_api_async = "H5Fcreate_async";
+        const char* relation = "prov:wasGeneratedBy";
+        const char* type = "provio:File";
+        prov_fill_data_object(&fields, name, type);
+        prov_fill_relation(&fields, relation);
+        prov_fill_io_api(&fields, io_api, get_time_usec() - start);
+        prov_record_add(req, io_api_async, start);
+        func_stat_id(PROV_CB_file_create, m2 - m1, get_time_usec() - start - (m2 - m1));
+        prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    }
 
-        attr_under = H5VLattr_create(group->under_object, &loc_params, group->under_vol_id, "Creation time",
-           memtype, aspace, H5P_ATTRIBUTE_CREATE_DEFAULT, H5P_ATTRIBUTE_ACCESS_DEFAULT, H5P_DATASET_XFER_DEFAULT, req);
+    // Written to the Provenance group later, see file_prov_meta_write()
+    if(file && info->prov_file_path) {
+        file_prov_info_t *file_info = file->generic_prov_info;
 
-        // Wrap provenance file creation time attribute
-        if(attr_under)
-           attr_time = _obj_wrap_under(attr_under, group, name, H5I_ATTR, dxpl_id, req);
-        else
-           attr_time = NULL;
-        
-        // Write and close provenance file creation time attribute
-        char time[64];
-        get_time_str(time);
-        H5VLattr_write(attr_time->under_object, attr_time->under_vol_id, memtype,
-           time, H5P_DATASET_XFER_DEFAULT, req);
-        H5VLattr_close(attr_time->under_object, attr_time->under_vol_id, H5P_DATASET_XFER_DEFAULT, req);
-
-        H5Sclose(aspace);
-        H5Tclose(memtype);
-        // Add provenance file path to H5 file as a file attribute synchronously
-
-        // Close group
-        H5VLgroup_close(group->under_object, group->under_vol_id, dxpl_id, req);
-        H5VL_provenance_free_obj(group);
+        if(!file_info->meta_path) {
+            file_info->meta_path = strdup(info->prov_file_path);
+            get_time_str(file_info->meta_created);
+        }
     }
     /* PROV-IO instrument end */
 
@@ -4180,7 +5732,7 @@ H5VL_provenance_file_create(const char *name, unsigned flags, hid_t fcpl_id,
     }
 #endif /* H5_HAVE_PARALLEL */
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
 
     return (void *)file;
 } /* end H5VL_provenance_file_create() */
@@ -4249,6 +5801,8 @@ H5VL_provenance_file_open(const char *name, unsigned flags, hid_t fapl_id,
         if(!PROV_HELPER)
             PROV_HELPER = prov_helper_init(info->prov_file_path, info->prov_level, info->prov_line_format);
         file = _file_open_common(under, info->under_vol_id, name);
+        if(flags & H5F_ACC_RDWR)
+            ((file_prov_info_t *)file->generic_prov_info)->writable = true;
 
 #ifdef H5_HAVE_PARALLEL
         if(have_mpi_comm_info) {
@@ -4276,85 +5830,25 @@ H5VL_provenance_file_open(const char *name, unsigned flags, hid_t fapl_id,
         // prov_write(file->prov_helper, __func__, get_time_usec() - start);
 
     /* PROV-IO instrument start */
-    const char* io_api = "H5Topen2";
-    const char* io_api_async = "H5Topen_async";
-    const char* relation = "provio:wasOpenedBy";
-    const char* type = "provio:Datatype";
-    prov_fill_data_object(&fields, name, type);
-    prov_fill_relation(&fields, relation);
-    prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
-    prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
-
-    if (fields.mpi_rank_int == 0) {
-        // Create a Group for provenance validation in the H5 file
-        H5VL_loc_params_t loc_params; 
-        loc_params.type     = H5VL_OBJECT_BY_SELF;
-        loc_params.obj_type = H5I_FILE;
-
-        H5VL_provenance_t *group;
-
-        void *group_under = H5VLgroup_create(file->under_object, &loc_params, file->under_vol_id, "Provenance", 
-            H5P_LINK_CREATE_DEFAULT, H5P_GROUP_CREATE_DEFAULT, H5P_GROUP_ACCESS_DEFAULT, H5P_DATASET_XFER_DEFAULT, req);
-
-        if(group_under)
-            group = _obj_wrap_under(group_under, file, name, H5I_GROUP, dxpl_id, req);
-        else
-            group = NULL;
-        
-        // Add provenance file path to H5 file as a file attribute synchronously 
-        loc_params.type     = H5VL_OBJECT_BY_SELF;
-        loc_params.obj_type = H5I_GROUP;
-
-        H5VL_provenance_t *attr_path;
-
-        // hsize_t dims = MAX_NUM_PROV_FILE;
-        hsize_t dims = 1;
-        hid_t aspace = H5Screate_simple(1, &dims, NULL);
-        hid_t memtype = H5Tcopy (H5T_C_S1);
-
-        H5Tset_size (memtype, strlen(info->prov_file_path)+1);
-
-        void *attr_under = H5VLattr_create(group->under_object, &loc_params, group->under_vol_id, "Path",
-           memtype, aspace, H5P_ATTRIBUTE_CREATE_DEFAULT, H5P_ATTRIBUTE_ACCESS_DEFAULT, H5P_DATASET_XFER_DEFAULT, req);
-
-        // Wrap provenance path attribute
-        if(attr_under)
-           attr_path = _obj_wrap_under(attr_under, group, name, H5I_ATTR, dxpl_id, req);
-        else
-           attr_path = NULL;
-
-        // Write and close provenance path attribute
-        H5VLattr_write(attr_path->under_object, attr_path->under_vol_id, memtype,
-           info->prov_file_path, H5P_DATASET_XFER_DEFAULT, req);
-        H5VLattr_close(attr_path->under_object, attr_path->under_vol_id, H5P_DATASET_XFER_DEFAULT, req);
-        
-        H5VL_provenance_t *attr_time;
+    if(PROV_CB_ENABLED(file_open)) {
+        const char* io_api = "H5Fopen";
+        const char* io_api_async = "H5Fopen_async";
+        const char* relation = "provio:wasOpenedBy";
+        const char* type = "provio:File";
+        prov_fill_data_object(&fields, name, type);
+        prov_fill_relation(&fields, relation);
+        prov_fill_io_api(&fields, io_api, get_time_usec() - start);
+        prov_record_add(req, io_api_async, start);
+        func_stat_id(PROV_CB_file_open, m2 - m1, get_time_usec() - start - (m2 - m1));
+        prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    }
 
-        attr_under = H5VLattr_create(group->under_object, &loc_params, group->under_vol_id, "Creation time",
-           memtype, aspace, H5P_ATTRIBUTE_CREATE_DEFAULT, H5P_ATTRIBUTE_ACCESS_DEFAULT, H5P_DATASET_XFER_DEFAULT, req);
+    // Written to the Provenance group later, see file_prov_meta_write()
+    if(file && info->prov_file_path) {
+        file_prov_info_t *file_info = file->generic_prov_info;
 
-        // Wrap provenance file creation time attribute
-        if(attr_under)
-           attr_time = _obj_wrap_under(attr_under, group, name, H5I_ATTR, dxpl_id, req);
-        else
-           attr_time = NULL;
-        
-        // Write and close provenance file creation time attribute
-        char time[64];
-        get_time_str(time);
-        H5VLattr_write(attr_time->under_object, attr_time->under_vol_id, memtype,
-           time, H5P_DATASET_XFER_DEFAULT, req);
-        H5VLattr_close(attr_time->under_object, attr_time->under_vol_id, H5P_DATASET_XFER_DEFAULT, req);
-
-        H5Sclose(aspace);
-        H5Tclose(memtype);
-        // Add provenance file path to H5 file as a file attribute synchronously
-
-        // Close group
-        H5VLgroup_close(group->under_object, group->under_vol_id, dxpl_id, req);
-        H5VL_provenance_free_obj(group);
+        if(file_info->writable && !file_info->meta_path)
+            file_info->meta_path = strdup(info->prov_file_path);
     }
     /* PROV-IO instrument end */
 
@@ -4376,7 +5870,7 @@ H5VL_provenance_file_open(const char *name, unsigned flags, hid_t fapl_id,
     }
 #endif /* H5_HAVE_PARALLEL */
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return (void *)file;
 } /* end H5VL_provenance_file_open() */
 
@@ -4416,7 +5910,7 @@ H5VL_provenance_file_get(void *file, H5VL_file_get_args_t *args, hid_t dxpl_id,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_file_get() */
 
@@ -4517,6 +6011,10 @@ H5VL_provenance_file_specific(void *file, H5VL_file_specific_args_t *args,
 
         /* Set object pointer for operation */
         new_o = o->under_object;
+
+        // Pending Provenance group attributes go out with the flush
+        if(args->op_type == H5VL_FILE_FLUSH)
+            file_prov_meta_write(o, dxpl_id);
     } /* end else */
 
     m1 = get_time_usec();
@@ -4558,7 +6056,7 @@ H5VL_provenance_file_specific(void *file, H5VL_file_specific_args_t *args,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_file_specific() */
 
@@ -4598,7 +6096,7 @@ H5VL_provenance_file_optional(void *file, H5VL_optional_args_t *args,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_file_optional() */
 
@@ -4629,8 +6127,9 @@ H5VL_provenance_file_close(void *file, hid_t dxpl_id, void **req)
     if(o){
         assert(o->generic_prov_info);
 
-        file_stats_prov_write((file_prov_info_t*)(o->generic_prov_info));
-
+        file_prov_meta_write(o, dxpl_id);
+        if(config.enable_embed_prov)
+            file_embed_prov(o);
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
     }
 
@@ -4644,12 +6143,16 @@ H5VL_provenance_file_close(void *file, hid_t dxpl_id, void **req)
 
     /* Release our wrapper, if underlying file was closed */
     if(ret_value >= 0){
+#ifdef H5_HAVE_PARALLEL
+        if(config.enable_dep_detect)
+            file_dep_detect((file_prov_info_t*)(o->generic_prov_info));
+#endif /* H5_HAVE_PARALLEL */
         rm_file_node(PROV_HELPER, ((file_prov_info_t*)(o->generic_prov_info))->file_no);
 
         H5VL_provenance_free_obj(o);
     }
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_file_close() */
 
@@ -4689,22 +6192,28 @@ H5VL_provenance_group_create(void *obj, const H5VL_loc_params_t *loc_params,
     else
         group = NULL;
 
+    if(group)
+        file_grp_created(obj_file_info(group));
+
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
 
     /* PROV-IO instrument start */
-    const char* io_api = "H5Gcreate2";
-    const char* io_api_async = "H5Gcreate2_async";
-    const char* relation = "prov:wasGeneratedBy";
-    const char* type = "provio:Group";    
-    prov_fill_data_object(&fields, name, type);
-    prov_fill_relation(&fields, relation);
-    prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
-    prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    if(PROV_CB_ENABLED(group_create)) {
+        const char* io_api = "H5Gcreate2";
+        const char* io_api_async = "H5Gcreate2_async";
+        const char* relation = "prov:wasGeneratedBy";
+        const char* type = "provio:Group";    
+        prov_fill_data_object(&fields, name, type);
+        prov_fill_file(&fields, obj_file_name(o));
+        prov_fill_relation(&fields, relation);
+        prov_fill_io_api(&fields, io_api, get_time_usec() - start);
+        prov_record_add(req, io_api_async, start);
+        func_stat_id(PROV_CB_group_create, m2 - m1, get_time_usec() - start - (m2 - m1));
+        prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    }
     /* PROV-IO instrument end */
 
     return (void *)group;
@@ -4748,19 +6257,22 @@ H5VL_provenance_group_open(void *obj, const H5VL_loc_params_t *loc_params,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
 
     /* PROV-IO instrument start */
-    const char* io_api = "H5Gopen2";
-    const char* io_api_async = "H5Gopen_async";
-    const char* relation = "provio:wasOpenedBy";
-    const char* type = "provio:Group"; 
-    prov_fill_data_object(&fields, name, type);
-    prov_fill_relation(&fields, relation);
-    prov_fill_io_api(&fields, io_api, get_time_usec() - start);
-    add_prov_record(&config, provio_helper, &fields);
-    func_stat(__func__, (get_time_usec() - start - (m2 - m1)));
-    prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    if(PROV_CB_ENABLED(group_open)) {
+        const char* io_api = "H5Gopen2";
+        const char* io_api_async = "H5Gopen_async";
+        const char* relation = "provio:wasOpenedBy";
+        const char* type = "provio:Group"; 
+        prov_fill_data_object(&fields, name, type);
+        prov_fill_file(&fields, obj_file_name(o));
+        prov_fill_relation(&fields, relation);
+        prov_fill_io_api(&fields, io_api, get_time_usec() - start);
+        prov_record_add(req, io_api_async, start);
+        func_stat_id(PROV_CB_group_open, m2 - m1, get_time_usec() - start - (m2 - m1));
+        prov_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    }
     /* PROV-IO instrument end */
 
     return (void *)group;
@@ -4802,7 +6314,7 @@ H5VL_provenance_group_get(void *obj, H5VL_group_get_args_t *args, hid_t dxpl_id,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_group_get() */
 
@@ -4897,7 +6409,7 @@ H5VL_provenance_group_specific(void *obj, H5VL_group_specific_args_t *args,
 
     // prov_write(helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_group_specific() */
 
@@ -4937,7 +6449,7 @@ H5VL_provenance_group_optional(void *obj, H5VL_optional_args_t *args,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_group_optional() */
 
@@ -4987,7 +6499,7 @@ H5VL_provenance_group_close(void *grp, hid_t dxpl_id, void **req)
         H5VL_provenance_free_obj(o);
     }
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_group_close() */
 
@@ -5059,7 +6571,7 @@ H5VL_provenance_link_create(H5VL_link_create_args_t *args, void *obj,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_link_create() */
 
@@ -5114,7 +6626,7 @@ H5VL_provenance_link_copy(void *src_obj, const H5VL_loc_params_t *loc_params1,
     if(o_dst)
         // prov_write(o_dst->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_link_copy() */
 
@@ -5162,6 +6674,9 @@ H5VL_provenance_link_move(void *src_obj, const H5VL_loc_params_t *loc_params1,
     ret_value = H5VLlink_move((o_src ? o_src->under_object : NULL), loc_params1, (o_dst ? o_dst->under_object : NULL), loc_params2, under_vol_id, lcpl_id, lapl_id, dxpl_id, req);
     m2 = get_time_usec();
 
+    if(ret_value >= 0)
+        obj_names_changed(o_src ? o_src : o_dst);
+
     /* Check for async request */
     if(req && *req)
         *req = H5VL_provenance_new_obj(*req, under_vol_id, o_dst->prov_helper);
@@ -5169,7 +6684,7 @@ H5VL_provenance_link_move(void *src_obj, const H5VL_loc_params_t *loc_params1,
     if(o_dst)
         // prov_write(o_dst->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_link_move() */
 
@@ -5209,7 +6724,7 @@ H5VL_provenance_link_get(void *obj, const H5VL_loc_params_t *loc_params,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_link_get() */
 
@@ -5242,6 +6757,9 @@ H5VL_provenance_link_specific(void *obj, const H5VL_loc_params_t *loc_params,
     ret_value = H5VLlink_specific(o->under_object, loc_params, o->under_vol_id, args, dxpl_id, req);
     m2 = get_time_usec();
 
+    if(ret_value >= 0 && args->op_type == H5VL_LINK_DELETE)
+        obj_names_changed(o);
+
     /* Check for async request */
     if(req && *req)
         *req = H5VL_provenance_new_obj(*req, o->under_vol_id, o->prov_helper);
@@ -5249,7 +6767,7 @@ H5VL_provenance_link_specific(void *obj, const H5VL_loc_params_t *loc_params,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_link_specific() */
 
@@ -5289,7 +6807,7 @@ H5VL_provenance_link_optional(void *obj, const H5VL_loc_params_t *loc_params,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_link_optional() */
 
@@ -5338,7 +6856,7 @@ H5VL_provenance_object_open(void *obj, const H5VL_loc_params_t *loc_params,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return (void *)new_obj;
 } /* end H5VL_provenance_object_open() */
 
@@ -5381,7 +6899,7 @@ H5VL_provenance_object_copy(void *src_obj, const H5VL_loc_params_t *src_loc_para
     if(o_dst)
         // prov_write(o_dst->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_object_copy() */
 
@@ -5420,7 +6938,7 @@ H5VL_provenance_object_get(void *obj, const H5VL_loc_params_t *loc_params, H5VL_
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_object_get() */
 
@@ -5454,8 +6972,8 @@ H5VL_provenance_object_specific(void *obj, const H5VL_loc_params_t *loc_params,
     printf("------- PROVENANCE VOL OBJECT Specific\n");
 #endif
 
-    // Check if refreshing
-    if(args->op_type == H5VL_OBJECT_REFRESH) {
+    // Check if refreshing, bare objects have no info to keep
+    if(args->op_type == H5VL_OBJECT_REFRESH && o->generic_prov_info) {
         // Save prov info for later, and increment the refcount on it,
         // so that the stats aren't lost when the object is closed and reopened
         // during the underlying refresh operation
@@ -5474,10 +6992,7 @@ H5VL_provenance_object_specific(void *obj, const H5VL_loc_params_t *loc_params,
     ret_value = H5VLobject_specific(o->under_object, loc_params, o->under_vol_id, args, dxpl_id, req);
     m2 = get_time_usec();
 
-    if(args->op_type == H5VL_OBJECT_REFRESH) {
-        // Sanity check
-        assert(my_prov_info);
-
+    if(args->op_type == H5VL_OBJECT_REFRESH && my_prov_info) {
         // Get new object info, after refresh
         if(ret_value >= 0) {
             // Sanity check - make certain info wasn't freed
@@ -5527,7 +7042,7 @@ H5VL_provenance_object_specific(void *obj, const H5VL_loc_params_t *loc_params,
 
     // prov_write(helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_object_specific() */
 
@@ -5567,7 +7082,7 @@ H5VL_provenance_object_optional(void *obj, const H5VL_loc_params_t *loc_params,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_object_optional() */
 
@@ -5663,10 +7178,13 @@ H5VL_provenance_request_wait(void *obj, uint64_t timeout,
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    if(ret_value >= 0 && *status != H5ES_STATUS_IN_PROGRESS)
+    if(ret_value >= 0 && *status != H5ES_STATUS_IN_PROGRESS) {
+        request_pending_finish(o, *status == H5VL_REQUEST_STATUS_SUCCEED);
         H5VL_provenance_free_obj(o);
+    }
+    pending_drain();
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_request_wait() */
 
@@ -5691,23 +7209,41 @@ H5VL_provenance_request_notify(void *obj, H5VL_request_notify_t cb, void *ctx)
     unsigned long m1, m2;
 
     H5VL_provenance_t *o = (H5VL_provenance_t *)obj;
+    prov_notify_ctx_t *notify = NULL;
     herr_t ret_value;
 
 #ifdef ENABLE_PROVNC_LOGGING
     printf("------- PROVENANCE VOL REQUEST Wait\n");
 #endif
 
+    // The pending record goes with the callback, the wrapper is released
+    if(o->pending && (notify = malloc(sizeof(prov_notify_ctx_t)))) {
+        notify->cb = cb;
+        notify->ctx = ctx;
+        notify->pending = o->pending;
+    }
+
     m1 = get_time_usec();
-    ret_value = H5VLrequest_notify(o->under_object, o->under_vol_id, cb, ctx);
+    if(notify)
+        ret_value = H5VLrequest_notify(o->under_object, o->under_vol_id, pending_notify, notify);
+    else
+        ret_value = H5VLrequest_notify(o->under_object, o->under_vol_id, cb, ctx);
     m2 = get_time_usec();
 
+    if(notify) {
+        if(ret_value >= 0)
+            o->pending = NULL;
+        else
+            free(notify);
+    }
+
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
     if(ret_value >= 0)
         H5VL_provenance_free_obj(o);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_request_notify() */
 
@@ -5744,10 +7280,12 @@ H5VL_provenance_request_cancel(void *obj, H5VL_request_status_t *status)
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    if(ret_value >= 0)
+    if(ret_value >= 0) {
+        request_pending_finish(o, *status == H5VL_REQUEST_STATUS_SUCCEED);
         H5VL_provenance_free_obj(o);
+    }
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_request_cancel() */
 
@@ -5782,7 +7320,7 @@ H5VL_provenance_request_specific(void *obj, H5VL_request_specific_args_t *args)
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_request_specific() */
 
@@ -5817,7 +7355,7 @@ H5VL_provenance_request_optional(void *obj, H5VL_optional_args_t *args)
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_request_optional() */
 
@@ -5853,10 +7391,13 @@ H5VL_provenance_request_free(void *obj)
     if(o)
         // prov_write(o->prov_helper, __func__, get_time_usec() - start);
 
-    if(ret_value >= 0)
+    if(ret_value >= 0) {
+        request_pending_finish(o, true);
         H5VL_provenance_free_obj(o);
+    }
+    pending_drain();
 
-    TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
+    vol_stat.TOTAL_PROV_OVERHEAD += (get_time_usec() - start - (m2 - m1));
     return ret_value;
 } /* end H5VL_provenance_request_free() */
 
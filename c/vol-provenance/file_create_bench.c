@@ -0,0 +1,71 @@
+// Description: H5Fcreate/H5Fclose latency. All processes create and close
+//		the same files collectively, rank 0 prints the mean and the
+//		largest latency over all ranks. Run it once with and once
+//		without HDF5_VOL_CONNECTOR set to see what the connector adds.
+// Usage:	mpirun -np N ./file_create_bench.exe <directory> <number of files>
+
+
+#include "hdf5.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+
+
+int main(int argc, char* argv[]) {
+    char fname[4096];
+    int rank, nprocs, nfiles;
+    double t, create_sum = 0, close_sum = 0, create_max = 0, close_max = 0;
+    double local[2], global[2];
+    hid_t fapl, file_id;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+    if (argc < 3 || (nfiles = atoi(argv[2])) <= 0) {
+        if (rank == 0)
+            printf("Usage: %s <directory> <number of files>\n", argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+
+    fapl = H5Pcreate(H5P_FILE_ACCESS);
+    H5Pset_fapl_mpio(fapl, MPI_COMM_WORLD, MPI_INFO_NULL);
+
+    for (int i = 0; i < nfiles; i++) {
+        snprintf(fname, sizeof(fname), "%s/file_create_bench_%d.h5", argv[1], i);
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        t = MPI_Wtime();
+        file_id = H5Fcreate(fname, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+        local[0] = MPI_Wtime() - t;
+        if (file_id < 0) {
+            printf("Rank %d: failed to create %s\n", rank, fname);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        t = MPI_Wtime();
+        H5Fclose(file_id);
+        local[1] = MPI_Wtime() - t;
+
+        // The slowest rank decides the latency of a collective call
+        MPI_Reduce(local, global, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        create_sum += global[0];
+        close_sum += global[1];
+        if (global[0] > create_max)
+            create_max = global[0];
+        if (global[1] > close_max)
+            close_max = global[1];
+    }
+
+    if (rank == 0) {
+        printf("%d files, %d processes\n", nfiles, nprocs);
+        printf("H5Fcreate: mean %.1f us, max %.1f us\n", 1e6 * create_sum / nfiles, 1e6 * create_max);
+        printf("H5Fclose:  mean %.1f us, max %.1f us\n", 1e6 * close_sum / nfiles, 1e6 * close_max);
+    }
+
+    H5Pclose(fapl);
+    MPI_Finalize();
+    return 0;
+}
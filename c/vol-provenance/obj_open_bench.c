@@ -0,0 +1,119 @@
+// Description: Attribute and dataset call latency. Every process works on
+//		its own file: it creates, opens (by name and by index),
+//		writes, reads and closes small attributes and datasets, and
+//		rank 0 prints the mean latency of each call over all ranks.
+//		Run it without HDF5_VOL_CONNECTOR, then with the connector and
+//		ENABLE_ATTR=F / ENABLE_DATASET=F to see what a disabled class
+//		still costs, then with them on.
+// Usage:	mpirun -np N ./obj_open_bench.exe <directory> <number of objects>
+
+
+#include "hdf5.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+
+
+enum { ATTR_CREATE, ATTR_WRITE, ATTR_OPEN, ATTR_OPEN_IDX, ATTR_READ, ATTR_CLOSE,
+    DSET_CREATE, DSET_WRITE, DSET_OPEN, DSET_READ, DSET_CLOSE, OP_COUNT };
+
+static const char* op_names[OP_COUNT] = {
+    "H5Acreate2", "H5Awrite", "H5Aopen", "H5Aopen_by_idx", "H5Aread", "H5Aclose",
+    "H5Dcreate2", "H5Dwrite", "H5Dopen2", "H5Dread", "H5Dclose"
+};
+
+int main(int argc, char* argv[]) {
+    char fname[4096], name[64];
+    int rank, nprocs, nobjs, value = 0;
+    double t, local[OP_COUNT] = {0}, global[OP_COUNT];
+    hsize_t dims = 1;
+    hid_t file_id, space_id, attr_id, dset_id;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+    if (argc < 3 || (nobjs = atoi(argv[2])) <= 0) {
+        if (rank == 0)
+            printf("Usage: %s <directory> <number of objects>\n", argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+
+    snprintf(fname, sizeof(fname), "%s/obj_open_bench_%d.h5", argv[1], rank);
+    file_id = H5Fcreate(fname, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    if (file_id < 0) {
+        printf("Rank %d: failed to create %s\n", rank, fname);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    space_id = H5Screate_simple(1, &dims, NULL);
+
+    // Attributes of the root group
+    for (int i = 0; i < nobjs; i++) {
+        snprintf(name, sizeof(name), "attr_%d", i);
+        t = MPI_Wtime();
+        attr_id = H5Acreate2(file_id, name, H5T_NATIVE_INT, space_id, H5P_DEFAULT, H5P_DEFAULT);
+        local[ATTR_CREATE] += MPI_Wtime() - t;
+        t = MPI_Wtime();
+        H5Awrite(attr_id, H5T_NATIVE_INT, &i);
+        local[ATTR_WRITE] += MPI_Wtime() - t;
+        t = MPI_Wtime();
+        H5Aclose(attr_id);
+        local[ATTR_CLOSE] += MPI_Wtime() - t;
+    }
+    for (int i = 0; i < nobjs; i++) {
+        snprintf(name, sizeof(name), "attr_%d", i);
+        t = MPI_Wtime();
+        attr_id = H5Aopen(file_id, name, H5P_DEFAULT);
+        local[ATTR_OPEN] += MPI_Wtime() - t;
+        t = MPI_Wtime();
+        H5Aread(attr_id, H5T_NATIVE_INT, &value);
+        local[ATTR_READ] += MPI_Wtime() - t;
+        H5Aclose(attr_id);
+
+        // Opened by index the connector has no name to go by
+        t = MPI_Wtime();
+        attr_id = H5Aopen_by_idx(file_id, ".", H5_INDEX_NAME, H5_ITER_INC, (hsize_t)i,
+            H5P_DEFAULT, H5P_DEFAULT);
+        local[ATTR_OPEN_IDX] += MPI_Wtime() - t;
+        H5Aclose(attr_id);
+    }
+
+    // Datasets of one element
+    for (int i = 0; i < nobjs; i++) {
+        snprintf(name, sizeof(name), "dset_%d", i);
+        t = MPI_Wtime();
+        dset_id = H5Dcreate2(file_id, name, H5T_NATIVE_INT, space_id, H5P_DEFAULT, H5P_DEFAULT,
+            H5P_DEFAULT);
+        local[DSET_CREATE] += MPI_Wtime() - t;
+        t = MPI_Wtime();
+        H5Dwrite(dset_id, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, &i);
+        local[DSET_WRITE] += MPI_Wtime() - t;
+        t = MPI_Wtime();
+        H5Dclose(dset_id);
+        local[DSET_CLOSE] += MPI_Wtime() - t;
+    }
+    for (int i = 0; i < nobjs; i++) {
+        snprintf(name, sizeof(name), "dset_%d", i);
+        t = MPI_Wtime();
+        dset_id = H5Dopen2(file_id, name, H5P_DEFAULT);
+        local[DSET_OPEN] += MPI_Wtime() - t;
+        t = MPI_Wtime();
+        H5Dread(dset_id, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, &value);
+        local[DSET_READ] += MPI_Wtime() - t;
+        H5Dclose(dset_id);
+    }
+
+    H5Sclose(space_id);
+    H5Fclose(file_id);
+
+    MPI_Reduce(local, global, OP_COUNT, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        printf("%d objects, %d processes\n", nobjs, nprocs);
+        for (int op = 0; op < OP_COUNT; op++)
+            printf("%-15s mean %.2f us\n", op_names[op], 1e6 * global[op] / nobjs / nprocs);
+    }
+
+    MPI_Finalize();
+    return 0;
+}
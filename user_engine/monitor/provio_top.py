@@ -0,0 +1,178 @@
+import argparse
+import glob
+import mmap
+import os
+import struct
+import sys
+import time
+
+SHM_DIR = "/dev/shm"
+MAGIC = 0x31565250
+VERSION = 1
+# stat_shm_header in c/provio/stat.h
+HEADER = struct.Struct("=IIIiiIIIIIQQ")
+STAT_FIELDS = ["TOTAL_PROV_OVERHEAD", "TOTAL_NATIVE_H5_TIME", "PROV_WRITE_TOTAL_TIME",
+               "FILE_LL_TOTAL_TIME", "DS_LL_TOTAL_TIME", "GRP_LL_TOTAL_TIME",
+               "DT_LL_TOTAL_TIME", "ATTR_LL_TOTAL_TIME", "PROV_SERIALIZE_TIME"]
+STAT = struct.Struct("=%dQ" % len(STAT_FIELDS))
+NAME_LEN = 64
+SEQ_OFFSET = 8
+RETRIES = 100
+
+
+def alive(pid):
+    try:
+        os.kill(pid, 0)
+    except ProcessLookupError:
+        return False
+    except PermissionError:
+        pass
+    return True
+
+
+def read_consistent(path):
+    """Copy a segment with the seqlock protocol, None if it is not ready"""
+    with open(path, "rb") as f:
+        try:
+            mm = mmap.mmap(f.fileno(), 0, prot=mmap.PROT_READ)
+        except ValueError:
+            return None
+    try:
+        for _ in range(RETRIES):
+            seq, = struct.unpack_from("=I", mm, SEQ_OFFSET)
+            if seq & 1:
+                time.sleep(0.0001)
+                continue
+            data = mm[:]
+            if struct.unpack_from("=I", mm, SEQ_OFFSET)[0] == seq:
+                return data
+        return None
+    finally:
+        mm.close()
+
+
+def parse(data):
+    (magic, version, seq, rank, pid, header_size, cb_cnt, cb_size,
+     buckets, sub_bits, start, update) = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != VERSION or seq == 0:
+        return None
+    prov = dict(zip(STAT_FIELDS, STAT.unpack_from(data, HEADER.size)))
+    connector = dict(zip(STAT_FIELDS, STAT.unpack_from(data, HEADER.size + STAT.size)))
+    hist = struct.Struct("=QQQ%dI" % buckets)
+    callbacks = {}
+    for i in range(cb_cnt):
+        off = header_size + i * cb_size
+        name = data[off:off + NAME_LEN].split(b"\0", 1)[0].decode()
+        native = hist.unpack_from(data, off + NAME_LEN)
+        overhead = hist.unpack_from(data, off + NAME_LEN + hist.size)
+        callbacks[name] = (native, overhead)
+    return {"rank": rank, "pid": pid, "start": start, "update": update,
+            "sub_bits": sub_bits, "prov": prov, "connector": connector,
+            "callbacks": callbacks}
+
+
+def snapshot(shm_dir):
+    procs = {}
+    for path in glob.glob(os.path.join(shm_dir, "provio.*")):
+        try:
+            pid = int(path.rsplit(".", 1)[1])
+        except ValueError:
+            continue
+        if not alive(pid):
+            continue
+        data = read_consistent(path)
+        seg = parse(data) if data else None
+        if seg:
+            procs[pid] = seg
+    return procs
+
+
+def bucket_upper(index, sub_bits):
+    """Same as stat_hist_upper() in stat.c"""
+    if index < (1 << sub_bits):
+        return index
+    exp = (index >> sub_bits) + sub_bits - 1
+    sub = index & ((1 << sub_bits) - 1)
+    return (((1 << sub_bits) + sub + 1) << (exp - sub_bits)) - 1
+
+
+def percentile(buckets, count, q, sub_bits):
+    if count == 0:
+        return 0
+    rank, seen = max(1, int(q * count + 0.5)), 0
+    for i, n in enumerate(buckets):
+        seen += n
+        if seen >= rank:
+            return bucket_upper(i, sub_bits)
+    return 0
+
+
+def delta(now, before):
+    """Per callback (calls, native us, overhead us, native bucket deltas)"""
+    out = {}
+    for name, (native, overhead) in now["callbacks"].items():
+        old = before["callbacks"].get(name) if before else None
+        calls = native[0] - (old[0][0] if old else 0)
+        if calls <= 0:
+            continue
+        buckets = [a - b for a, b in zip(native[3:], old[0][3:])] if old else list(native[3:])
+        out[name] = (calls, native[1] - (old[0][1] if old else 0),
+                     overhead[1] - (old[1][1] if old else 0), buckets)
+    return out
+
+
+def render(procs, prev, elapsed, top, sort_key):
+    lines = ["provio-top  %d process(es)  interval %.1fs" % (len(procs), elapsed), ""]
+    lines.append("%7s %5s %10s %12s %12s %7s" % ("PID", "RANK", "CALLS/s", "NATIVE ms/s", "OVERHD ms/s", "OVHD%"))
+    per_cb = {}
+    for pid in sorted(procs, key=lambda p: procs[p]["rank"]):
+        seg = procs[pid]
+        d = delta(seg, prev.get(pid))
+        calls = sum(v[0] for v in d.values())
+        native = sum(v[1] for v in d.values())
+        overhead = sum(v[2] for v in d.values())
+        total = native + overhead
+        lines.append("%7d %5d %10.1f %12.2f %12.2f %6.1f%%" % (
+            pid, seg["rank"], calls / elapsed, native / elapsed / 1000, overhead / elapsed / 1000,
+            100.0 * overhead / total if total else 0))
+        for name, (c, n, o, buckets) in d.items():
+            acc = per_cb.setdefault(name, [0, 0, 0, [0] * len(buckets), seg["sub_bits"]])
+            acc[0] += c
+            acc[1] += n
+            acc[2] += o
+            acc[3] = [a + b for a, b in zip(acc[3], buckets)]
+
+    lines += ["", "%-28s %10s %12s %12s %7s %10s" % ("CALLBACK", "CALLS/s", "NATIVE ms/s",
+                                                     "OVERHD ms/s", "OVHD%", "p99 us")]
+    index = {"calls": 0, "native": 1, "overhead": 2}[sort_key]
+    for name, (c, n, o, buckets, sub_bits) in sorted(per_cb.items(), key=lambda kv: -kv[1][index])[:top]:
+        lines.append("%-28s %10.1f %12.2f %12.2f %6.1f%% %10d" % (
+            name, c / elapsed, n / elapsed / 1000, o / elapsed / 1000,
+            100.0 * o / (n + o) if n + o else 0, percentile(buckets, c, 0.99, sub_bits)))
+    return "\n".join(lines)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Live per-callback I/O and provenance overhead rates "
+                                                 "of PROV-IO processes on this node (ENABLE_STAT_SHM=T)")
+    parser.add_argument("-d", "--delay", type=float, default=2.0, help="seconds between refreshes")
+    parser.add_argument("-n", "--iterations", type=int, default=0, help="stop after n refreshes (default: run forever)")
+    parser.add_argument("--top", type=int, default=20, help="callbacks shown")
+    parser.add_argument("--sort", choices=["calls", "native", "overhead"], default="overhead")
+    parser.add_argument("--dir", default=SHM_DIR, help="directory holding the provio.<pid> segments")
+    args = parser.parse_args()
+
+    prev, last, i = {}, time.time(), 0
+    prev = snapshot(args.dir)
+    try:
+        while args.iterations == 0 or i < args.iterations:
+            time.sleep(args.delay)
+            procs, now = snapshot(args.dir), time.time()
+            screen = render(procs, prev, now - last, args.top, args.sort)
+            if sys.stdout.isatty():
+                sys.stdout.write("\033[H\033[J")
+            print(screen)
+            sys.stdout.flush()
+            prev, last, i = procs, now, i + 1
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,99 @@
+import argparse
+import csv
+import sys
+from collections import defaultdict
+
+VERSION = 1
+
+
+def load(paths):
+    """Rows of all series files, (start, end) is the interval a row covers"""
+    rows = []
+    for path in paths:
+        with open(path) as f:
+            header = f.readline().split()
+            if header[:4] != ["#", "provio", "stat", "series"] or header[4] != "v%d" % VERSION:
+                sys.exit("%s: not a v%d provio stat series" % (path, VERSION))
+            for r in csv.DictReader(f):
+                end = int(r["time_us"])
+                rows.append({
+                    "start": end - int(r["interval_us"]),
+                    "end": end,
+                    "rank": int(r["rank"]),
+                    "kind": r["kind"],
+                    "name": r["name"],
+                    "count": int(r["count"] or 0),
+                    "total": int(r["total_us"]),
+                })
+    return rows
+
+
+def align(rows, window):
+    """Spread every row over the common windows it overlaps, in proportion.
+
+    Ranks take their snapshots at different times, so the rows of
+    different ranks only line up after resampling."""
+    if not rows:
+        return 0, {}
+    t0 = min(r["start"] for r in rows)
+    out = defaultdict(lambda: [0.0, 0.0])
+    for r in rows:
+        length = r["end"] - r["start"]
+        first = (r["start"] - t0) // window
+        last = max(first, (r["end"] - 1 - t0) // window)
+        for w in range(first, last + 1):
+            lo = max(r["start"], t0 + w * window)
+            hi = min(r["end"], t0 + (w + 1) * window)
+            share = (hi - lo) / length if length > 0 else 1.0
+            acc = out[(w, r["rank"], r["kind"], r["name"])]
+            acc[0] += r["count"] * share
+            acc[1] += r["total"] * share
+    return t0, out
+
+
+def summary(aligned, window, name):
+    """Per window: calls, native and overhead time, the slowest rank"""
+    per = defaultdict(lambda: defaultdict(lambda: [0.0, 0.0, 0.0]))
+    for (w, rank, kind, n), (count, total) in aligned.items():
+        if kind not in ("native", "overhead") or (name and n != name):
+            continue
+        acc = per[w][rank]
+        if kind == "native":
+            acc[0] += count
+            acc[1] += total
+        else:
+            acc[2] += total
+
+    print("%8s %6s %12s %12s %12s %7s %16s %9s" % ("T(s)", "RANKS", "CALLS", "NATIVE ms", "OVERHD ms",
+                                                  "OVHD%", "SLOWEST ms(rank)", "IMBALANCE"))
+    for w in sorted(per):
+        ranks = per[w]
+        calls = sum(v[0] for v in ranks.values())
+        native = sum(v[1] for v in ranks.values())
+        overhead = sum(v[2] for v in ranks.values())
+        slow = max(ranks, key=lambda r: ranks[r][1] + ranks[r][2])
+        slow_t = ranks[slow][1] + ranks[slow][2]
+        mean_t = (native + overhead) / len(ranks)
+        print("%8.1f %6d %12.0f %12.2f %12.2f %6.1f%% %10.2f(%4d) %9.2f" % (
+            w * window / 1e6, len(ranks), calls, native / 1000, overhead / 1000,
+            100.0 * overhead / (native + overhead) if native + overhead else 0,
+            slow_t / 1000, slow, slow_t / mean_t if mean_t else 0))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Align PROV-IO stat series (ENABLE_STAT_SERIES=T) across ranks")
+    parser.add_argument("paths", nargs="+", help="prov.series.RANK-* files")
+    parser.add_argument("-w", "--window", type=float, default=10.0, help="seconds per aligned window")
+    parser.add_argument("--name", help="only this callback")
+    parser.add_argument("--csv", help="write the aligned series (window, rank, kind, name, count, total_us)")
+    args = parser.parse_args()
+
+    window = int(args.window * 1e6)
+    t0, aligned = align(load(args.paths), window)
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            out = csv.writer(f)
+            out.writerow(["window_start_us", "rank", "kind", "name", "count", "total_us"])
+            for (w, rank, kind, name), (count, total) in sorted(aligned.items()):
+                out.writerow([t0 + w * window, rank, kind, name, round(count, 3), round(total, 3)])
+    summary(aligned, window, args.name)
@@ -0,0 +1,252 @@
+import argparse
+import json
+import math
+import struct
+import sys
+from collections import OrderedDict
+
+VERSIONS = (1, 2, 3)  # version 2 added "pools", version 3 "async"
+MAGIC = 0x31525250
+
+
+def bucket_upper(index, sub_bits):
+    """Largest value counted in bucket index, as stat_hist_upper()"""
+    if index < (1 << sub_bits):
+        return index
+    exp = (index >> sub_bits) + sub_bits - 1
+    sub = index & ((1 << sub_bits) - 1)
+    return (((1 << sub_bits) + sub + 1) << (exp - sub_bits)) - 1
+
+
+class Reader:
+    def __init__(self, data, pos):
+        self.data = data
+        self.pos = pos
+
+    def take(self, fmt):
+        values = struct.unpack_from("<" + fmt, self.data, self.pos)
+        self.pos += struct.calcsize("<" + fmt)
+        return values if len(values) > 1 else values[0]
+
+    def str(self):
+        n = self.take("H")
+        self.pos += n
+        return self.data[self.pos - n:self.pos].decode("utf-8", "replace")
+
+    def hist(self):
+        count, total, peak, nonzero = self.take("QQQI")
+        buckets = [list(self.take("II")) for _ in range(nonzero)]
+        return {"count": count, "sum": total, "max": peak, "buckets": buckets}
+
+
+def parse_binary(data, pos):
+    """One binary record (layout in c/provio/stat.c), returns it and its end"""
+    r = Reader(data, pos)
+    magic, version, length, rank, nprocs, sub_bits, tsc, perf_mask = r.take("IIIiiIII")
+    if magic != MAGIC or version not in VERSIONS:
+        raise ValueError("bad record at offset %d" % pos)
+    config_hash, start, end, timer_cost, perf_cost = r.take("QQQQQ")
+    rec = {"run_id": r.str(), "program": r.str(), "rank": rank, "nprocs": nprocs,
+           "hist_sub_bits": sub_bits, "config_hash": "%016x" % config_hash,
+           "start_us": start, "end_us": end,
+           "timer": {"source": "tsc" if tsc else "monotonic", "read_cost_ns": timer_cost},
+           "perf_read_cost_ns": perf_cost}
+    phases = [r.str() for _ in range(r.take("I"))]
+    events = [r.str() for _ in range(r.take("I"))]
+    rec["perf_events"] = [e for i, e in enumerate(events) if perf_mask & (1 << i)]
+    rec["prov"], rec["connector"] = {}, {}
+    for _ in range(r.take("I")):
+        name = r.str()
+        rec["prov"][name], rec["connector"][name] = r.take("QQ")
+    rec["callbacks"] = {}
+    for _ in range(r.take("I")):
+        name = r.str()
+        cb = {"overhead_us": r.take("Q"), "native": r.hist(), "overhead": r.hist()}
+        ns = [r.take("Q") for _ in phases]
+        if any(ns):
+            cb["phases_ns"] = dict(zip(phases, ns))
+        row = [r.take("Q") for _ in range(1 + 2 * len(events))]
+        if row[0]:
+            cb["perf"] = {"calls": row[0]}
+            for k, kind in enumerate(("native", "overhead")):
+                cb["perf"][kind] = {e: row[1 + k * len(events) + i]
+                                    for i, e in enumerate(events) if perf_mask & (1 << i)}
+        rec["callbacks"][name] = cb
+    rec["unattributed_phases_ns"] = dict(zip(phases, (r.take("Q") for _ in phases)))
+    rec["counts"] = {}
+    for _ in range(r.take("I")):
+        name = r.str()
+        rec["counts"][name] = r.take("Q")
+    rec["pools"] = {}
+    for _ in range(r.take("I") if version >= 2 else 0):
+        name = r.str()
+        rec["pools"][name] = dict(zip(("allocs", "reused", "frees", "released"), r.take("QQQQ")))
+    if version >= 3:
+        rec["async"] = dict(zip(("ops", "max_in_flight", "issue_us", "complete_us", "overlap_us"),
+                                r.take("QQQQQ")))
+    rec["coll_skew"] = []
+    for _ in range(r.take("I")):
+        name = r.str()
+        ops, total, peak, slowest, wasted = r.take("iQQid")
+        rec["coll_skew"].append({"name": name, "ops": ops, "total_skew_us": total,
+                                 "max_skew_us": peak, "slowest_rank": slowest, "wasted_rank_s": wasted})
+    return rec, pos + length
+
+
+def load(paths):
+    """Records of all files, JSON Lines or binary"""
+    records = []
+    for path in paths:
+        with open(path, "rb") as f:
+            data = f.read()
+        if len(data) >= 4 and struct.unpack_from("<I", data)[0] == MAGIC:
+            pos = 0
+            while pos < len(data):
+                rec, pos = parse_binary(data, pos)
+                records.append(rec)
+            continue
+        for n, line in enumerate(data.decode("utf-8").splitlines()):
+            if not line.strip():
+                continue
+            rec = json.loads(line)
+            if rec.get("format") != "provio-stat" or rec.get("version") not in VERSIONS:
+                sys.exit("%s:%d: not a provio stat record of version %s" % (
+                    path, n + 1, " or ".join(map(str, VERSIONS))))
+            records.append(rec)
+    return records
+
+
+def merge_runs(records):
+    """Runs in order of their start, every callback histogram summed over ranks"""
+    runs = OrderedDict()
+    for rec in sorted(records, key=lambda r: r["start_us"]):
+        run = runs.setdefault(rec["run_id"], {
+            "run_id": rec["run_id"], "program": rec["program"], "nprocs": rec["nprocs"],
+            "config_hash": rec["config_hash"], "sub_bits": rec["hist_sub_bits"],
+            "ranks": set(), "callbacks": {}})
+        run["ranks"].add(rec["rank"])
+        if rec["config_hash"] != run["config_hash"]:
+            run["config_hash"] = "mixed"
+        for name, cb in rec["callbacks"].items():
+            acc = run["callbacks"].setdefault(name, {})
+            for kind in ("native", "overhead"):
+                h = acc.setdefault(kind, {"count": 0, "sum": 0, "max": 0, "buckets": {}})
+                h["count"] += cb[kind]["count"]
+                h["sum"] += cb[kind]["sum"]
+                h["max"] = max(h["max"], cb[kind]["max"])
+                for index, count in cb[kind]["buckets"]:
+                    h["buckets"][index] = h["buckets"].get(index, 0) + count
+    return runs
+
+
+def percentile(hist, q, sub_bits):
+    """Same rule as stat_hist_percentile()"""
+    if hist["count"] == 0:
+        return 0
+    rank = max(1, int(q * hist["count"] + 0.5))
+    seen = 0
+    for index in sorted(hist["buckets"]):
+        seen += hist["buckets"][index]
+        if seen >= rank:
+            return min(bucket_upper(index, sub_bits), hist["max"])
+    return hist["max"]
+
+
+def mann_whitney(base, run):
+    """One-sided Mann-Whitney U test that run's values tend to be larger.
+
+    Only bucket counts are known, samples in one bucket are ties. Normal
+    approximation with tie and continuity correction, returns (p, effect)
+    where effect is P(run > base) + P(run = base) / 2."""
+    n1, n2 = base["count"], run["count"]
+    if n1 == 0 or n2 == 0:
+        return 1.0, 0.5
+    below, u, ties = 0, 0.0, 0
+    for index in sorted(set(base["buckets"]) | set(run["buckets"])):
+        a = base["buckets"].get(index, 0)
+        b = run["buckets"].get(index, 0)
+        u += b * (below + a / 2.0)
+        below += a
+        t = a + b
+        ties += t * t * t - t
+    n = n1 + n2
+    mean = n1 * n2 / 2.0
+    var = n1 * n2 / 12.0 * ((n + 1) - ties / float(n * (n - 1)))
+    if var <= 0:
+        return 1.0, u / (n1 * n2)
+    z = (u - mean - 0.5) / math.sqrt(var)
+    return 0.5 * math.erfc(z / math.sqrt(2)), u / (n1 * n2)
+
+
+def compare(base, run, kind, alpha, threshold, min_calls):
+    """Print one row per callback, returns the number of regressions"""
+    sub_bits = base["sub_bits"]
+    regressions = 0
+    print("\n%s vs baseline %s (%d/%d ranks, config %s)" % (
+        run["run_id"], base["run_id"], len(run["ranks"]), run["nprocs"], run["config_hash"]))
+    if run["config_hash"] != base["config_hash"]:
+        print("  settings differ from the baseline (config %s)" % base["config_hash"])
+    if run["sub_bits"] != sub_bits:
+        print("  histogram layouts differ (hist_sub_bits %d vs %d), not comparable" % (
+            run["sub_bits"], sub_bits))
+        return 0
+    print("%-40s %9s %9s %10s %10s %8s %12s %12s %9s %6s" % (
+        "CALLBACK", "CALLS", "CALLS'", "MEAN us", "MEAN' us", "CHANGE",
+        "P50/P99", "P50'/P99'", "P", "A12"))
+    for name in sorted(set(base["callbacks"]) | set(run["callbacks"])):
+        h0 = base["callbacks"].get(name, {}).get(kind)
+        h1 = run["callbacks"].get(name, {}).get(kind)
+        if not h0 or not h1 or h0["count"] < min_calls or h1["count"] < min_calls:
+            continue
+        m0 = h0["sum"] / float(h0["count"])
+        m1 = h1["sum"] / float(h1["count"])
+        change = (m1 - m0) / m0 if m0 else (math.inf if m1 else 0.0)
+        p_up, effect = mann_whitney(h0, h1)
+        p_down, _ = mann_whitney(h1, h0)
+        flag = ""
+        if p_up < alpha and change > threshold:
+            flag = "REGRESSION"
+            regressions += 1
+        elif p_down < alpha and change < -threshold:
+            flag = "improved"
+        print("%-40s %9d %9d %10.2f %10.2f %+7.1f%% %12s %12s %9.2g %6.3f %s" % (
+            name[:40], h0["count"], h1["count"], m0, m1, 100 * change,
+            "%d/%d" % (percentile(h0, 0.5, sub_bits), percentile(h0, 0.99, sub_bits)),
+            "%d/%d" % (percentile(h1, 0.5, sub_bits), percentile(h1, 0.99, sub_bits)),
+            min(p_up, p_down), effect, flag))
+    return regressions
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Compare PROV-IO runs (ENABLE_STAT_RECORD=T) per callback")
+    parser.add_argument("paths", nargs="+", help="stat record files, JSON Lines or binary")
+    parser.add_argument("-b", "--baseline", help="run id of the baseline (default: the earliest run)")
+    parser.add_argument("-r", "--run", action="append", help="only compare this run id (repeatable)")
+    parser.add_argument("-k", "--kind", choices=("overhead", "native"), default="overhead",
+                        help="histogram to compare")
+    parser.add_argument("-a", "--alpha", type=float, default=0.01, help="significance level per callback")
+    parser.add_argument("-t", "--threshold", type=float, default=5.0,
+                        help="smallest change of the mean worth flagging, percent")
+    parser.add_argument("--min-calls", type=int, default=20, help="skip callbacks called less often")
+    parser.add_argument("-l", "--list", action="store_true", help="list the runs and exit")
+    args = parser.parse_args()
+
+    runs = merge_runs(load(args.paths))
+    if not runs:
+        sys.exit("no records")
+    if args.list:
+        for run in runs.values():
+            print("%-40s %4d/%-4d ranks  config %s  %s" % (
+                run["run_id"], len(run["ranks"]), run["nprocs"], run["config_hash"], run["program"]))
+        sys.exit(0)
+    base_id = args.baseline or next(iter(runs))
+    if base_id not in runs:
+        sys.exit("no run %s" % base_id)
+    others = [runs[r] for r in (args.run or runs) if r != base_id and r in runs]
+    if not others:
+        sys.exit("nothing to compare with %s" % base_id)
+    base = runs[base_id]
+    found = sum(compare(base, run, args.kind, args.alpha, args.threshold / 100.0, args.min_calls)
+                for run in others)
+    sys.exit(1 if found else 0)
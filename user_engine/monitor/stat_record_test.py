@@ -0,0 +1,48 @@
+"""Round trip of the stat records: c/provio/stat_test writes the same
+statistics as JSON Lines and as binary, both must load to the same record.
+
+python stat_record_test.py ../../c/provio/stat_record.jsonl ../../c/provio/stat_record.bin
+"""
+import sys
+
+import stat_compare
+
+
+def histograms(rec):
+    for cb in rec["callbacks"].values():
+        yield cb["native"]
+        yield cb["overhead"]
+
+
+def main(json_path, bin_path):
+    (json_rec,) = stat_compare.load([json_path])
+    (bin_rec,) = stat_compare.load([bin_path])
+
+    # Only JSON carries the format tag and the percentiles, these must agree
+    # with the ones computed from the binary buckets
+    assert json_rec.pop("format") == "provio-stat"
+    assert json_rec.pop("version") in stat_compare.VERSIONS
+    sub_bits = bin_rec["hist_sub_bits"]
+    for json_hist, bin_hist in zip(histograms(json_rec), histograms(bin_rec)):
+        buckets = dict(bin_hist["buckets"])
+        for key, q in (("p50", 0.5), ("p99", 0.99), ("p999", 0.999)):
+            expected = stat_compare.percentile(dict(bin_hist, buckets=buckets), q, sub_bits)
+            assert json_hist.pop(key) == expected, (key, json_hist[key], expected)
+
+    # JSON prints doubles with six decimals
+    for json_skew, bin_skew in zip(json_rec["coll_skew"], bin_rec["coll_skew"]):
+        assert abs(json_skew.pop("wasted_rank_s") - bin_skew.pop("wasted_rank_s")) < 1e-6
+
+    for key in sorted(set(json_rec) | set(bin_rec)):
+        assert json_rec.get(key) == bin_rec.get(key), (key, json_rec.get(key), bin_rec.get(key))
+
+    # stat_test recorded every part of the record
+    assert json_rec["callbacks"] and json_rec["counts"] and json_rec["pools"]
+    assert json_rec["coll_skew"] and json_rec["async"]["ops"]
+    print("%s and %s hold the same record" % (json_path, bin_path))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        sys.exit("usage: python stat_record_test.py RECORD.jsonl RECORD.bin")
+    main(sys.argv[1], sys.argv[2])
@@ -0,0 +1,190 @@
+import argparse
+import gzip
+import json
+import os
+import re
+import sys
+import uuid
+
+import rdflib
+
+import shards
+
+# Nodes created by alloc_proc_uuid/alloc_api_uuid, e.g. H5Dwrite--<uuid>
+UUID_NODE = re.compile(r"^(.*)--([0-9a-f]{8}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{12})$")
+RANK_NODE = re.compile(r"^(.*MPI_rank_)(\d+)$")
+RANK_VAR = "{rank}"
+ACTED_FOR = rdflib.URIRef("prov:actedOnBehalfOf")
+MEMBER_OF = rdflib.URIRef("prov:wasMemberOf")
+THREAD = rdflib.URIRef("provio:Thread")
+FORMAT_VERSION = 1
+
+
+def units(paths):
+    """One graph per rank: turtle files, or every shard of a shard repository"""
+    for path in paths:
+        if os.path.isdir(path):
+            for s, g in shards.iter_graphs(path, shards.read_manifest(path)):
+                yield os.path.join(path, s["shard"]), g
+        else:
+            g = rdflib.Graph()
+            g.parse(path, format="turtle")
+            yield path, g
+
+
+def rank_of(g):
+    """The rank owning the graph: the one the program acts on behalf of, or
+    the provio:Thread member without a program record. Dependency records
+    name other ranks too."""
+    owners = [o for o in g.objects(None, ACTED_FOR)]
+    if not any(RANK_NODE.match(str(o)) for o in owners):
+        owners = [s for s in g.subjects(MEMBER_OF, THREAD)]
+    ranks = {int(m.group(2)) for m in (RANK_NODE.match(str(n)) for n in owners
+                                       if isinstance(n, rdflib.URIRef)) if m}
+    if len(ranks) != 1:
+        return None
+    return ranks.pop()
+
+
+def canonical(g, rank):
+    """Split a rank's graph into its structure and its literal values.
+
+    UUID nodes are renamed by their position in the rank's own sequence
+    (the UUIDs are time based), the rank number becomes a variable and
+    literals become slots, so ranks doing the same thing get the same
+    structure."""
+    uuid_nodes = {}
+    for n in g.all_nodes():
+        m = UUID_NODE.match(str(n)) if isinstance(n, rdflib.URIRef) else None
+        if m:
+            uuid_nodes[n] = (m.group(1), uuid.UUID(m.group(2)))
+    order = sorted(uuid_nodes, key=lambda n: (uuid_nodes[n][1].time, uuid_nodes[n][0]))
+    names = {n: "%s--{%d}" % (uuid_nodes[n][0], i) for i, n in enumerate(order)}
+
+    def term(n):
+        if n in names:
+            return names[n]
+        m = RANK_NODE.match(str(n))
+        if m and int(m.group(2)) == rank:
+            return m.group(1) + RANK_VAR
+        return str(n)
+
+    rows = []
+    for s, p, o in g:
+        if isinstance(o, rdflib.Literal):
+            obj = [o.datatype and str(o.datatype), o.language]
+            rows.append(((term(s), str(p), obj), str(o)))
+        else:
+            rows.append(((term(s), str(p), term(o)), None))
+    rows.sort(key=lambda r: (json.dumps(r[0]), r[1] or ""))
+    return [r[0] for r in rows], [r[1] for r in rows if r[1] is not None]
+
+
+def rank_ranges(ranks):
+    out, i = [], 0
+    while i < len(ranks):
+        j = i
+        while j + 1 < len(ranks) and ranks[j + 1] == ranks[j] + 1:
+            j += 1
+        out.append(str(ranks[i]) if i == j else "%d-%d" % (ranks[i], ranks[j]))
+        i = j + 1
+    return ",".join(out)
+
+
+def parse_ranges(text):
+    ranks = []
+    for part in text.split(","):
+        lo, _, hi = part.partition("-")
+        ranks.extend(range(int(lo), int(hi or lo) + 1))
+    return ranks
+
+
+def compress(paths):
+    """Cluster ranks with identical structure, keep only the varying literals"""
+    clusters = {}
+    for path, g in units(paths):
+        rank = rank_of(g)
+        if rank is None:
+            sys.exit("%s: expected the graph of exactly one MPI rank" % path)
+        structure, values = canonical(g, rank)
+        clusters.setdefault(json.dumps(structure), (structure, []))[1].append((rank, values))
+
+    patterns = []
+    for structure, members in clusters.values():
+        members.sort()
+        columns = list(zip(*(values for _, values in members)))
+        slots, params = [], []
+        for col in columns:
+            if all(v == col[0] for v in col):
+                slots.append(col[0])
+            else:
+                slots.append(None)
+                params.append(list(col))
+        patterns.append({
+            "ranks": rank_ranges([rank for rank, _ in members]),
+            "triples": structure,
+            "slots": slots,
+            "params": params,
+        })
+    patterns.sort(key=lambda p: parse_ranges(p["ranks"])[0])
+    return {"version": FORMAT_VERSION, "patterns": patterns}
+
+
+def expand(doc, wanted=None):
+    """Rebuild the graph of every rank in wanted (all ranks if None).
+
+    UUID nodes get fresh name-based UUIDs, everything else is restored."""
+    for pattern in doc["patterns"]:
+        ranks = parse_ranges(pattern["ranks"])
+        for idx, rank in enumerate(ranks):
+            if wanted is not None and rank not in wanted:
+                continue
+            params = iter(col[idx] for col in pattern["params"])
+            values = [v if v is not None else next(params) for v in pattern["slots"]]
+
+            def node(text):
+                m = re.match(r"^(.*)--\{(\d+)\}$", text)
+                if m:
+                    text = "%s--%s" % (m.group(1), uuid.uuid5(uuid.NAMESPACE_URL, "%d/%s" % (rank, m.group(2))))
+                return rdflib.URIRef(text.replace(RANK_VAR, str(rank)))
+
+            g = rdflib.Graph()
+            literals = iter(values)
+            for s, p, o in pattern["triples"]:
+                if isinstance(o, list):
+                    datatype, lang = o
+                    obj = rdflib.Literal(next(literals), datatype=datatype and rdflib.URIRef(datatype), lang=lang)
+                else:
+                    obj = node(o)
+                g.add((node(s), rdflib.URIRef(p), obj))
+            yield rank, g
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Store near-identical per-rank PROV-IO graphs once per pattern")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    c = sub.add_parser("compress", help="cluster per-rank graphs")
+    c.add_argument("paths", nargs="+", help="per-rank turtle files or shard repositories")
+    c.add_argument("-o", "--out", default="prov.patterns.json.gz")
+    e = sub.add_parser("expand", help="rebuild per-rank graphs")
+    e.add_argument("patterns", help="output of compress")
+    e.add_argument("--ranks", help="ranks to expand, e.g. 0-3,8 (default: all)")
+    e.add_argument("-o", "--out", default=".", help="directory for the <prefix>.RANK-<n> files")
+    e.add_argument("--prefix", default="prov.turtle")
+    args = parser.parse_args()
+
+    if args.cmd == "compress":
+        doc = compress(args.paths)
+        with gzip.open(args.out, "wt") as f:
+            json.dump(doc, f, separators=(",", ":"))
+        ranks = sum(len(parse_ranges(p["ranks"])) for p in doc["patterns"])
+        print("%d ranks -> %d patterns, %d bytes" % (ranks, len(doc["patterns"]), os.path.getsize(args.out)))
+    else:
+        with gzip.open(args.patterns, "rt") as f:
+            doc = json.load(f)
+        if doc.get("version") != FORMAT_VERSION:
+            sys.exit("%s: unsupported version %s" % (args.patterns, doc.get("version")))
+        wanted = set(parse_ranges(args.ranks)) if args.ranks else None
+        os.makedirs(args.out, exist_ok=True)
+        for rank, g in expand(doc, wanted):
+            g.serialize(destination=os.path.join(args.out, "%s.RANK-%d" % (args.prefix, rank)), format="turtle")
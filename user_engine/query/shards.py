@@ -0,0 +1,80 @@
+import argparse
+import os
+import sys
+
+import rdflib
+
+MANIFEST = "MANIFEST"
+
+
+def read_manifest(repo):
+    """Return one entry per shard listed in <repo>/MANIFEST"""
+    shards = []
+    with open(os.path.join(repo, MANIFEST)) as f:
+        for line in f:
+            if line.startswith("#") or not line.strip():
+                continue
+            cols = line.rstrip("\n").split("\t")
+            shards.append({
+                "shard": cols[0],
+                "rank": int(cols[1]),
+                "start_us": int(cols[2]),
+                "end_us": int(cols[3]),
+                "triples": int(cols[4]),
+                "files": [f for f in cols[5].split(",") if f] if len(cols) > 5 else [],
+            })
+    return shards
+
+
+def select_shards(shards, since=None, until=None, file=None):
+    """Keep shards overlapping [since, until] (us) that touched file"""
+    for s in shards:
+        if since is not None and s["end_us"] < since:
+            continue
+        if until is not None and s["start_us"] > until:
+            continue
+        if file is not None and file not in s["files"]:
+            continue
+        yield s
+
+
+def iter_graphs(repo, shards):
+    """Parse shards one at a time, only when the caller asks for them"""
+    for s in shards:
+        g = rdflib.Graph()
+        g.parse(os.path.join(repo, s["shard"]), format="turtle")
+        yield s, g
+
+
+def load_graph(repo, since=None, until=None, file=None):
+    """Merge the selected shards into one graph"""
+    g = rdflib.Graph()
+    for s in select_shards(read_manifest(repo), since, until, file):
+        g.parse(os.path.join(repo, s["shard"]), format="turtle")
+    return g
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Query a PROV-IO shard repository")
+    parser.add_argument("repo", help="SHARD_REPO_PATH of the runs")
+    parser.add_argument("--since", type=int, help="only shards ending after this time (us since epoch)")
+    parser.add_argument("--until", type=int, help="only shards starting before this time (us since epoch)")
+    parser.add_argument("--file", help="only shards that touched this file")
+    parser.add_argument("--query", help="file holding a SPARQL query to run over the selected shards")
+    args = parser.parse_args()
+
+    selected = list(select_shards(read_manifest(args.repo), args.since, args.until, args.file))
+
+    if not args.query:
+        for s in selected:
+            print("%s rank %d [%d, %d] %d triples %s" % (s["shard"], s["rank"],
+                s["start_us"], s["end_us"], s["triples"], ",".join(s["files"])))
+        sys.exit(0)
+
+    with open(args.query) as f:
+        query = f.read()
+    g = rdflib.Graph()
+    for s, shard in iter_graphs(args.repo, selected):
+        g += shard
+    for row in g.query(query):
+        print(" ".join(str(v) for v in row))
@@ -0,0 +1,69 @@
+import argparse
+import os
+
+import rdflib
+
+import shards
+
+STARTED_AT = rdflib.URIRef("provio:startedAt")
+ELAPSED = rdflib.URIRef("provio:elapsed")
+ASSOCIATED_WITH = rdflib.URIRef("prov:wasAssociatedWith")
+ACTED_FOR = rdflib.URIRef("prov:actedOnBehalfOf")
+CLOCK_OFFSET = rdflib.URIRef("provio:clockOffset")
+CLOCK_DRIFT = rdflib.URIRef("provio:clockDrift")
+CLOCK_SYNC_TIME = rdflib.URIRef("provio:clockSyncTime")
+NOT_OBJECT_RELATIONS = {ASSOCIATED_WITH, ACTED_FOR}
+
+
+def load(paths):
+    """Parse turtle files, a directory is read as a shard repository"""
+    g = rdflib.Graph()
+    for path in paths:
+        if os.path.isdir(path):
+            for s, shard in shards.iter_graphs(path, shards.read_manifest(path)):
+                g += shard
+        else:
+            g.parse(path, format="turtle")
+    return g
+
+
+def clocks(g):
+    """Clock offset/drift recorded by each program (ENABLE_CLOCK_SYNC=T)"""
+    out = {}
+    for prog, offset in g.subject_objects(CLOCK_OFFSET):
+        out[prog] = (int(offset),
+                     float(g.value(prog, CLOCK_DRIFT, default=0)),
+                     int(g.value(prog, CLOCK_SYNC_TIME, default=0)))
+    return out
+
+
+def timeline(g):
+    """One entry per I/O API, ordered on rank 0's clock"""
+    progs = clocks(g)
+    events = []
+    for api, started in g.subject_objects(STARTED_AT):
+        t = int(started)
+        prog = g.value(api, ASSOCIATED_WITH)
+        # Timestamps were written with the start-up offset, correct for the
+        # drift measured over the whole run
+        if prog in progs:
+            offset, drift, sync_time = progs[prog]
+            t += int(drift * (t - offset - sync_time))
+        rank = g.value(prog, ACTED_FOR) if prog is not None else None
+        objs = [str(s) for s, p in g.subject_predicates(api) if p not in NOT_OBJECT_RELATIONS]
+        events.append((t, str(rank) if rank is not None else "-",
+                       str(api).split("--")[0], ",".join(objs) or "-",
+                       str(g.value(api, ELAPSED, default="-"))))
+    events.sort()
+    return events
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Globally ordered I/O timeline of PROV-IO graphs")
+    parser.add_argument("paths", nargs="+", help="turtle files or shard repositories")
+    args = parser.parse_args()
+
+    events = timeline(load(args.paths))
+    t0 = events[0][0] if events else 0
+    for t, rank, api, objs, elapsed in events:
+        print("%12d us %-14s %-16s %s (%s us)" % (t - t0, rank, api, objs, elapsed))